@@ -10,6 +10,8 @@ for /f %%i in ('powershell -command "[Environment]::TickCount"') do set START_TI
 set BUILD_DIR=build
 set EDITOR_MODE_FLAG=0
 set DEMO_FLAG=0
+set BENCHMARK_FLAG=0
+set STATS_FLAG=0
 set PACKAGE_FILES=0
 set DEBUG_SET=0
 
@@ -32,6 +34,10 @@ for %%a in (%*) do (
         set PACKAGE_FILES=1
     ) else if "%%a"=="/demo" (
         set DEMO_FLAG=1
+    ) else if "%%a"=="/benchmark" (
+        set BENCHMARK_FLAG=1
+    ) else if "%%a"=="/stats" (
+        set STATS_FLAG=1
     )
 )
 
@@ -43,6 +49,14 @@ if %DEMO_FLAG%==1 (
     set COMPILER_FLAGS=%COMPILER_FLAGS% /D DEMO
 )
 
+if %BENCHMARK_FLAG%==1 (
+    set COMPILER_FLAGS=%COMPILER_FLAGS% /D SVO_BENCHMARK
+)
+
+if %STATS_FLAG%==1 (
+    set COMPILER_FLAGS=%COMPILER_FLAGS% /D SVO_TRAVERSAL_STATS
+)
+
 if not exist "%BUILD_DIR%" mkdir "%BUILD_DIR%"
 
 cl %COMPILER_FLAGS% /I "include" /Fd:%BUILD_DIR%/ /Fo:%BUILD_DIR%/ /Fe:"%OUTPUT_NAME%" ^
@@ -0,0 +1,23 @@
+#!/bin/sh
+# Builds svo_export, the headless mesh exporter, on Linux. See readme.md.
+#   ./build_export.sh [debug] [benchmark]
+
+COMPILER_FLAGS="-O2 -g"
+OUTPUT_NAME=svo_export
+
+for arg in "$@"; do
+    case "$arg" in
+        debug)     COMPILER_FLAGS="-O0 -g -D_DEBUG"; echo "Using DEBUG build" ;;
+        benchmark) COMPILER_FLAGS="$COMPILER_FLAGS -DSVO_BENCHMARK" ;;
+    esac
+done
+
+START_TIME=$(date +%s%N)
+
+${CXX:-g++} -std=c++14 $COMPILER_FLAGS -msse4.1 -pthread -Iinclude -o "$OUTPUT_NAME" src/linux_export_main.cpp || {
+    echo "Compilation failed!"
+    exit 1
+}
+
+END_TIME=$(date +%s%N)
+echo "Build complete! Build time: $(( (END_TIME - START_TIME) / 1000000 )) ms"
@@ -50,11 +50,19 @@ bool GetAppDataFolder(char* directory);
 void GetAssetDirectory(String* directory);
 
 bool RemoveFile(const char* file);
+// The handle is -1 (INVALID_HANDLE_VALUE on Windows) if the file cannot be opened; callers check it.
 File FileOpen(const char* filePath, FileMode mode);
 void FileClose(File& file);
 u64 FileWrite(File& file, void* buffer, u64 size);
 //TODO(roger): Add FileRead API and remove the rest of fopen in codebase.
 
+// Space for size bytes, at most WriteBufferSize, at the end of the write buffer, written out with it. Lets callers
+// encode straight into the buffer instead of into a copy for FileWrite().
+u8* FileReserve(File& file, u32 size);
+
+// Gives back the last size bytes of the last FileReserve() when less of it was used.
+void FileUnreserve(File& file, u32 size);
+
 struct MemoryBuffer {
     char* buffer;
     size_t size;
@@ -1,6 +1,12 @@
 #include "input_common.h"
 
 #include "svo.cpp"
+#include "svo_mesh.cpp"
+#include "svo_instances.cpp"
+#include "svo_export.cpp"
+#ifdef SVO_BENCHMARK
+    #include "svo_benchmark.cpp"
+#endif
 #include "input_common.cpp"
 #include "camera.cpp"
 
@@ -12,21 +18,46 @@ void InitGame(const char* svoFilePath) {
     
     CreateConstantBuffer(0, &game.gameConstantBuffer, sizeof(Matrix4));
     CreateConstantBuffer(1, &game.frameConstantBuffer, sizeof(Matrix4));
+    CreateConstantBuffer(2, &game.meshConstantBuffer, sizeof(Vector4));
     
     Vector2 clientSize = GetClientSize();
     float aspect = clientSize.x / clientSize.y;
-    Matrix4 projection = PerspectiveLH(aspect, DegreesToRadians(90), 0.001f, 100.0f);
-    UpdateConstantBuffer(&game.gameConstantBuffer, &projection, sizeof(Matrix4));
+    game.projection = PerspectiveLH(aspect, DegreesToRadians(90), 0.001f, 100.0f);
+    UpdateConstantBuffer(&game.gameConstantBuffer, &game.projection, sizeof(Matrix4));
 
     game.simpleShader = LoadShader("data/shaders/dx11/simple.fxh", VertexLayout_XYZ);
-    game.simpleLightShader = LoadShader("data/shaders/dx11/simple_light.fxh", VertexLayout_XYZ_NORMAL);
+    game.voxelShader = LoadShader("data/shaders/dx11/voxel.fxh", VertexLayout_VOXEL);
+    game.voxelInstanceShader = LoadShader("data/shaders/dx11/voxel_instance.fxh", VertexLayout_VOXEL_INSTANCE);
+    game.voxelSharedShader = LoadShader("data/shaders/dx11/voxel_shared.fxh", VertexLayout_VOXEL_SHARED);
 
     {
         PipelineState* pipeline = &game.meshPipeline;
         pipeline->topology = PrimitiveTopology_TriangleList;
-        pipeline->vertexLayout = VertexLayout_XYZ_NORMAL;
+        pipeline->vertexLayout = VertexLayout_VOXEL;
         pipeline->rasterizer = Rasterizer_Default;
-        pipeline->shader = &game.simpleLightShader;
+        pipeline->shader = &game.voxelShader;
+        pipeline->blendDesc.enableBlend = false;
+        pipeline->stencilMode = StencilMode_None;
+        CreatePipelineState(pipeline);
+    }
+    
+    {
+        PipelineState* pipeline = &game.sharedMeshPipeline;
+        pipeline->topology = PrimitiveTopology_TriangleList;
+        pipeline->vertexLayout = VertexLayout_VOXEL_SHARED;
+        pipeline->rasterizer = Rasterizer_Default;
+        pipeline->shader = &game.voxelSharedShader;
+        pipeline->blendDesc.enableBlend = false;
+        pipeline->stencilMode = StencilMode_None;
+        CreatePipelineState(pipeline);
+    }
+    
+    {
+        PipelineState* pipeline = &game.instancePipeline;
+        pipeline->topology = PrimitiveTopology_TriangleList;
+        pipeline->vertexLayout = VertexLayout_VOXEL_INSTANCE;
+        pipeline->rasterizer = Rasterizer_Default;
+        pipeline->shader = &game.voxelInstanceShader;
         pipeline->blendDesc.enableBlend = false;
         pipeline->stencilMode = StencilMode_None;
         CreatePipelineState(pipeline);
@@ -47,17 +78,57 @@ void InitGame(const char* svoFilePath) {
     game.gizmoVertices = ALLOC_ARRAY(ArenaAllocator, Vertex_XYZ, GIZMO_VERTEX_COUNT);
     game.gizmoIndices = ALLOC_ARRAY(ArenaAllocator, u32, GIZMO_INDEX_COUNT);
     
-    game.svo = LoadSvo(svoFilePath, ArenaAlloc);
+    // NOTE(roger): Heap allocated since editing voxels grows the node arrays.
+    game.svo = LoadSvo(svoFilePath, HeapAlloc);
     
     // TODO(roger): Use StaticDraw instead.
-    InitializeGpuBuffer(&game.vertexBuffer, 5120000, sizeof(Vertex_XYZ_N), VertexBuffer, DynamicDraw);
-    InitializeIndexBuffer(&game.indexBuffer, 10240000, IndexFormat_U32, DynamicDraw);
+    // NOTE(roger): Recreated with the exact mesh size plus room for edits by PackSvoMesh().
+    SvoGpuMesh* gpuMeshes[] = { &game.gpuMesh, &game.backGpuMesh };
+    for (u32 i = 0; i < countOf(gpuMeshes); i++) {
+        InitializeGpuBuffer(&gpuMeshes[i]->vertexBuffer, SVO_MESH_MIN_GPU_CAPACITY, sizeof(Vertex_Voxel), VertexBuffer, DynamicDraw);
+        InitializeIndexBuffer(&gpuMeshes[i]->shortIndexBuffer, SVO_MESH_MIN_GPU_CAPACITY, IndexFormat_U16, DynamicDraw);
+        InitializeIndexBuffer(&gpuMeshes[i]->indexBuffer, SVO_MESH_MIN_GPU_CAPACITY, IndexFormat_U32, DynamicDraw);
+    }
+    InitializeGpuBuffer(&game.instanceBuffer, SVO_MESH_MIN_GPU_CAPACITY, sizeof(Instance_Voxel), VertexBuffer, DynamicDraw);
+    InitializeGpuBuffer(&game.backInstanceBuffer, SVO_MESH_MIN_GPU_CAPACITY, sizeof(Instance_Voxel), VertexBuffer, DynamicDraw);
+    InitializeGpuBuffer(&game.offsetBuffer, SVO_MESH_MIN_GPU_CAPACITY, sizeof(Instance_Offset), VertexBuffer, DynamicDraw);
     
     InitializeGpuBuffer(&game.gizmoVertexBuffer, GIZMO_VERTEX_COUNT, sizeof(Vertex_XYZ), VertexBuffer, DynamicDraw);
     InitializeIndexBuffer(&game.gizmoIndexBuffer, GIZMO_INDEX_COUNT, IndexFormat_U32, DynamicDraw);
     
     int lvl = 9;
-    PackSvoMesh(&game.svo, lvl);
+    InitSvoChunkGrid(&game.chunkGrid, lvl, SVO_MESH_CHUNK_SHIFT, SVO_MESH_MAX_LODS, 8.0f, ArenaAllocator);
+    InitSvoGameSettings(&game.chunkGrid);
+    game.lodEnabled = true;
+    game.lodDistance = 2.0f;
+    game.triangleBudget = 2000000;
+    game.cullMode = SvoCull_Clusters;
+    UpdateSvoMeshConstants(&game.chunkGrid);
+    PackSvoMesh(&game.svo, &game.chunkGrid);
+    game.nextMesher = game.chunkGrid.mesher;
+    game.nextAmbientOcclusion = game.chunkGrid.ambientOcclusion;
+    game.nextShareRepeats = game.chunkGrid.shareRepeats;
+    game.nextExterior = false;
+    
+#ifdef SVO_BENCHMARK
+    PrintSvoMeshStats(lvl, &game.meshStats, game.meshTime);
+    BenchmarkSvoMeshThreads(&game.svo, 8.0f, lvl, &game.meshStats);
+    BenchmarkSvoSharedVertices(&game.svo, 8.0f, lvl);
+    BenchmarkSvoLods(&game.svo, 8.0f, lvl, game.lodDistance);
+    BenchmarkSvoSurfaceNets(&game.svo, 8.0f, lvl);
+    BenchmarkSvoAmbientOcclusion(&game.svo, 8.0f, lvl);
+    BenchmarkSvoVertexCache(&game.svo, 8.0f, lvl);
+    BenchmarkSvoExterior(&game.svo, 8.0f, lvl);
+    BenchmarkSvoSolidSubtrees(&game.svo, 8.0f, lvl);
+    BenchmarkSvoExport(&game.svo, 8.0f, lvl);
+    BenchmarkSvoClusters(&game.svo, 8.0f, lvl, game.lodDistance);
+    BenchmarkSvoInstances(&game.svo, 8.0f, lvl);
+    BenchmarkSvoRepeats(&game.svo, 8.0f, lvl);
+    BenchmarkSvoFaceMasks(&game.svo, lvl);
+    BenchmarkSvoEdits(&game.svo, 8.0f, lvl);
+    BenchmarkSvoBackgroundRemesh(&game.svo, 8.0f, lvl);
+    RunSvoBenchmarks(&game.svo, 8.0f, lvl);
+#endif
 }
 
 void TickGame() {
@@ -81,17 +152,69 @@ void TickGame() {
         game.hide_model = !game.hide_model;        
     }
     
+    if (IsInputPressed(KEY_L)) {
+        game.lodEnabled = !game.lodEnabled;
+    }
+    
+    if (IsInputPressed(KEY_K)) {
+        game.cullMode = (SvoCullMode)((game.cullMode + 1) % SvoCull_Count);
+        const char* modeNames[] = { "off", "direction buckets", "direction buckets and clusters" };
+        LOG_MESSAGE("Culling %s.\n", modeNames[game.cullMode]);
+    }
+    
+    if (IsInputPressed(KEY_N)) {
+        game.nextMesher = (game.nextMesher == SvoMesher_Cubes) ? SvoMesher_SurfaceNets : SvoMesher_Cubes;
+        QueueSvoRepack();
+    }
+    
+    if (IsInputPressed(KEY_O)) {
+        game.nextAmbientOcclusion = !game.nextAmbientOcclusion;
+        QueueSvoRepack();
+    }
+    
+    if (IsInputPressed(KEY_P)) {
+        game.nextShareRepeats = !game.nextShareRepeats;
+        QueueSvoRepack();
+    }
+    
+    if (IsInputPressed(KEY_I)) {
+        game.instanced = !game.instanced;
+        if (!game.instanced) {
+            game.instancesQueued = false;
+            LOG_MESSAGE("Drawing the chunk meshes.\n");
+        } else {
+            // Built by the next remesh like after an edit, the chunk meshes are drawn until they are uploaded.
+            game.instancesQueued = true;
+        }
+    }
+    
+    if (IsInputPressed(KEY_X)) {
+        game.nextExterior = !game.nextExterior;
+        QueueSvoRepack();
+    }
+    
+    if (game.lodEnabled) {
+        SelectSvoChunkLods(&game.chunkGrid, game.camera.position, game.lodDistance, game.triangleBudget);
+    }
+    
+    float cy = cosf(game.camera.yaw);
+    float sy = sinf(game.camera.yaw);
+    float cp = cosf(game.camera.pitch);
+    float sp = sinf(game.camera.pitch);
+    Vector3 forward = Normalize(Vector3{sy * cp, sp, cy * cp}) * 12.0f;
+    
     if (IsInputPressed(KEY_R)) {
-        float cy = cosf(game.camera.yaw);
-        float sy = sinf(game.camera.yaw);
-        float cp = cosf(game.camera.pitch);
-        float sp = sinf(game.camera.pitch);
-        Vector3 forward = Normalize(Vector3{sy * cp, sp, cy * cp});
-        
-        forward *= 12.0f;
         RaycastSvo(&game.svo, 8.0f, game.camera.position, forward, 8);
     }
     
+    if (IsInputPressed(KEY_F)) {
+        QueueSvoEdit(game.camera.position, forward, false);
+    }
+    
+    if (IsInputPressed(KEY_G)) {
+        QueueSvoEdit(game.camera.position, forward, true);
+    }
+    
     if (IsInputPressed(KEY_C)) {
         game.gizmoVertexCount = 0;
         game.gizmoIndexCount  = 0;
@@ -101,25 +224,95 @@ void TickGame() {
         QuitGame();
     }
     
+    // Between two frames: the GPU buffers and the chunk ranges change together or not at all.
+    UpdateSvoRemesh();
+    
     // TODO(roger): Rename to BeginFrame()
     NewFrame();
     
     BeginDrawing();
     
         ClearBackground(Vector4{0.1f, 0.1f, 0.1f, 1.0f});
-        ConstantBuffer* constantBuffers[2] = {
+        ConstantBuffer* constantBuffers[3] = {
             &game.gameConstantBuffer,        
             &game.frameConstantBuffer,        
+            &game.meshConstantBuffer,        
         };
         BindConstantBuffers(0, constantBuffers, countOf(constantBuffers));
         
         // Draw Voxels
-        if (!game.hide_model) {
-            GpuBuffer* vertexBuffers[] = { &game.vertexBuffer };
-            SetPipelineState(&game.meshPipeline);
+        if (!game.hide_model && game.instanced && game.instancesCurrent) {
+            GpuBuffer* vertexBuffers[] = { &game.instanceBuffer };
+            SetPipelineState(&game.instancePipeline);
             BindVertexBuffers(vertexBuffers, countOf(vertexBuffers));
-            BindIndexBuffer(&game.indexBuffer);
-            DrawIndexedVertices(game.indexBuffer.count, 0, 0);
+            
+            TempArenaMemory tempArena = TempArenaMemoryBegin(&tempAllocator);
+            SvoInstanceRange* ranges = ALLOC_ARRAY(TempAllocator, SvoInstanceRange, game.instances.clusterCount);
+            SvoFrustum frustum = SvoFrustumFromMatrix(view * game.projection);
+            u32 rangeCount = CullSvoInstances(&game.instances, game.camera.position, &frustum, ranges, &game.instanceCullStats);
+            for (u32 i = 0; i < rangeCount; i++) {
+                DrawInstancedVertices(SVO_INSTANCE_CUBE_VERTICES, ranges[i].instanceCount, ranges[i].firstInstance);
+            }
+            TempArenaMemoryEnd(tempArena);
+        } else if (!game.hide_model) {
+            // Every chunk has its own range in the buffers, with indices relative to its first vertex.
+            // Most chunks have u16 indices, the few that have too many vertices are drawn with the u32 buffer.
+            // NOTE(roger): Every cluster in the buffers is an upper bound for the ranges of the drawn ones. Shared
+            // meshes are culled once per chunk though, so then it is the clusters of every chunk LOD.
+            TempArenaMemory tempArena = TempArenaMemoryBegin(&tempAllocator);
+            u32 rangeCapacity = game.gpuMesh.clusterCount;
+            if (game.chunkGrid.shareRepeats) {
+                rangeCapacity = 0;
+                for (u32 i = 0; i < game.chunkGrid.chunkCount * game.chunkGrid.lodCount; i++) {
+                    rangeCapacity += game.chunkGrid.chunks[i / game.chunkGrid.lodCount].lods[i % game.chunkGrid.lodCount].clusterCount;
+                }
+            }
+            SvoDrawRange* ranges = ALLOC_ARRAY(TempAllocator, SvoDrawRange, rangeCapacity);
+            SvoFrustum frustum = SvoFrustumFromMatrix(view * game.projection);
+            u32 rangeCount = CullSvoClusters(&game.chunkGrid, game.gpuMesh.clusters, game.lodEnabled, game.cullMode, game.camera.position, 
+                                             &frustum, ranges, &game.cullStats);
+            
+            GpuBuffer* indexBuffers[] = { &game.gpuMesh.shortIndexBuffer, &game.gpuMesh.indexBuffer };
+            if (game.chunkGrid.shareRepeats) {
+                // Shared meshes are drawn once per batch, with the origin of every chunk that kept the range as an instance.
+                SvoDrawBatch* batches = ALLOC_ARRAY(TempAllocator, SvoDrawBatch, rangeCount);
+                Instance_Offset* origins = ALLOC_ARRAY(TempAllocator, Instance_Offset, rangeCount);
+                u32 batchCount = BatchSvoDrawRanges(&game.chunkGrid, ranges, rangeCount, batches, origins);
+                
+                // AppendData() needs room for one more.
+                ReserveSvoGpuBuffer(&game.offsetBuffer, rangeCount + 1);
+                MapBuffer(&game.offsetBuffer, true);
+                    AppendData(&game.offsetBuffer, origins, rangeCount);
+                UnmapBuffer(&game.offsetBuffer);
+                
+                GpuBuffer* sharedBuffers[] = { &game.gpuMesh.vertexBuffer, &game.offsetBuffer };
+                SetPipelineState(&game.sharedMeshPipeline);
+                BindVertexBuffers(sharedBuffers, countOf(sharedBuffers));
+                for (u32 b = 0; b < countOf(indexBuffers); b++) {
+                    BindIndexBuffer(indexBuffers[b]);
+                    for (u32 i = 0; i < batchCount; i++) {
+                        SvoDrawRange* range = &batches[i].range;
+                        if (range->indexFormat == indexBuffers[b]->indexFormat) {
+                            DrawIndexedInstancedVertices(range->indexCount, batches[i].instanceCount, range->firstIndex, range->firstVertex, 
+                                                         batches[i].firstInstance);
+                        }
+                    }
+                }
+                game.cullStats.drawCount = batchCount;
+            } else {
+                GpuBuffer* vertexBuffers[] = { &game.gpuMesh.vertexBuffer };
+                SetPipelineState(&game.meshPipeline);
+                BindVertexBuffers(vertexBuffers, countOf(vertexBuffers));
+                for (u32 b = 0; b < countOf(indexBuffers); b++) {
+                    BindIndexBuffer(indexBuffers[b]);
+                    for (u32 i = 0; i < rangeCount; i++) {
+                        if (ranges[i].indexFormat == indexBuffers[b]->indexFormat) {
+                            DrawIndexedVertices(ranges[i].indexCount, ranges[i].firstIndex, ranges[i].firstVertex);
+                        }
+                    }
+                }
+            }
+            TempArenaMemoryEnd(tempArena);
         }
         
         // Draw Gizmos
@@ -145,6 +338,20 @@ void TickGame() {
     // TODO(roger): Rename to EndFrame()
     GraphicsPresent();
     
+    // Once a second at the fixed 60 FPS.
+    game.frameCount++;
+    if (game.instanced && game.instancesCurrent && !game.hide_model && game.frameCount % 60 == 0) {
+        SvoInstanceCullStats* stats = &game.instanceCullStats;
+        LOG_MESSAGE("Culled %u of %u instances: %u outside the frustum, %u facing away. %u instances with %u faces left in %u draws.\n",
+                    stats->frustumInstances + stats->backfaceInstances, stats->instanceCount, stats->frustumInstances, 
+                    stats->backfaceInstances, stats->drawnInstanceCount, stats->drawnFaceCount, stats->drawCount);
+    } else if (game.cullMode != SvoCull_None && !game.hide_model && game.frameCount % 60 == 0) {
+        SvoCullStats* stats = &game.cullStats;
+        LOG_MESSAGE("Culled %u of %u triangles: %u in direction buckets, %u outside the frustum, %u facing away. %u clusters left in %u draws.\n",
+                    stats->directionTriangles + stats->frustumTriangles + stats->backfaceTriangles, stats->triangleCount, 
+                    stats->directionTriangles, stats->frustumTriangles, stats->backfaceTriangles, stats->drawnClusterCount, stats->drawCount);
+    }
+    
     if (isWindowActive) {
         HideOsCursor();
         CenterCursorInWindow();
@@ -154,350 +361,355 @@ void TickGame() {
     FlushInput();
 }
 
-void PackSvoMesh(SvoImport* svo, int lvl) {
-    TempArenaMemory tempArena = TempArenaMemoryBegin(&tempAllocator);
-
-    MapBuffer(&game.vertexBuffer, true);
-    MapBuffer(&game.indexBuffer, true);
-        
-        Vector3Int** coordsAtLevel = ALLOC_ARRAY(TempAllocator, Vector3Int*, svo->topLevel + 1);
-        coordsAtLevel[0] = ALLOC_ARRAY(TempAllocator, Vector3Int, 1);
-        coordsAtLevel[0][0] = { 0, 0, 0 };
-
-        for (int i = 0; i < lvl; i++) {
-            int parentCount = svo->nodesAtLevel[i]; 
-            int childCount  = svo->nodesAtLevel[i + 1];
-            coordsAtLevel[i + 1] = ALLOC_ARRAY(TempAllocator, Vector3Int, childCount);
-            
-            u32 w = 0;
-            
-            for (int p = 0; p < parentCount; p++) {
-                Vector3Int pc = coordsAtLevel[i][p];
-                u8 parentMask = svo->masksAtLevel[i][p];
-                
-                for (int child = 0; child < 8; child++) {
-                    if (parentMask & (1u << child)) {
-                        int xb = child & 1;
-                        int yb = (child >> 1) & 1;
-                        int zb = (child >> 2) & 1;
-                        
-                        coordsAtLevel[i + 1][w++] = { pc.x * 2 + xb, 
-                                                      pc.y * 2 + yb, 
-                                                      pc.z * 2 + zb };
-                    }
-                }    
-            }
-        }
-        
-        // Compute first child for each level + parent index for faster IsFilled check.
-        
-        svo->firstChild = ALLOC_ARRAY(ArenaAllocator, u32*, lvl);
-        for (int i = 0; i < lvl; ++i) {
-            u32 parentCount = svo->nodesAtLevel[i];
-            svo->firstChild[i] = ALLOC_ARRAY(ArenaAllocator, u32, parentCount);
-            
-            u32 run = 0;
-            for (u32 p = 0; p < parentCount; ++p) {
-                svo->firstChild[i][p] = run;
-                run += Popcount8(svo->masksAtLevel[i][p]);
-            }
-            
-            ASSERT_ERROR(run == svo->nodesAtLevel[i + 1], "child count mismatch!"); 
-        }
-        
-        // Greedy Mesher
-        
-        float rootSize = 8.0f;
-        float s = rootSize / (1 << lvl);
-        
-        for (int i = 0; i < svo->nodesAtLevel[lvl]; ++i) {
-            Vector3Int c = coordsAtLevel[lvl][i];
-            
-            float x = c.x * s;
-            float y = c.y * s;
-            float z = c.z * s;
-            
-            if (!IsFilled(svo, lvl, Vector3Int{c.x + 1, c.y, c.z})) { 
-                Vertex_XYZ_N verts[] = {
-                    {s + x, y,     z,     1, 0, 0},
-                    {s + x, s + y, z,     1, 0, 0},
-                    {s + x, s + y, s + z, 1, 0, 0},
-                    {s + x, y,     s + z, 1, 0, 0},
-                };
-                u32 indices[] = { 0 + game.vertexBuffer.count, 1 + game.vertexBuffer.count, 2 + game.vertexBuffer.count, 2 + game.vertexBuffer.count, 3 + game.vertexBuffer.count, 0 + game.vertexBuffer.count };
-                
-                AppendData(&game.vertexBuffer, verts, countOf(verts));
-                AppendData(&game.indexBuffer, indices, countOf(indices));
-            }
-            
-            if (!IsFilled(svo, lvl, Vector3Int{c.x - 1, c.y, c.z})) { 
-                Vertex_XYZ_N verts[] = {
-                    {x, y,     z,     -1, 0, 0},
-                    {x, s + y, z,     -1, 0, 0},
-                    {x, s + y, s + z, -1, 0, 0},
-                    {x, y,     s + z, -1, 0, 0},
-                };
-                u32 indices[] = { 2 + game.vertexBuffer.count, 1 + game.vertexBuffer.count, 0 + game.vertexBuffer.count, 0 + game.vertexBuffer.count, 3 + game.vertexBuffer.count, 2 + game.vertexBuffer.count };
-                
-                AppendData(&game.vertexBuffer, verts, countOf(verts));
-                AppendData(&game.indexBuffer, indices, countOf(indices));
-            }
-            
-            if (!IsFilled(svo, lvl, Vector3Int{c.x, c.y + 1, c.z})) {
-                Vertex_XYZ_N verts[] = {
-                    {x,     s + y, z,     0, 1, 0},
-                    {x,     s + y, s + z, 0, 1, 0},
-                    {s + x, s + y, s + z, 0, 1, 0},
-                    {s + x, s + y, z,     0, 1, 0},
-                };
-                u32 indices[] = { 0 + game.vertexBuffer.count, 1 + game.vertexBuffer.count, 2 + game.vertexBuffer.count, 2 + game.vertexBuffer.count, 3 + game.vertexBuffer.count, 0 + game.vertexBuffer.count };
-                
-                AppendData(&game.vertexBuffer, verts, countOf(verts));
-                AppendData(&game.indexBuffer, indices, countOf(indices));
-            }
-            
-            if (!IsFilled(svo, lvl, Vector3Int{c.x, c.y - 1, c.z})) { 
-                Vertex_XYZ_N verts[] = {
-                    {x,     y, z,     0, -1, 0},
-                    {x,     y, s + z, 0, -1, 0},
-                    {s + x, y, s + z, 0, -1, 0},
-                    {s + x, y, z,     0, -1, 0},
-                };
-                u32 indices[] = { 0 + game.vertexBuffer.count, 3 + game.vertexBuffer.count, 2 + game.vertexBuffer.count, 2 + game.vertexBuffer.count, 1 + game.vertexBuffer.count, 0 + game.vertexBuffer.count };
-                
-                AppendData(&game.vertexBuffer, verts, countOf(verts));
-                AppendData(&game.indexBuffer, indices, countOf(indices));
-            }
-            
-            if (!IsFilled(svo, lvl, Vector3Int{c.x, c.y, c.z + 1})) { 
-                Vertex_XYZ_N verts[] = {
-                    {x,     y,     s + z, 0, 0, 1},
-                    {x,     s + y, s + z, 0, 0, 1},
-                    {s + x, s + y, s + z, 0, 0, 1},
-                    {s + x, y,     s + z, 0, 0, 1},
-                };
-                u32 indices[] = { 0 + game.vertexBuffer.count, 3 + game.vertexBuffer.count, 2 + game.vertexBuffer.count, 2 + game.vertexBuffer.count, 1 + game.vertexBuffer.count, 0 + game.vertexBuffer.count };
-                
-                AppendData(&game.vertexBuffer, verts, countOf(verts));
-                AppendData(&game.indexBuffer, indices, countOf(indices));
-            }
-            
-            if (!IsFilled(svo, lvl, Vector3Int{c.x, c.y, c.z - 1})) { 
-                Vertex_XYZ_N verts[] = {
-                    {x,     y,     z, 0, 0, -1},
-                    {x,     s + y, z, 0, 0, -1},
-                    {s + x, s + y, z, 0, 0, -1},
-                    {s + x, y,     z, 0, 0, -1},
-                };
-                u32 indices[] = { 0 + game.vertexBuffer.count, 1 + game.vertexBuffer.count, 2 + game.vertexBuffer.count, 2 + game.vertexBuffer.count, 3 + game.vertexBuffer.count, 0 + game.vertexBuffer.count };
-                
-                AppendData(&game.vertexBuffer, verts, countOf(verts));
-                AppendData(&game.indexBuffer, indices, countOf(indices));
-            }
-        }
-        
-    UnmapBuffer(&game.indexBuffer);
-    UnmapBuffer(&game.vertexBuffer);
-    
-    TempArenaMemoryEnd(tempArena);
+// The voxel shader decodes the positions of cubes in voxels and those of surface nets in fixed point.
+void UpdateSvoMeshConstants(SvoChunkGrid* grid) {
+    Vector4 voxelScale = { SvoMeshUnit(grid), (grid->mesher == SvoMesher_SurfaceNets) ? 1.0f : 0.0f, grid->rootScale / (1 << grid->lvl), 0 };
+    UpdateConstantBuffer(&game.meshConstantBuffer, &voxelScale, sizeof(Vector4));
 }
 
-struct SvoStackEntry {
-    Vector3 corner;
-    int mask_idx;
-    s8 idx;
-};
+// NOTE(roger): MapBuffer resets the counts, so they are carried over in the SvoMeshBuffer.
+void MapSvoMeshBuffers(SvoGpuMesh* gpuMesh, SvoMeshBuffer* mesh, bool writeDiscard) {
+    mesh->vertexCount = writeDiscard ? 0 : gpuMesh->vertexBuffer.count;
+    mesh->indexCount = writeDiscard ? 0 : gpuMesh->indexBuffer.count;
+    mesh->shortIndexCount = writeDiscard ? 0 : gpuMesh->shortIndexBuffer.count;
+    mesh->clusterCount = writeDiscard ? 0 : gpuMesh->clusterCount;
+    
+    MapBuffer(&gpuMesh->vertexBuffer, writeDiscard);
+    MapBuffer(&gpuMesh->indexBuffer, writeDiscard);
+    MapBuffer(&gpuMesh->shortIndexBuffer, writeDiscard);
+    
+    mesh->vertices = (Vertex_Voxel*)gpuMesh->vertexBuffer.mapped;
+    mesh->indices = (u32*)gpuMesh->indexBuffer.mapped;
+    mesh->shortIndices = (u16*)gpuMesh->shortIndexBuffer.mapped;
+    mesh->vertexCapacity = gpuMesh->vertexBuffer.capacity;
+    mesh->indexCapacity = gpuMesh->indexBuffer.capacity;
+    mesh->shortIndexCapacity = gpuMesh->shortIndexBuffer.capacity;
+    mesh->clusters = gpuMesh->clusters;
+    mesh->clusterCapacity = gpuMesh->clusterCapacity;
+}
 
-void RaycastSvo(SvoImport* svo, float rootScale, Vector3 rayStart, Vector3 rayDirection, int maxDepth) {
-    TempArenaMemory tempArena = TempArenaMemoryBegin(&tempAllocator);
-    
-    Vector3 v0 = {0, 0, 0};
-    Vector3 v1 = {rootScale, rootScale, rootScale};
-    
-    DrawLine(rayStart, rayStart + rayDirection);
-    
-    Vector3Int stepDir;
-    stepDir.x = (rayDirection.x > 0) ? 1 : ((rayDirection.x < 0) ? -1 : 0);
-    stepDir.y = (rayDirection.y > 0) ? 1 : ((rayDirection.y < 0) ? -1 : 0);
-    stepDir.z = (rayDirection.z > 0) ? 1 : ((rayDirection.z < 0) ? -1 : 0);
-    
-    if (Abs(rayDirection.x) < EPSILON) { rayDirection.x = EPSILON * (rayDirection.x < 0 ? -1 : 1); }
-    if (Abs(rayDirection.y) < EPSILON) { rayDirection.y = EPSILON * (rayDirection.y < 0 ? -1 : 1); }
-    if (Abs(rayDirection.z) < EPSILON) { rayDirection.z = EPSILON * (rayDirection.z < 0 ? -1 : 1); }
-    
-    float invDx = 1 / rayDirection.x;
-    float invDy = 1 / rayDirection.y;
-    float invDz = 1 / rayDirection.z;
+void UnmapSvoMeshBuffers(SvoGpuMesh* gpuMesh, SvoMeshBuffer* mesh) {
+    if (!mesh->vertices) {
+        return; // The reserve callback turned the mesh down, nothing was mapped.
+    }
     
-    Vector3 t_min = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
-    Vector3 t_max = {  FLT_MAX,  FLT_MAX,  FLT_MAX };
+    gpuMesh->vertexBuffer.count = mesh->vertexCount;
+    gpuMesh->indexBuffer.count = mesh->indexCount;
+    gpuMesh->shortIndexBuffer.count = mesh->shortIndexCount;
+    gpuMesh->clusterCount = mesh->clusterCount;
     
-    // X slab
-    if (stepDir.x == 0) {
-        if (rayStart.x < v0.x || rayStart.x > v1.x) {
-            return;
-        }
-    } else {
-        t_min.x = invDx * (v0.x - rayStart.x);                
-        t_max.x = invDx * (v1.x - rayStart.x);
-        if (t_max.x < t_min.x) { 
-            SWAP(t_max.x, t_min.x);
-        }
+    UnmapBuffer(&gpuMesh->shortIndexBuffer);
+    UnmapBuffer(&gpuMesh->indexBuffer);
+    UnmapBuffer(&gpuMesh->vertexBuffer);
+}
+
+// Recreates buffer when less than a quarter of it would be left for edits after count elements, 
+// with room for half as many more.
+void ReserveSvoGpuBuffer(GpuBuffer* buffer, u32 count) {
+    if (count + count / 4 <= buffer->capacity) {
+        return;
     }
     
-    // Y slab
-    if (stepDir.y == 0) {
-        if (rayStart.y < v0.y || rayStart.y > v1.y) {
-            return;
-        }
+    GpuBuffer old = *buffer;
+    u32 capacity = Max(count + count / 2, (u32)SVO_MESH_MIN_GPU_CAPACITY);
+    ReleaseBuffer(buffer);
+    if (old.type == IndexBuffer) {
+        InitializeIndexBuffer(buffer, capacity, old.indexFormat, old.usage);
     } else {
-        t_min.y = invDy * (v0.y - rayStart.y);                
-        t_max.y = invDy * (v1.y - rayStart.y);                
-        if (t_max.y < t_min.y) {
-            SWAP(t_max.y, t_min.y);
-        }
+        InitializeGpuBuffer(buffer, capacity, old.stride, old.type, old.usage);
     }
-    
-    // Z slab
-    if (stepDir.z == 0) {
-        if (rayStart.z < v0.z || rayStart.z > v1.z) {
-            return;
-        }
-    } else {
-        t_min.z = invDz * (v0.z - rayStart.z);                
-        t_max.z = invDz * (v1.z - rayStart.z);                
-        if (t_max.z < t_min.z) {
-            SWAP(t_max.z, t_min.z);
-        }
+}
+
+// The clusters grow the same way. The whole mesh is rewritten when they do, so the old ones need not be kept.
+void ReserveSvoGpuMesh(SvoGpuMesh* gpuMesh, u32 vertexCount, u32 indexCount, u32 shortIndexCount, u32 clusterCount) {
+    ReserveSvoGpuBuffer(&gpuMesh->vertexBuffer, vertexCount);
+    ReserveSvoGpuBuffer(&gpuMesh->indexBuffer, indexCount);
+    ReserveSvoGpuBuffer(&gpuMesh->shortIndexBuffer, shortIndexCount);
+    if (clusterCount + clusterCount / 4 > gpuMesh->clusterCapacity) {
+        gpuMesh->clusterCapacity = clusterCount + clusterCount / 2;
+        HeapAllocator.free(gpuMesh->clusters);
+        gpuMesh->clusters = ALLOC_ARRAY(HeapAllocator, SvoMeshCluster, gpuMesh->clusterCapacity);
     }
-    
-    float t = Max(t_min.x, Max(t_min.y, t_min.z));
-    float tExit  = Min(t_max.x, Min(t_max.y, t_max.z));
-    t = Max(t, 0.0f);
+}
 
-    // Exit if no point along the ray intersects the root bounding box of the SVO.
-    if (tExit < t) {
-        return;
+// Reserve callback of PackSvoMesh(): the whole mesh is rewritten, so the buffers can be resized first.
+bool ReserveSvoMeshPack(SvoMeshBuffer* mesh, u32 vertexCount, u32 indexCount, u32 shortIndexCount, u32 clusterCount) {
+    ReserveSvoGpuMesh(&game.gpuMesh, vertexCount, indexCount, shortIndexCount, clusterCount);
+    MapSvoMeshBuffers(&game.gpuMesh, mesh, true);
+    return true;
+}
+
+void PackSvoMesh(SvoImport* svo, SvoChunkGrid* grid) {
+    SvoMeshBuffer mesh = {};
+    mesh.reserve = ReserveSvoMeshPack;
+    
+        double start = CurrentTimeInSeconds();
+        bool fits = MeshSvo(svo, grid, GetProcessorCount(), &mesh, &game.meshStats);
+        game.meshTime = CurrentTimeInSeconds() - start;
+        ASSERT_ERROR(fits, "SVO mesh does not fit in the vertex and index buffers.");
+        
+    UnmapSvoMeshBuffers(&game.gpuMesh, &mesh);
+}
+
+// Uploads the next SVO_MESH_UPLOAD_SLICE_BYTES of the surface voxel instances a remesh built into backInstanceBuffer, 
+// which is not drawn. Returns true once they are all there.
+bool UploadSvoInstanceSlice(SvoInstanceBuffer* staging) {
+    GpuBuffer* back = &game.backInstanceBuffer;
+    u32 uploaded = game.instanceUploadCount;
+    if (uploaded == 0) {
+        // AppendData() needs room for one more.
+        ReserveSvoGpuBuffer(back, staging->instanceCount + 1);
     }
     
-    DrawAABB(v0, v1);
-    
-    // Allocate the stack for recursion through the SVO.
-    int lvl = 0;
-    SvoStackEntry* stack = ALLOC_ARRAY(TempAllocator, SvoStackEntry, maxDepth + 1);
-    SvoStackEntry* current = &stack[lvl];
-    ZeroStruct(current);
+    u32 count = Min(staging->instanceCount - uploaded, SVO_MESH_UPLOAD_SLICE_BYTES / (u32)sizeof(Instance_Voxel));
+    MapBuffer(back, uploaded == 0);
+        back->count = uploaded;
+        AppendData(back, staging->instances + uploaded, count);
+    UnmapBuffer(back);
+    game.instanceUploadCount += count;
+    return game.instanceUploadCount == staging->instanceCount;
+}
 
-    float scale = rootScale * 0.5f;
-    Vector3 center = (v0 + v1) * 0.5f;
-    Vector3 p = rayStart + (rayDirection * t); 
+void QueueSvoRepack() {
+    if (!game.repackQueued) {
+        game.repackQueued = true;
+        game.repackTime = CurrentTimeInSeconds();
+        game.repackFrame = game.frameCount;
+    }
+}
 
-    current->corner = v0;
-    if (p.x >= center.x) { current->idx ^= 1; current->corner.x = scale; }   
-    if (p.y >= center.y) { current->idx ^= 2; current->corner.y = scale; }   
-    if (p.z >= center.z) { current->idx ^= 4; current->corner.z = scale; }   
-    
-#ifdef _DEBUG
-    int indentCount = 0;
-    char indents[32]; 
-    memset(indents, 0, sizeof(indents));
-    LOG_MESSAGE("Push %d:%hhu\n", lvl, current->idx);
-    indents[indentCount++] = ' ';
-#endif // _DEBUG    
+void QueueSvoEdit(Vector3 rayStart, Vector3 rayDirection, bool filled) {
+    if (game.queuedEditCount == SVO_MAX_QUEUED_EDITS) {
+        LOG_MESSAGE("Too many edits waiting for the remesh, dropped this one.\n");
+        return;
+    }
+    game.queuedEdits[game.queuedEditCount++] = { rayStart, rayDirection, filled, CurrentTimeInSeconds(), game.frameCount };
+}
 
-    for (;;) {
-        Vector3 upper_corner = current->corner + Vector3{scale, scale, scale};
+// Called once per frame before anything is drawn. Takes over a finished remesh and starts the next one for whatever
+// was queued meanwhile. Only the upload, copying the chunks and the voxel edits themselves happen on this thread, 
+// the exterior flood, the meshing and the instances run in the background, so neither edits nor new settings stall 
+// the frame.
+// The GPU may still be drawing the old ranges: appended chunks only go after the end of the buffers, and a repack 
+// and the instances go to back buffers that are swapped with the drawn ones once complete.
+void UpdateSvoRemesh() {
+    SvoRemesh* remesh = &game.remesh;
+    SvoChunkGrid* grid = &game.chunkGrid;
+    if (remesh->running) {
+        if (!SvoRemeshDone(remesh)) {
+            return;
+        }
         
-        u8 mask = svo->masksAtLevel[lvl][current->mask_idx];
-        if (mask & (1u << current->idx)) {            
-            if (lvl < maxDepth) {
-                center = (current->corner + upper_corner) * 0.5f;
-                scale *= 0.5f;
-                
-                int previous_lvl = lvl;
-                int previous_mask_idx = current->mask_idx;
-                Vector3 previous_corner = current->corner;
-                
-                u8 beforeMask = mask & ((1u << current->idx) - 1u);
-                int rank = Popcount8(beforeMask);
-                
-                current = &stack[++lvl];
-                current->mask_idx = svo->firstChild[previous_lvl][previous_mask_idx] + rank;
-                current->idx = 0;
-                current->corner = previous_corner;
-                if (p.x >= center.x) { current->idx ^= 1; current->corner.x += scale; }
-                if (p.y >= center.y) { current->idx ^= 2; current->corner.y += scale; }
-                if (p.z >= center.z) { current->idx ^= 4; current->corner.z += scale; }
-
-#ifdef _DEBUG
-                LOG_MESSAGE("%sPush %d:%hhu\n", indents, lvl, current->idx);
-                indents[indentCount++] = ' ';
-#endif // _DEBUG
-   
-                continue;
-            } else {
-                DrawAABB(current->corner, upper_corner);
+        // Appended chunks are small and go after the end of the drawn buffers right away. A repack goes to the back
+        // buffers a slice per frame, and the instances after it to the back instance buffer, a slice per frame too.
+        double start = CurrentTimeInSeconds();
+        SvoMeshBuffer* staging = &remesh->staging;
+        bool uploaded = game.remeshMeshUploaded;
+        bool sliced = false;
+        if (!uploaded && remesh->repack) {
+            SvoGpuMesh* back = &game.backGpuMesh;
+            SvoMeshBuffer mesh = {};
+            if (!game.remeshUploading) {
+                ReserveSvoGpuMesh(back, staging->vertexCount, staging->indexCount, staging->shortIndexCount, staging->clusterCount);
             }
+            MapSvoMeshBuffers(back, &mesh, !game.remeshUploading);
+            uploaded = CopySvoMeshStagingSlice(staging, &mesh, SVO_MESH_UPLOAD_SLICE_BYTES);
+            UnmapSvoMeshBuffers(back, &mesh);
+            game.remeshUploading = true;
+            sliced = true;
+        } else if (!uploaded) {
+            SvoMeshBuffer mesh = {};
+            MapSvoMeshBuffers(&game.gpuMesh, &mesh, false);
+            CopySvoMeshStagingSlice(staging, &mesh, 0xFFFFFFFF);
+            UnmapSvoMeshBuffers(&game.gpuMesh, &mesh);
+            uploaded = true;
+        }
+        game.remeshMeshUploaded = uploaded;
+        if (uploaded && remesh->instances) {
+            // One slice per frame, the instances start in the frame after the last slice of a repack.
+            uploaded = !sliced && UploadSvoInstanceSlice(remesh->instances);
+        }
+        game.remeshMainTime += CurrentTimeInSeconds() - start;
+        if (!uploaded) {
+            return;
         }
-
-        
-        float x = (stepDir.x > 0) ? upper_corner.x : current->corner.x;
-        float tx = (x - rayStart.x) * invDx;
         
-        float y = (stepDir.y > 0) ? upper_corner.y : current->corner.y;
-        float ty = (y - rayStart.y) * invDy;
+        // The back buffers, the instances and the chunk ranges change together.
+        if (remesh->repack) {
+            SvoGpuMesh drawn = game.gpuMesh;
+            game.gpuMesh = game.backGpuMesh;
+            game.backGpuMesh = drawn;
+        }
+        if (remesh->instances) {
+            GpuBuffer drawn = game.instanceBuffer;
+            game.instanceBuffer = game.backInstanceBuffer;
+            game.backInstanceBuffer = drawn;
+            SvoInstanceBuffer built = game.instanceStaging;
+            game.instanceStaging = game.instances;
+            game.instances = built;
+            game.instanceTime = remesh->instanceTime;
+        }
+        game.instancesCurrent = (remesh->instances != 0);
+        game.remeshUploading = false;
+        game.remeshMeshUploaded = false;
+        game.instanceUploadCount = 0;
         
-        float z = (stepDir.z > 0) ? upper_corner.z : current->corner.z;
-        float tz = (z - rayStart.z) * invDz;
+        FinishSvoRemesh(remesh, grid);
+        UpdateSvoMeshConstants(grid);
+        double mainTime = game.remeshMainTime;
         
-        s8 stepMask = 0;
-        if (tx < ty && tx < tz) {
-            t = tx;
-            stepMask = 1 * stepDir.x;
-        } else if (ty < tz) {
-            t = ty;
-            stepMask = 2 * stepDir.y;
+        if (remesh->repack) {
+            game.meshStats = remesh->stats;
+            game.meshTime = remesh->meshTime;
+        }
+        if (game.remeshEditCount == 0 && !game.remeshRepack) {
+            LOG_MESSAGE("Built %u surface voxel instances in %.3f ms, %.2f MB against %.2f MB for the chunk meshes.\n", 
+                        game.instances.instanceCount, game.instanceTime * 1000.0, 
+                        game.instances.instanceCount * sizeof(Instance_Voxel) / (double)MEGABYTES(1),
+                        (game.gpuMesh.vertexBuffer.count * sizeof(Vertex_Voxel) + game.gpuMesh.shortIndexBuffer.count * 2 + game.gpuMesh.indexBuffer.count * 4) / (double)MEGABYTES(1));
+        } else if (remesh->repack && !game.remeshRepack) {
+            LOG_MESSAGE("Buffers full, repacked the SVO mesh in %.3f ms.\n", remesh->meshTime * 1000.0);
+        } else if (remesh->repack) {
+            LOG_MESSAGE("Meshed the SVO as %s %s ambient occlusion, %s sharing repeated chunks, with %s in %.3f ms (%.3f ms flood), "
+                        "%u triangles at LOD 0, %u chunk LODs shared, %.2f MB.\n", 
+                        (grid->mesher == SvoMesher_Cubes) ? "cubes" : "surface nets", grid->ambientOcclusion ? "with" : "without", 
+                        grid->shareRepeats ? "with" : "without", grid->exterior ? "only faces towards exterior space" : "all faces", 
+                        remesh->meshTime * 1000.0, remesh->floodTime * 1000.0, remesh->stats.quadCount * 2, remesh->stats.sharedCount,
+                        (game.gpuMesh.vertexBuffer.count * sizeof(Vertex_Voxel) + game.gpuMesh.shortIndexBuffer.count * 2 + game.gpuMesh.indexBuffer.count * 4) / (double)MEGABYTES(1));
         } else {
-            t = tz;
-            stepMask = 4 * stepDir.z;
+            LOG_MESSAGE("Remeshed %d chunks for %u edits in %.3f ms (%.3f ms flood), %u bytes uploaded.\n", remesh->remeshed, 
+                        game.remeshEditCount, remesh->meshTime * 1000.0, remesh->floodTime * 1000.0, 
+                        remesh->stats.vertexCount * (u32)sizeof(Vertex_Voxel) + remesh->stats.shortIndexCount * 2 + remesh->stats.indexCount * 4);
         }
+        LOG_MESSAGE("Visible %.3f ms and %u frames after the request, %.3f ms of it on the main thread.\n", 
+                    (CurrentTimeInSeconds() - game.remeshRequestTime) * 1000.0, game.frameCount - game.remeshRequestFrame, mainTime * 1000.0);
+    }
+    
+    if (game.queuedEditCount == 0 && !game.repackQueued && !game.instancesQueued) {
+        return;
+    }
+    
+    // With only faces towards exterior space every edit needs a flood of its own, see UpdateSvoExterior(), so then 
+    // they are remeshed one at a time. A repack floods and meshes everything anyway.
+    double start = CurrentTimeInSeconds();
+    u32 editCount = (game.nextExterior && !game.repackQueued) ? 1 : game.queuedEditCount;
+    editCount = Min(editCount, game.queuedEditCount);
+    double requestTime = game.repackQueued ? game.repackTime : start;
+    u32 requestFrame = game.repackQueued ? game.repackFrame : game.frameCount;
+    bool edited = false;
+    for (u32 i = 0; i < editCount; i++) {
+        SvoRayEdit* edit = &game.queuedEdits[i];
+        if (EditSvoOnRay(&game.svo, grid, edit->rayStart, edit->rayDirection, edit->filled)) {
+            edited = true;
+        }
+        if (edit->time < requestTime) {
+            requestTime = edit->time;
+            requestFrame = edit->frame;
+        }
+    }
+    game.queuedEditCount -= editCount;
+    memmove(game.queuedEdits, game.queuedEdits + editCount, game.queuedEditCount * sizeof(SvoRayEdit));
+    // Instances that were just turned on need a remesh of their own, with nothing dirty it only builds them.
+    bool instancesOnly = !edited && !game.repackQueued;
+    if (instancesOnly && !game.instancesQueued) {
+        return;
+    }
+    
+    SvoMeshBuffer target = {};
+    target.vertexCount = game.gpuMesh.vertexBuffer.count;
+    target.indexCount = game.gpuMesh.indexBuffer.count;
+    target.shortIndexCount = game.gpuMesh.shortIndexBuffer.count;
+    target.clusterCount = game.gpuMesh.clusterCount;
+    target.vertexCapacity = game.gpuMesh.vertexBuffer.capacity;
+    target.indexCapacity = game.gpuMesh.indexBuffer.capacity;
+    target.shortIndexCapacity = game.gpuMesh.shortIndexBuffer.capacity;
+    target.clusterCapacity = game.gpuMesh.clusterCapacity;
+    BeginSvoRemesh(remesh, &game.svo, grid, &target, game.repackQueued);
+    remesh->grid.mesher = game.nextMesher;
+    remesh->grid.ambientOcclusion = game.nextAmbientOcclusion;
+    remesh->grid.shareRepeats = game.nextShareRepeats;
+    remesh->grid.exterior = game.nextExterior ? &game.exterior : 0;
+    remesh->flood = remesh->grid.exterior && (edited || !grid->exterior);
+    remesh->instances = game.instanced ? &game.instanceStaging : 0;
+    StartSvoRemesh(remesh);
+    
+    game.remeshRequestTime = requestTime;
+    game.remeshRequestFrame = requestFrame;
+    game.remeshEditCount = instancesOnly ? 0 : editCount;
+    game.instancesQueued = false;
+    game.remeshRepack = game.repackQueued;
+    game.repackQueued = false;
+    game.remeshMainTime = CurrentTimeInSeconds() - start;
+}
 
-        // TODO(roger): According to https://www.nvidia.com/docs/IO/88972/nvr-2010-001.pdf
-        // POP can be simplified by mirroring the octree.
-        // This eliminates the need to check the signs of the ray direction. The stepMask can become unsigned.
-        // Then POP can check if (idx & stepMask) == 0 to check if its in bounds of the current level,  otherwise pop() to parent lvl
-        
-        s8 axisBit = (stepMask >= 0) ? stepMask : -stepMask; 
-        s8 isBitSet = (current->idx & axisBit) != 0;
+// Removes the first voxel the ray hits at the mesh level, or adds one in front of the face the ray enters it through.
+// Only marks the chunks it changes dirty, see UpdateSvoRemesh(). Returns whether the SVO changed.
+bool EditSvoOnRay(SvoImport* svo, SvoChunkGrid* grid, Vector3 rayStart, Vector3 rayDirection, bool filled) {
+    int lvl = grid->lvl;
+    float size = grid->rootScale / (1 << lvl);
+    
+    SvoRayHit hit;
+    if (SvoRaycast(svo, grid->rootScale, lvl, rayStart, rayDirection, 0.0f, 1.0f, StoreFirstSvoRayHit, &hit) == 0) {
+        return false;
+    }
+    
+    Vector3Int c = hit.c;
+    if (filled) {
+        if (hit.tEnter <= 0.0f) {
+            return false; // Inside the voxel, there is no face to build on.
+        }
         
-        while ((stepMask > 0 && isBitSet) || (stepMask < 0 && !isBitSet)) {
-            if (lvl == 0) {
-                return;
+        // The entered face is the one whose plane is closest to the entry point.
+        Vector3 p = rayStart + rayDirection * hit.tEnter;
+        float position[3] = { p.x, p.y, p.z };
+        float direction[3] = { rayDirection.x, rayDirection.y, rayDirection.z };
+        int cell[3] = { c.x, c.y, c.z };
+        int axis = 0;
+        float best = FLT_MAX;
+        for (int a = 0; a < 3; a++) {
+            float plane = (direction[a] > 0 ? cell[a] : cell[a] + 1) * size;
+            float distance = Abs(position[a] - plane);
+            if (distance < best) {
+                best = distance;
+                axis = a;
             }
-
-#ifdef _DEBUG            
-            indents[--indentCount] = 0;
-            LOG_MESSAGE("%sPop\n", indents);
-#endif // _DEBUG
-            
-            scale *= 2;
-            current = &stack[--lvl];
-            isBitSet = (current->idx & axisBit) != 0;
         }
+        cell[axis] += (direction[axis] > 0) ? -1 : 1;
+        c = Vector3Int{ cell[0], cell[1], cell[2] };
+    }
+    
+    if (!SetSvoVoxel(svo, lvl, c, filled, HeapAllocator)) {
+        return false;
+    }
+    MarkSvoVoxelDirty(grid, c);
+    return true;
+}
 
-        current->idx += stepMask;
-        p = rayStart + (rayDirection * t);
+bool DrawSvoRayHit(SvoRayHit* hit, void* userData) {
+    float size = *(float*)userData;
+    Vector3 corner = { hit->c.x * size, hit->c.y * size, hit->c.z * size };
+    DrawAABB(corner, corner + Vector3{size, size, size});
+    return true;
+}
 
-#ifdef _DEBUG 
-        LOG_MESSAGE("%sAdvance %d:%d\n", indents, lvl, current->idx);
-#endif // _DEBUG
-        
-        if (axisBit & 1) { current->corner.x += scale * stepDir.x; }   
-        if (axisBit & 2) { current->corner.y += scale * stepDir.y; }   
-        if (axisBit & 4) { current->corner.z += scale * stepDir.z; }  
-    }
+void RaycastSvo(SvoImport* svo, float rootScale, Vector3 rayStart, Vector3 rayDirection, int maxDepth) {
+    DrawLine(rayStart, rayStart + rayDirection);
+    DrawAABB(Vector3{0, 0, 0}, Vector3{rootScale, rootScale, rootScale});
+    
+    int lvl = maxDepth + 1;
+    float size = rootScale / (1 << lvl);
     
-    TempArenaMemoryEnd(tempArena);
+#ifdef SVO_TRAVERSAL_STATS
+    SvoBatchStats stats;
+    BeginSvoBatchStats(&stats);
+#endif // SVO_TRAVERSAL_STATS
+
+    SvoRaycast(svo, rootScale, lvl, rayStart, rayDirection, 0.0f, FLT_MAX, DrawSvoRayHit, &size);
+
+#ifdef SVO_TRAVERSAL_STATS
+    EndSvoBatchStats();
+    PrintSvoBatchStats("RaycastSvo", &stats);
+#endif // SVO_TRAVERSAL_STATS
 }
 
 void DrawLine(Vector3 v0, Vector3 v1) {
@@ -1,16 +1,52 @@
 #define GIZMO_VERTEX_COUNT  640000
 #define GIZMO_INDEX_COUNT  1280000
 
+// Smallest vertex and index buffers for the SVO mesh, they grow to fit it, see ReserveSvoGpuBuffer().
+#define SVO_MESH_MIN_GPU_CAPACITY 65536
+
+// The chunk meshes in GPU buffers. The game draws one and uploads repacks into the other, see UpdateSvoRemesh().
+struct SvoGpuMesh {
+    GpuBuffer vertexBuffer;
+    GpuBuffer indexBuffer;
+    GpuBuffer shortIndexBuffer;
+    SvoMeshCluster* clusters;  // CPU side only
+    u32 clusterCount;
+    u32 clusterCapacity;
+};
+
+// An edit that waits for the next remesh, the SVO does not change while one runs. See UpdateSvoRemesh().
+struct SvoRayEdit {
+    Vector3 rayStart;
+    Vector3 rayDirection;
+    bool filled;
+    double time;  // when it was requested
+    u32 frame;
+};
+
+#define SVO_MAX_QUEUED_EDITS 64
+
 struct Game {
     ConstantBuffer gameConstantBuffer;
     ConstantBuffer frameConstantBuffer;
+    ConstantBuffer meshConstantBuffer;
     
     ShaderProgram simpleShader;
-    ShaderProgram simpleLightShader;
+    ShaderProgram voxelShader;
+    ShaderProgram voxelInstanceShader;
+    ShaderProgram voxelSharedShader;
     
-    GpuBuffer vertexBuffer;
-    GpuBuffer indexBuffer;
+    SvoGpuMesh gpuMesh;      // drawn
+    SvoGpuMesh backGpuMesh;  // swapped with gpuMesh once a repack is uploaded
     PipelineState meshPipeline;
+    
+    // The chunk meshes when the grid shares repeats, drawn instanced with the chunk origins in offsetBuffer every frame.
+    PipelineState sharedMeshPipeline;
+    GpuBuffer offsetBuffer;
+    
+    // The surface voxels as instanced cubes, drawn instead of the chunk meshes when instanced is set.
+    GpuBuffer instanceBuffer;
+    GpuBuffer backInstanceBuffer;  // swapped with instanceBuffer together with the meshes of a remesh
+    PipelineState instancePipeline;
 
     int gizmoVertexCount;
     Vertex_XYZ* gizmoVertices;
@@ -23,6 +59,45 @@ struct Game {
     MemoryArena memArena;
     
     SvoImport svo;
+    SvoChunkGrid chunkGrid;
+    SvoExterior exterior;      // set on the grid when only faces towards exterior space are meshed
+    bool lodEnabled;
+    float lodDistance;   // chunks closer than this are drawn at full detail, see SelectSvoChunkLods()
+    u32 triangleBudget;
+    SvoMeshStats meshStats;
+    double meshTime;
+    
+    // Meshing runs in the background and the keys only queue work for it. The settings below are the ones the next 
+    // repack meshes with, the grid takes them over together with the new meshes.
+    SvoRemesh remesh;
+    SvoRayEdit queuedEdits[SVO_MAX_QUEUED_EDITS];
+    u32 queuedEditCount;
+    bool repackQueued;
+    double repackTime;         // when the queued repack was requested
+    u32 repackFrame;
+    SvoMesher nextMesher;
+    bool nextAmbientOcclusion;
+    bool nextShareRepeats;
+    bool nextExterior;
+    double remeshRequestTime;  // of the oldest request the running remesh covers
+    u32 remeshRequestFrame;
+    u32 remeshEditCount;
+    bool remeshRepack;         // requested, an append that runs out of room repacks as well
+    double remeshMainTime;     // spent on this thread for it so far, the edits and the upload included
+    bool remeshUploading;      // into backGpuMesh, from the second slice on
+    bool remeshMeshUploaded;   // the instances are uploaded after it
+    SvoCullMode cullMode;
+    SvoCullStats cullStats;    // of the last frame
+    bool instanced;
+    bool instancesQueued;      // turned on, the next remesh builds them even without edits
+    bool instancesCurrent;     // instances match the SVO of the drawn meshes, the meshes are drawn until then
+    SvoInstanceBuffer instances;  // CPU side copy of instanceBuffer with the clusters, see BuildSvoInstances()
+    SvoInstanceBuffer instanceStaging;  // what the running remesh builds, swapped with instances once uploaded
+    u32 instanceUploadCount;   // into backInstanceBuffer so far
+    double instanceTime;
+    SvoInstanceCullStats instanceCullStats;  // of the last frame
+    u32 frameCount;
+    Matrix4 projection;
     Camera camera;
     bool hide_model;
 };
@@ -38,6 +113,13 @@ Allocator ArenaAllocator {
 };
 
 void RaycastSvo(SvoImport* svo, float rootScale, Vector3 rayStart, Vector3 rayDirection, int maxDepth);
-void PackSvoMesh(SvoImport* svo, int lvl);
+void UpdateSvoMeshConstants(SvoChunkGrid* grid);
+void PackSvoMesh(SvoImport* svo, SvoChunkGrid* grid);
+void QueueSvoRepack();
+void QueueSvoEdit(Vector3 rayStart, Vector3 rayDirection, bool filled);
+void UpdateSvoRemesh();
+bool UploadSvoInstanceSlice(SvoInstanceBuffer* staging);
+void ReserveSvoGpuBuffer(GpuBuffer* buffer, u32 count);
+bool EditSvoOnRay(SvoImport* svo, SvoChunkGrid* grid, Vector3 rayStart, Vector3 rayDirection, bool filled);
 void DrawLine(Vector3 v0, Vector3 v1);
 void DrawAABB(Vector3 v0, Vector3 v1, float padding = 0.0001f);
\ No newline at end of file
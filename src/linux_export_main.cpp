@@ -0,0 +1,154 @@
+// Headless mesh export for the Linux asset pipeline: loads an RSVO file, meshes it like the viewer does and writes
+// one LOD to PLY, OBJ or GLB, see svo_export.cpp. No window, no renderer. Built by build_export.sh.
+
+#include <cstdio>
+#include <cfloat>
+
+#include "utility.h"
+#include "platform_linux.h"
+#include "temp_allocator.h"
+
+// Only for the vertex and index types the mesher writes, nothing is drawn.
+#include "renderer.h"
+
+#include "svo.cpp"
+#include "svo_mesh.cpp"
+#include "svo_instances.cpp"
+#include "svo_export.cpp"
+#ifdef SVO_BENCHMARK
+    #include "svo_benchmark.cpp"
+#endif
+
+void PrintUsage() {
+    printf("usage: svo_export <file.rsvo> <output.ply|obj|glb> [--level N] [--lod N] [--nets] [--no-ao] [--exterior] [--threads N]\n");
+    printf("    --level N    voxel level to mesh, default the deepest level of the file up to 15\n");
+    printf("    --lod N      LOD to export, each one halves the resolution, default 0\n");
+    printf("    --nets       surface nets instead of cubes\n");
+    printf("    --no-ao      no ambient occlusion baked into the cube vertices, the viewer bakes it\n");
+    printf("    --exterior   only faces towards exterior space\n");
+    printf("    --threads N  meshing threads, default the processor count\n");
+#ifdef SVO_BENCHMARK
+    printf("    --benchmark  only run the benchmarks that need no renderer: export, instances, repeats and background remeshing\n");
+#endif
+}
+
+int main(int argc, char** argv) {
+    const char* inputPath = 0;
+    const char* outputPath = 0;
+    int lvl = -1;
+    int lod = 0;
+    int threadCount = GetProcessorCount();
+    bool surfaceNets = false;
+    bool ambientOcclusion = true;
+    bool exteriorOnly = false;
+    bool benchmark = false;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = (i + 1 < argc);
+        if (strcmp(argv[i], "--level") == 0 && hasValue) {
+            lvl = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--lod") == 0 && hasValue) {
+            lod = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && hasValue) {
+            threadCount = Max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--nets") == 0) {
+            surfaceNets = true;
+        } else if (strcmp(argv[i], "--no-ao") == 0) {
+            ambientOcclusion = false;
+        } else if (strcmp(argv[i], "--exterior") == 0) {
+            exteriorOnly = true;
+#ifdef SVO_BENCHMARK
+        } else if (strcmp(argv[i], "--benchmark") == 0) {
+            benchmark = true;
+#endif
+        } else if (!inputPath) {
+            inputPath = argv[i];
+        } else if (!outputPath) {
+            outputPath = argv[i];
+        } else {
+            PrintUsage();
+            return 1;
+        }
+    }
+    
+    SvoExportFormat format = outputPath ? SvoExportFormatFromPath(outputPath) : SvoExport_Count;
+    if (!inputPath || (!benchmark && format == SvoExport_Count)) {
+        PrintUsage();
+        return 1;
+    }
+    
+    InitTempAllocator(MEGABYTES(1024));
+    
+    double start = CurrentTimeInSeconds();
+    SvoImport svo = LoadSvo(inputPath, HeapAlloc);
+    double loadTime = CurrentTimeInSeconds() - start;
+    if (lvl < 0) {
+        lvl = Min(svo.topLevel, 15);
+    }
+    if (lvl < 1 || lvl > svo.topLevel || lvl > 15) {
+        printf("Cannot mesh level %d, %s has levels 1 to %d and meshes go up to 15.\n", lvl, inputPath, svo.topLevel);
+        return 1;
+    }
+    
+#ifdef SVO_BENCHMARK
+    if (benchmark) {
+        BenchmarkSvoExport(&svo, 8.0f, lvl);
+        BenchmarkSvoInstances(&svo, 8.0f, lvl);
+        BenchmarkSvoRepeats(&svo, 8.0f, lvl);
+        BenchmarkSvoBackgroundRemesh(&svo, 8.0f, lvl);
+        FreeSvo(&svo, HeapFree);
+        return 0;
+    }
+#endif
+    
+    // Same settings as the viewer, so the exported mesh is the one it shows.
+    SvoChunkGrid grid;
+    InitSvoChunkGrid(&grid, lvl, SVO_MESH_CHUNK_SHIFT, SVO_MESH_MAX_LODS, 8.0f, HeapAllocator);
+    InitSvoGameSettings(&grid);
+    grid.mesher = surfaceNets ? SvoMesher_SurfaceNets : SvoMesher_Cubes;
+    grid.ambientOcclusion = ambientOcclusion;
+    if (lod < 0 || lod >= grid.lodCount) {
+        printf("Cannot export LOD %d, level %d has LODs 0 to %d.\n", lod, lvl, grid.lodCount - 1);
+        return 1;
+    }
+    
+    SvoExterior exterior = {};
+    double floodTime = 0;
+    if (exteriorOnly) {
+        start = CurrentTimeInSeconds();
+        UpdateSvoExterior(&svo, &grid, &exterior);
+        floodTime = CurrentTimeInSeconds() - start;
+        grid.exterior = &exterior;
+    }
+    
+    SvoMeshStats meshStats;
+    SvoMeshBuffer mesh = {};
+    mesh.reserve = GrowSvoMeshBuffer;
+    start = CurrentTimeInSeconds();
+    MeshSvo(&svo, &grid, threadCount, &mesh, &meshStats);
+    double meshTime = CurrentTimeInSeconds() - start;
+    
+    SvoExportStats stats = {};
+    start = CurrentTimeInSeconds();
+    bool written = ExportSvoMesh(outputPath, format, &grid, &mesh, lod, &stats);
+    double exportTime = CurrentTimeInSeconds() - start;
+    if (!written) {
+        printf("Cannot write %s: it cannot be opened, or the GLB would pass 4 GB.\n", outputPath);
+        return 1;
+    }
+    
+    printf("%s: level %d, %u nodes, loaded in %.3f ms\n", inputPath, lvl, svo.nodesAtLevel[lvl], loadTime * 1000.0);
+    if (exteriorOnly) {
+        printf("exterior: %u empty blocks reached from outside, %.3f ms\n", exterior.blockCount, floodTime * 1000.0);
+    }
+    printf("mesh: %u chunks, %d LODs, %.3f ms on %d threads\n", grid.chunkCount, grid.lodCount, meshTime * 1000.0, threadCount);
+    printf("%s: LOD %d, %u vertices, %u triangles, %.2f MB in %.3f ms, %.1f MB/s\n", outputPath, lod, stats.vertexCount,
+           stats.triangleCount, stats.byteCount / (double)MEGABYTES(1), exportTime * 1000.0,
+           stats.byteCount / (double)MEGABYTES(1) / exportTime);
+    
+    FreeSvoMeshBuffer(&mesh);
+    if (exteriorOnly) {
+        FreeSvoExterior(&exterior);
+    }
+    FreeSvo(&svo, HeapFree);
+    return 0;
+}
@@ -14,6 +14,25 @@ struct Vertex_XYZ_N {
     float nx, ny, nz;
 };
 
+// Integer voxel corner plus the face direction (+x, -x, +y, -y, +z, -z) and the baked ambient occlusion of the 
+// corner above it, decoded by the voxel shader, see SVO_MESH_OCCLUSION_SHIFT.
+// Surface net meshes use fixed point positions and an octahedral normal in face instead, see SVO_MESH_NET_PRECISION.
+struct Vertex_Voxel {
+    u16 x, y, z;
+    u16 face;
+};
+
+// Integer voxel corner plus a bit per exposed face in the same order, one per drawn cube of the instanced voxel shader.
+struct Instance_Voxel {
+    u16 x, y, z;
+    u16 faces;
+};
+
+// Where one instance of a shared chunk mesh is drawn, added to its Vertex_Voxel positions. w is unused.
+struct Instance_Offset {
+    u16 x, y, z, w;
+};
+
 struct VertexUV {
     float x, y, z;
     float u, v;
@@ -0,0 +1,212 @@
+#ifndef _LINUX_PLATFORM_H_
+#define _LINUX_PLATFORM_H_
+
+// The part of the platform layer that headless tools need on Linux: time, files and threads.
+// Mirrors platform_windows.h, see linux_export_main.cpp.
+
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sys/stat.h>
+#include "file_io.h"
+#include "threading.h"
+
+double CurrentTimeInSeconds() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+s64 CurrentTimeInMilliseconds() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (s64)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+bool DirectoryExists(const char* directory) {
+    struct stat info;
+    return stat(directory, &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+// Creates every directory on the path up to the last separator, like the Windows version.
+void MyCreateDirectory(const char* directoryPath) {
+    char extracted[MAX_PATH_LENGTH];
+    
+    const char* current = directoryPath;
+    while (current[0] != 0) {
+        if (current[0] == '\\' || current[0] == '/') {
+            u32 length = current - directoryPath;
+            memcpy(extracted, directoryPath, length);
+            extracted[length] = 0;
+            
+            if (length > 0 && mkdir(extracted, 0755) != 0 && errno != EEXIST) {
+                ASSERT_DEBUG(false, "Failed to create directory for: %s", directoryPath);
+            }
+        }
+        current++;
+    }
+}
+
+bool RemoveFile(const char* filePath) {
+    return remove(filePath) == 0;
+}
+
+File FileOpen(const char* filePath, FileMode fileMode) {
+    File file = {0};
+    
+    int flags = 0;
+    switch (fileMode) {
+        case FileMode_Write:      flags = O_WRONLY | O_CREAT; break;
+        case FileMode_Read:       flags = O_RDONLY; break;
+        case FileMode_WriteRead:  flags = O_RDWR | O_CREAT; break;
+        default: ASSERT_DEBUG(false, "Invalid file mode.");
+    }
+    
+    file.handle = open(filePath, flags, 0644);
+    
+    file.mode = fileMode;
+    if (fileMode == FileMode_Write || fileMode == FileMode_WriteRead) {
+        //ALLOC(roger)
+        file.writeBuffer = (u8*)malloc(WriteBufferSize);
+    }
+    return file;
+}
+
+// write() may take less than it was given, so it is called until everything is written.
+void LinuxWriteAll(FileHandle handle, void* buffer, u64 size) {
+    while (size > 0) {
+        ssize_t written = write(handle, buffer, size);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        ASSERT_ERROR(written > 0, "Failed to write fileContents: %s", strerror(errno));
+        buffer = (u8*)buffer + written;
+        size -= (u64)written;
+    }
+}
+
+void FileClose(File& file) {
+    if (file.mode == FileMode_Write || file.mode == FileMode_WriteRead) {
+        if (file.bufferPosition != 0) {
+            LinuxWriteAll(file.handle, file.writeBuffer, file.bufferPosition);
+            file.bufferPosition = 0;
+        }
+        free(file.writeBuffer);
+        
+        // Like SetEndOfFile(), whatever an older version of the file had past this point is cut off.
+        off_t end = lseek(file.handle, 0, SEEK_CUR);
+        if (end >= 0) {
+            ftruncate(file.handle, end);
+        }
+    }
+    
+    close(file.handle);
+}
+
+u64 FileWrite(File& file, void* buffer, u64 size) {
+    if (file.mode != FileMode_Write && file.mode != FileMode_WriteRead) {
+        ASSERT_DEBUG(false, "Cannot write to a file opened in Read mode.");
+        return 0;
+    }
+    
+    if (file.bufferPosition + size > WriteBufferSize) {
+        LinuxWriteAll(file.handle, file.writeBuffer, file.bufferPosition);
+        file.bufferPosition = 0;
+    }
+    
+    // Writes as large as the buffer go out directly.
+    if (size >= WriteBufferSize) {
+        LinuxWriteAll(file.handle, buffer, size);
+    } else if (size > 0) {
+        memcpy(file.writeBuffer + file.bufferPosition, buffer, size);
+        file.bufferPosition += size;
+    }
+    return size;
+}
+
+u8* FileReserve(File& file, u32 size) {
+    ASSERT_ERROR(file.mode == FileMode_Write || file.mode == FileMode_WriteRead, "Cannot write to a file opened in Read mode.");
+    ASSERT_ERROR(size <= WriteBufferSize, "Cannot reserve %u bytes, the write buffer only has %u.", size, (u32)WriteBufferSize);
+    if (file.bufferPosition + size > WriteBufferSize) {
+        LinuxWriteAll(file.handle, file.writeBuffer, file.bufferPosition);
+        file.bufferPosition = 0;
+    }
+    
+    u8* reserved = file.writeBuffer + file.bufferPosition;
+    file.bufferPosition += size;
+    return reserved;
+}
+
+void FileUnreserve(File& file, u32 size) {
+    ASSERT_DEBUG(size <= file.bufferPosition, "Cannot give back %u bytes, only %u are buffered.", size, file.bufferPosition);
+    file.bufferPosition -= size;
+}
+
+struct LinuxThreadStart {
+    ThreadFunc func;
+    void* data;
+};
+
+void* LinuxThreadProc(void* param) {
+    LinuxThreadStart start = *(LinuxThreadStart*)param;
+    free(param);
+    start.func(start.data);
+    return 0;
+}
+
+ThreadHandle StartThread(ThreadFunc func, void* data) {
+    //ALLOC(roger)
+    LinuxThreadStart* start = (LinuxThreadStart*)malloc(sizeof(LinuxThreadStart));
+    start->func = func;
+    start->data = data;
+    
+    pthread_t thread;
+    int result = pthread_create(&thread, 0, LinuxThreadProc, start);
+    ASSERT_ERROR(result == 0, "Failed to create thread.");
+    return (ThreadHandle)thread;
+}
+
+void JoinThread(ThreadHandle thread) {
+    pthread_join((pthread_t)thread, 0);
+}
+
+int GetProcessorCount() {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (count > 0) ? (int)count : 1;
+}
+
+Semaphore InitSemaphore() {
+    //ALLOC(roger)
+    sem_t* semaphore = (sem_t*)malloc(sizeof(sem_t));
+    int result = sem_init(semaphore, 0, 0);
+    ASSERT_ERROR(result == 0, "Failed to create semaphore.");
+    return semaphore;
+}
+
+void FreeSemaphore(Semaphore semaphore) {
+    sem_destroy((sem_t*)semaphore);
+    free(semaphore);
+}
+
+void SignalSemaphore(Semaphore semaphore) {
+    sem_post((sem_t*)semaphore);
+}
+
+void WaitSemaphore(Semaphore semaphore) {
+    // Signals interrupt the wait without taking anything off the count.
+    while (sem_wait((sem_t*)semaphore) != 0) {
+    }
+}
+
+s32 AtomicAdd(volatile s32* value, s32 amount) {
+    return __sync_fetch_and_add(value, amount);
+}
+
+// Sets value to exchange if it is comparand, returns the value it had before either way.
+u64 AtomicCompareExchange64(volatile u64* value, u64 exchange, u64 comparand) {
+    return __sync_val_compare_and_swap(value, comparand, exchange);
+}
+
+#endif //_LINUX_PLATFORM_H_
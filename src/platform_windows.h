@@ -3,6 +3,7 @@
 
 #include <stdio.h>
 #include "file_io.h"
+#include "threading.h"
 
 #if !defined(_GAMING_XBOX)
     #include "shellapi.h"
@@ -170,8 +171,6 @@ File FileOpen(const char* filePath, FileMode fileMode) {
         0
     );
     
-    ASSERT_DEBUG(file.handle != INVALID_HANDLE_VALUE, "Error opening file: %s\n", filePath);
-
     SetFilePointer((HANDLE)file.handle, 0, 0, FILE_BEGIN);
     file.mode = fileMode;
     if (fileMode == FileMode_Write || fileMode == FileMode_WriteRead) { 
@@ -249,6 +248,87 @@ u64 FileWrite(File& file, void* buffer, u64 size) {
     return totalWritten;
 }
 
+u8* FileReserve(File& file, u32 size) {
+    ASSERT_ERROR(file.mode == FileMode_Write || file.mode == FileMode_WriteRead, "Cannot write to a file opened in Read mode.");
+    ASSERT_ERROR(size <= WriteBufferSize, "Cannot reserve %u bytes, the write buffer only has %u.", size, (u32)WriteBufferSize);
+    if (file.bufferPosition + size > WriteBufferSize) {
+        u32 bytesWritten = 0;
+        BOOL success = WriteFile((HANDLE)file.handle, file.writeBuffer, file.bufferPosition, (LPDWORD)&bytesWritten, 0);
+        ASSERT_ERROR(success != 0, "Failed to write fileContents.");
+        file.bufferPosition = 0;
+    }
+    
+    u8* reserved = file.writeBuffer + file.bufferPosition;
+    file.bufferPosition += size;
+    return reserved;
+}
+
+void FileUnreserve(File& file, u32 size) {
+    ASSERT_DEBUG(size <= file.bufferPosition, "Cannot give back %u bytes, only %u are buffered.", size, file.bufferPosition);
+    file.bufferPosition -= size;
+}
+
+struct Win32ThreadStart {
+    ThreadFunc func;
+    void* data;
+};
+
+DWORD WINAPI Win32ThreadProc(LPVOID param) {
+    Win32ThreadStart start = *(Win32ThreadStart*)param;
+    free(param);
+    start.func(start.data);
+    return 0;
+}
+
+ThreadHandle StartThread(ThreadFunc func, void* data) {
+    //ALLOC(roger)
+    Win32ThreadStart* start = (Win32ThreadStart*)malloc(sizeof(Win32ThreadStart));
+    start->func = func;
+    start->data = data;
+    
+    HANDLE thread = CreateThread(0, 0, Win32ThreadProc, start, 0, 0);
+    ASSERT_ERROR(thread != 0, "Failed to create thread.");
+    return (ThreadHandle)thread;
+}
+
+void JoinThread(ThreadHandle thread) {
+    WaitForSingleObject((HANDLE)thread, INFINITE);
+    CloseHandle((HANDLE)thread);
+}
+
+int GetProcessorCount() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+}
+
+Semaphore InitSemaphore() {
+    HANDLE semaphore = CreateSemaphoreA(0, 0, 0x7FFFFFFF, 0);
+    ASSERT_ERROR(semaphore != 0, "Failed to create semaphore.");
+    return (Semaphore)semaphore;
+}
+
+void FreeSemaphore(Semaphore semaphore) {
+    CloseHandle((HANDLE)semaphore);
+}
+
+void SignalSemaphore(Semaphore semaphore) {
+    ReleaseSemaphore((HANDLE)semaphore, 1, 0);
+}
+
+void WaitSemaphore(Semaphore semaphore) {
+    WaitForSingleObject((HANDLE)semaphore, INFINITE);
+}
+
+s32 AtomicAdd(volatile s32* value, s32 amount) {
+    return (s32)InterlockedExchangeAdd((volatile LONG*)value, (LONG)amount);
+}
+
+// Sets value to exchange if it is comparand, returns the value it had before either way.
+u64 AtomicCompareExchange64(volatile u64* value, u64 exchange, u64 comparand) {
+    return (u64)InterlockedCompareExchange64((volatile LONG64*)value, (LONG64)exchange, (LONG64)comparand);
+}
+
 void QuitGame() {
     PostQuitMessage(0);
 }
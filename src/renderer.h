@@ -126,6 +126,9 @@ enum VertexLayoutType {
     VertexLayout_XYZ,
     VertexLayout_XYZ_UV_RGBA,
     VertexLayout_XYZ_NORMAL,
+    VertexLayout_VOXEL,
+    VertexLayout_VOXEL_INSTANCE,
+    VertexLayout_VOXEL_SHARED,
     VertexLayout_Count
 };
 
@@ -540,6 +543,8 @@ void  (*BeginTextureMode)(Texture* renderTexture);
 void  (*EndTextureMode)();
 void  (*DrawVertices)(u32 count, u32 offset);
 void  (*DrawIndexedVertices)(u32 indexCount, u32 startIndex, int baseVertex);
+void  (*DrawInstancedVertices)(u32 vertexCount, u32 instanceCount, u32 startInstance);
+void  (*DrawIndexedInstancedVertices)(u32 indexCount, u32 instanceCount, u32 startIndex, int baseVertex, u32 startInstance);
 
 void  (*CreateConstantBuffer)(u32 paramIndex, ConstantBuffer* constantBuffer, size_t size);
 void  (*UpdateConstantBuffer)(ConstantBuffer* constantBuffer, void* data, size_t size);
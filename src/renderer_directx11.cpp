@@ -349,6 +349,21 @@ ShaderProgram DX11_LoadShader(const char* path, VertexLayoutType vertexLayoutTyp
                 layout[count++] = { "NORMAL",   0, DXGI_FORMAT_R32G32B32_FLOAT,    0,  12, D3D11_INPUT_PER_VERTEX_DATA, 0 };
             } break;
             
+            case VertexLayout_VOXEL: {
+                layout[count++] = { "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UINT,  0,  0,  D3D11_INPUT_PER_VERTEX_DATA, 0 };
+            } break;
+            
+            // Only per instance data, the vertices of the cube come from SV_VertexID.
+            case VertexLayout_VOXEL_INSTANCE: {
+                layout[count++] = { "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UINT,  0,  0,  D3D11_INPUT_PER_INSTANCE_DATA, 1 };
+            } break;
+            
+            // Vertex_Voxel in slot 0, the Instance_Offset of every instance in slot 1.
+            case VertexLayout_VOXEL_SHARED: {
+                layout[count++] = { "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UINT,  0,  0,  D3D11_INPUT_PER_VERTEX_DATA, 0 };
+                layout[count++] = { "OFFSET",   0, DXGI_FORMAT_R16G16B16A16_UINT,  1,  0,  D3D11_INPUT_PER_INSTANCE_DATA, 1 };
+            } break;
+            
             case VertexLayout_XYZ_UV_RGBA: {
                 layout[count++] = { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT,    0,  0, D3D11_INPUT_PER_VERTEX_DATA, 0 };
                 layout[count++] = { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT,       0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 };
@@ -474,6 +489,14 @@ void DX11_DrawIndexedVertices(u32 indexCount, u32 startIndex, int baseVertex) {
     imContext->DrawIndexed(indexCount, startIndex, baseVertex);
 }
 
+void DX11_DrawInstancedVertices(u32 vertexCount, u32 instanceCount, u32 startInstance) {
+    imContext->DrawInstanced(vertexCount, instanceCount, 0, startInstance);
+}
+
+void DX11_DrawIndexedInstancedVertices(u32 indexCount, u32 instanceCount, u32 startIndex, int baseVertex, u32 startInstance) {
+    imContext->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+}
+
 void DX11_BeginTextureMode(Texture* renderTexture) {
     activeRenderTarget = renderTexture->dx11.rtv;
     imContext->OMSetRenderTargets(1, &activeRenderTarget, depthStencilView);
@@ -690,6 +713,8 @@ void DX11_InitializeRenderer(HWND window) {
     EndTextureMode = DX11_EndTextureMode;
     DrawVertices = DX11_DrawVertices;
     DrawIndexedVertices = DX11_DrawIndexedVertices;
+    DrawInstancedVertices = DX11_DrawInstancedVertices;
+    DrawIndexedInstancedVertices = DX11_DrawIndexedInstancedVertices;
 
     LoadTexture = DX11_LoadTexture;
     UpdateTexture = DX11_UpdateTexture;
@@ -1,18 +1,129 @@
+#include <emmintrin.h>
+
+#define SVO_MAX_LEVELS 32
+#define SVO_NO_NODE 0xFFFFFFFFu
+
 struct SvoImport {
     int topLevel;
     u32* nodesAtLevel;
     u8** masksAtLevel;
     u32** firstChild;
+    u8** solidLevels;  // per node below topLevel: how many levels below it are completely filled, see ComputeSvoSolidLevels()
 };
 
-int Popcount8(u8 mask) {
-    int popcount = 0;
-    for (int j = 0; j < 8; j++) {
-        if (mask & (1 << j)) {
-            popcount += 1;
-        }   
+// Traversal statistics, compiled in with 'build /stats' (SVO_TRAVERSAL_STATS), including release builds.
+// Every ray or segment query counts its own steps and, when a batch is active on the thread, adds them to 
+// the batch histograms. See BeginSvoBatchStats() and PrintSvoBatchStats().
+#ifdef SVO_TRAVERSAL_STATS
+
+#define SVO_STATS_BUCKETS 16
+
+struct SvoRayStats {
+    u32 steps;      // moves to a sibling cell, child slab tests for the SIMD traversal
+    u32 pushes;
+    u32 pops;
+    u32 maxDepth;   // deepest stack entry used
+    u32 leafTests;  // mask tests at the voxel level
+};
+
+// Bucket 0 counts zeros, bucket b counts values in [2^(b-1), 2^b). The last bucket also takes everything above.
+struct SvoStatsHistogram {
+    u32 buckets[SVO_STATS_BUCKETS];
+    u64 total;
+    u32 max;
+};
+
+struct SvoBatchStats {
+    u32 rayCount;
+    SvoStatsHistogram steps;
+    SvoStatsHistogram pushes;
+    SvoStatsHistogram pops;
+    SvoStatsHistogram maxDepth;
+    SvoStatsHistogram leafTests;
+};
+
+thread_local SvoBatchStats* activeSvoBatchStats;
+
+void AddToSvoHistogram(SvoStatsHistogram* histogram, u32 value) {
+    int bucket = 0;
+    while (value >> bucket && bucket < SVO_STATS_BUCKETS - 1) {
+        bucket++;
+    }
+    histogram->buckets[bucket]++;
+    histogram->total += value;
+    if (value > histogram->max) {
+        histogram->max = value;
+    }
+}
+
+void AddSvoRayStats(SvoRayStats* stats) {
+    SvoBatchStats* batch = activeSvoBatchStats;
+    if (batch == 0) {
+        return;
     }
-    return popcount;
+    batch->rayCount++;
+    AddToSvoHistogram(&batch->steps, stats->steps);
+    AddToSvoHistogram(&batch->pushes, stats->pushes);
+    AddToSvoHistogram(&batch->pops, stats->pops);
+    AddToSvoHistogram(&batch->maxDepth, stats->maxDepth);
+    AddToSvoHistogram(&batch->leafTests, stats->leafTests);
+}
+
+// Adds the counters to the active batch when the query returns.
+struct SvoRayStatsScope {
+    SvoRayStats stats;
+    SvoRayStatsScope() { ZeroStruct(&stats); }
+    ~SvoRayStatsScope() { AddSvoRayStats(&stats); }
+};
+
+void BeginSvoBatchStats(SvoBatchStats* batch) {
+    ZeroStruct(batch);
+    activeSvoBatchStats = batch;
+}
+
+void EndSvoBatchStats() {
+    activeSvoBatchStats = 0;
+}
+
+void PrintSvoHistogram(const char* name, SvoStatsHistogram* histogram, u32 rayCount) {
+    printf("    %-10s avg %8.2f  max %6u |", name, rayCount ? (double)histogram->total / rayCount : 0.0, histogram->max);
+    int last = 0;
+    for (int i = 0; i < SVO_STATS_BUCKETS; i++) {
+        if (histogram->buckets[i]) { last = i; }
+    }
+    for (int i = 0; i <= last; i++) {
+        printf(" %u", histogram->buckets[i]);
+    }
+    printf("\n");
+}
+
+void PrintSvoBatchStats(const char* name, SvoBatchStats* batch) {
+    printf("[stats] %s: %u rays, histogram buckets are 0, 1, 2-3, 4-7, ...\n", name, batch->rayCount);
+    PrintSvoHistogram("steps", &batch->steps, batch->rayCount);
+    PrintSvoHistogram("pushes", &batch->pushes, batch->rayCount);
+    PrintSvoHistogram("pops", &batch->pops, batch->rayCount);
+    PrintSvoHistogram("max depth", &batch->maxDepth, batch->rayCount);
+    PrintSvoHistogram("leaf tests", &batch->leafTests, batch->rayCount);
+}
+
+#define SVO_RAY_STATS_BEGIN() SvoRayStatsScope svoRayStats
+#define SVO_STAT_INC(field) (svoRayStats.stats.field++)
+#define SVO_STAT_DEPTH(depth) do { if ((u32)(depth) > svoRayStats.stats.maxDepth) { svoRayStats.stats.maxDepth = (u32)(depth); } } while (0)
+
+#else
+
+#define SVO_RAY_STATS_BEGIN()
+#define SVO_STAT_INC(field)
+#define SVO_STAT_DEPTH(depth)
+
+#endif // SVO_TRAVERSAL_STATS
+
+int Popcount8(u8 mask) {
+    // Bit count in parallel: pairs, then nibbles, then the byte.
+    u32 v = mask;
+    v = v - ((v >> 1) & 0x55);
+    v = (v & 0x33) + ((v >> 2) & 0x33);
+    return (int)((v + (v >> 4)) & 0x0F);
 }
 
 void VerifySvoPopCount(SvoImport* svo) {
@@ -28,6 +139,57 @@ void VerifySvoPopCount(SvoImport* svo) {
     }
 }
 
+// Compute first child for each level so child lookups only need a popcount of the preceding siblings.
+void ComputeSvoFirstChild(SvoImport* svo, AllocFunc alloc) {
+    svo->firstChild = (u32**)alloc(sizeof(u32*) * (svo->topLevel + 1));
+    svo->firstChild[svo->topLevel] = 0;
+    
+    for (int i = 0; i < svo->topLevel; ++i) {
+        u32 parentCount = svo->nodesAtLevel[i];
+        svo->firstChild[i] = (u32*)alloc(sizeof(u32) * parentCount);
+        
+        u32 run = 0;
+        for (u32 p = 0; p < parentCount; ++p) {
+            svo->firstChild[i][p] = run;
+            run += Popcount8(svo->masksAtLevel[i][p]);
+        }
+        
+        ASSERT_ERROR(run == svo->nodesAtLevel[i + 1], "child count mismatch!"); 
+    }
+}
+
+// Levels below a node that are completely filled, from its children's, 0 unless all 8 children exist.
+u8 SvoNodeSolidLevels(SvoImport* svo, int lvl, u32 node) {
+    if (svo->masksAtLevel[lvl][node] != 0xFF) {
+        return 0;
+    }
+    if (lvl + 1 == svo->topLevel) {
+        return 1;
+    }
+    
+    u32 first = svo->firstChild[lvl][node];
+    int levels = svo->solidLevels[lvl + 1][first];
+    for (u32 child = 1; child < 8; child++) {
+        levels = Min(levels, (int)svo->solidLevels[lvl + 1][first + child]);
+    }
+    return (u8)(levels + 1);
+}
+
+// Compute solid levels for each node bottom-up, so walks can tell that a subtree has every voxel of a level 
+// filled without visiting them. The subtree of a node at lvl is solid down to lvl + solidLevels[lvl][node].
+void ComputeSvoSolidLevels(SvoImport* svo, AllocFunc alloc) {
+    svo->solidLevels = (u8**)alloc(sizeof(u8*) * (svo->topLevel + 1));
+    svo->solidLevels[svo->topLevel] = 0;
+    
+    for (int i = svo->topLevel - 1; i >= 0; i--) {
+        u32 count = svo->nodesAtLevel[i];
+        svo->solidLevels[i] = (u8*)alloc(sizeof(u8) * count);
+        for (u32 node = 0; node < count; node++) {
+            svo->solidLevels[i][node] = SvoNodeSolidLevels(svo, i, node);
+        }
+    }
+}
+
 SvoImport LoadSvo(const char* filePath, AllocFunc alloc) { 
     SvoImport svo = {};
    
@@ -67,19 +229,24 @@ SvoImport LoadSvo(const char* filePath, AllocFunc alloc) {
     }
     
     ASSERT_ERROR(mb.position == mb.size, "Did not read entire file.");
+    ASSERT_ERROR(svo.topLevel < SVO_MAX_LEVELS, "RSVO has too many levels: %d.", svo.topLevel);
     
     TempArenaMemoryEnd(arena);
     
+    ComputeSvoFirstChild(&svo, alloc);
+    ComputeSvoSolidLevels(&svo, alloc);
+    
     return svo;
 }
 
-bool IsFilled(SvoImport* svo, int lvl, Vector3Int c) {
+// Index of the node at lvl that covers voxel c, or SVO_NO_NODE if it is empty.
+u32 FindSvoNode(SvoImport* svo, int lvl, Vector3Int c) {
     u32 dim = 1u << lvl;
     if ((u32)c.x >= dim || (u32)c.y >= dim || (u32)c.z >= dim) { 
-        return false;
+        return SVO_NO_NODE;
     }
     
-    int node = 0;
+    u32 node = 0;
     for (int i = 0; i < lvl; ++i) {
         int shift = (lvl - 1) - i;
         int xb = (c.x >> shift) & 1;
@@ -89,7 +256,7 @@ bool IsFilled(SvoImport* svo, int lvl, Vector3Int c) {
         
         u8 mask = svo->masksAtLevel[i][node];
         if ((mask & (1u << child)) == 0) {
-            return false; // empty
+            return SVO_NO_NODE; // empty
         }
         
         u8 beforeMask = mask & ((1u << child) - 1u);
@@ -97,5 +264,827 @@ bool IsFilled(SvoImport* svo, int lvl, Vector3Int c) {
         node = svo->firstChild[i][node] + rank;
     }
     
-    return true;
-}
\ No newline at end of file
+    return node;
+}
+
+bool IsFilled(SvoImport* svo, int lvl, Vector3Int c) {
+    return FindSvoNode(svo, lvl, c) != SVO_NO_NODE;
+}
+
+// Adds an empty node as child of parent at lvl - 1 and returns its index at lvl. 
+// Every node after it at lvl moves up by one, so firstChild of the later parents moves with it.
+u32 InsertSvoNode(SvoImport* svo, int lvl, u32 parent, int child, Allocator allocator) {
+    u8 mask = svo->masksAtLevel[lvl - 1][parent];
+    ASSERT_DEBUG((mask & (1u << child)) == 0, "Child %d already exists.", child);
+    
+    u32 index = svo->firstChild[lvl - 1][parent] + Popcount8(mask & ((1u << child) - 1u));
+    svo->masksAtLevel[lvl - 1][parent] = mask | (u8)(1u << child);
+    for (u32 p = parent + 1; p < svo->nodesAtLevel[lvl - 1]; p++) {
+        svo->firstChild[lvl - 1][p]++;
+    }
+    
+    u32 count = svo->nodesAtLevel[lvl];
+    if (lvl < svo->topLevel) {
+        // The new node has no children, so its children start where the children of the node it displaces start.
+        u32 childStart = (index < count) ? svo->firstChild[lvl][index] : svo->nodesAtLevel[lvl + 1];
+        
+        svo->masksAtLevel[lvl] = (u8*)allocator.realloc(svo->masksAtLevel[lvl], sizeof(u8) * (count + 1));
+        svo->firstChild[lvl] = (u32*)allocator.realloc(svo->firstChild[lvl], sizeof(u32) * (count + 1));
+        svo->solidLevels[lvl] = (u8*)allocator.realloc(svo->solidLevels[lvl], sizeof(u8) * (count + 1));
+        memmove(svo->masksAtLevel[lvl] + index + 1, svo->masksAtLevel[lvl] + index, sizeof(u8) * (count - index));
+        memmove(svo->firstChild[lvl] + index + 1, svo->firstChild[lvl] + index, sizeof(u32) * (count - index));
+        memmove(svo->solidLevels[lvl] + index + 1, svo->solidLevels[lvl] + index, sizeof(u8) * (count - index));
+        svo->masksAtLevel[lvl][index] = 0;
+        svo->firstChild[lvl][index] = childStart;
+        svo->solidLevels[lvl][index] = 0;
+    }
+    svo->nodesAtLevel[lvl] = count + 1;
+    
+    return index;
+}
+
+// Removes the child of parent at lvl - 1 together with everything below it. The removed nodes form one 
+// contiguous range per level, so every level is a single memmove.
+void RemoveSvoSubtree(SvoImport* svo, int lvl, u32 parent, int child) {
+    u8 mask = svo->masksAtLevel[lvl - 1][parent];
+    ASSERT_DEBUG((mask & (1u << child)) != 0, "Child %d does not exist.", child);
+    
+    u32 first[SVO_MAX_LEVELS + 1];
+    u32 last[SVO_MAX_LEVELS + 1];
+    first[lvl] = svo->firstChild[lvl - 1][parent] + Popcount8(mask & ((1u << child) - 1u));
+    last[lvl] = first[lvl] + 1;
+    for (int i = lvl; i < svo->topLevel; i++) {
+        first[i + 1] = svo->firstChild[i][first[i]];
+        last[i + 1] = (last[i] < svo->nodesAtLevel[i]) ? svo->firstChild[i][last[i]] : svo->nodesAtLevel[i + 1];
+    }
+    
+    svo->masksAtLevel[lvl - 1][parent] = mask & (u8)~(1u << child);
+    for (u32 p = parent + 1; p < svo->nodesAtLevel[lvl - 1]; p++) {
+        svo->firstChild[lvl - 1][p]--;
+    }
+    
+    for (int i = lvl; i <= svo->topLevel; i++) {
+        u32 removed = last[i] - first[i];
+        u32 tail = svo->nodesAtLevel[i] - last[i];
+        if (i < svo->topLevel) {
+            u32 removedChildren = last[i + 1] - first[i + 1];
+            memmove(svo->masksAtLevel[i] + first[i], svo->masksAtLevel[i] + last[i], sizeof(u8) * tail);
+            memmove(svo->firstChild[i] + first[i], svo->firstChild[i] + last[i], sizeof(u32) * tail);
+            memmove(svo->solidLevels[i] + first[i], svo->solidLevels[i] + last[i], sizeof(u8) * tail);
+            for (u32 p = first[i]; p < first[i] + tail; p++) {
+                svo->firstChild[i][p] -= removedChildren;
+            }
+        }
+        svo->nodesAtLevel[i] -= removed;
+    }
+}
+
+// Fills or clears voxel c at lvl and returns false if it already was in that state. The SVO arrays must have 
+// been allocated with allocator (e.g. LoadSvo with HeapAlloc), since adding a voxel grows them.
+// A new voxel above the top level gets a node without children, clearing a voxel removes its whole subtree. 
+// Parents that become empty are kept with a zero mask, which every traversal already treats as empty space.
+// Only the solid levels of the nodes on the path to c can change, they are updated bottom-up afterwards.
+bool SetSvoVoxel(SvoImport* svo, int lvl, Vector3Int c, bool filled, Allocator allocator) {
+    ASSERT_ERROR(lvl > 0 && lvl <= svo->topLevel, "Invalid voxel level %d.", lvl);
+    
+    u32 dim = 1u << lvl;
+    if ((u32)c.x >= dim || (u32)c.y >= dim || (u32)c.z >= dim) { 
+        return false;
+    }
+    
+    // Inserting nodes only moves the nodes at the level of the insert, so the path above stays valid.
+    u32 path[SVO_MAX_LEVELS];
+    u32 node = 0;
+    for (int i = 0; i < lvl; ++i) {
+        int shift = (lvl - 1) - i;
+        int child = ((c.x >> shift) & 1) | (((c.y >> shift) & 1) << 1) | (((c.z >> shift) & 1) << 2);
+        path[i] = node;
+        
+        u8 mask = svo->masksAtLevel[i][node];
+        bool exists = (mask & (1u << child)) != 0;
+        if (i == lvl - 1) {
+            if (exists == filled) {
+                return false;
+            }
+            if (filled) {
+                InsertSvoNode(svo, lvl, node, child, allocator);
+            } else {
+                RemoveSvoSubtree(svo, lvl, node, child);
+            }
+            for (int p = i; p >= 0; p--) {
+                svo->solidLevels[p][path[p]] = SvoNodeSolidLevels(svo, p, path[p]);
+            }
+            return true;
+        }
+        
+        if (exists) {
+            node = svo->firstChild[i][node] + Popcount8(mask & ((1u << child) - 1u));
+        } else if (filled) {
+            node = InsertSvoNode(svo, i + 1, node, child, allocator);
+        } else {
+            return false;
+        }
+    }
+    
+    return false;
+}
+
+void FreeSvo(SvoImport* svo, FreeFunc free) {
+    for (int i = 0; i < svo->topLevel; i++) {
+        free(svo->masksAtLevel[i]);
+        free(svo->firstChild[i]);
+        free(svo->solidLevels[i]);
+    }
+    free(svo->masksAtLevel);
+    free(svo->firstChild);
+    free(svo->solidLevels);
+    free(svo->nodesAtLevel);
+    ZeroStruct(svo);
+}
+
+void ComputeSvoCellSizes(float rootScale, int lvl, float* cellSize) {
+    for (int i = 0; i <= lvl; i++) {
+        cellSize[i] = rootScale / (float)(1u << i);
+    }
+}
+
+struct SvoRayHit {
+    Vector3Int c;  // voxel coordinates at the traversal level
+    u32 node;      // index into the nodes at the traversal level
+    float tEnter;
+    float tExit;
+};
+
+// Return false to stop the traversal.
+typedef bool (*SvoRayHitCallback)(SvoRayHit* hit, void* userData);
+
+struct SvoStackEntry {
+    Vector3 corner;
+    Vector3Int c;
+    int mask_idx;
+    s8 idx;
+};
+
+// Visits every filled voxel at lvl that the ray passes through within [tMin, tMax], front-to-back.
+// The traversal keeps its stack between hits, so it never re-descends from the root.
+// Returns the number of hits passed to the callback.
+int SvoRaycast(SvoImport* svo, float rootScale, int lvl, Vector3 rayStart, Vector3 rayDirection, 
+               float tMin, float tMax, SvoRayHitCallback callback, void* userData) {
+    ASSERT_DEBUG(lvl > 0 && lvl <= svo->topLevel, "Invalid raycast level %d.", lvl);
+    SVO_RAY_STATS_BEGIN();
+    
+    Vector3 v0 = {0, 0, 0};
+    Vector3 v1 = {rootScale, rootScale, rootScale};
+    
+    Vector3Int stepDir;
+    stepDir.x = (rayDirection.x > 0) ? 1 : ((rayDirection.x < 0) ? -1 : 0);
+    stepDir.y = (rayDirection.y > 0) ? 1 : ((rayDirection.y < 0) ? -1 : 0);
+    stepDir.z = (rayDirection.z > 0) ? 1 : ((rayDirection.z < 0) ? -1 : 0);
+    
+    if (Abs(rayDirection.x) < EPSILON) { rayDirection.x = EPSILON * (rayDirection.x < 0 ? -1 : 1); }
+    if (Abs(rayDirection.y) < EPSILON) { rayDirection.y = EPSILON * (rayDirection.y < 0 ? -1 : 1); }
+    if (Abs(rayDirection.z) < EPSILON) { rayDirection.z = EPSILON * (rayDirection.z < 0 ? -1 : 1); }
+    
+    float invDx = 1 / rayDirection.x;
+    float invDy = 1 / rayDirection.y;
+    float invDz = 1 / rayDirection.z;
+    
+    Vector3 t_min = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    Vector3 t_max = {  FLT_MAX,  FLT_MAX,  FLT_MAX };
+    
+    // X slab
+    if (stepDir.x == 0) {
+        if (rayStart.x < v0.x || rayStart.x > v1.x) {
+            return 0;
+        }
+    } else {
+        t_min.x = invDx * (v0.x - rayStart.x);                
+        t_max.x = invDx * (v1.x - rayStart.x);
+        if (t_max.x < t_min.x) { 
+            SWAP(t_max.x, t_min.x);
+        }
+    }
+    
+    // Y slab
+    if (stepDir.y == 0) {
+        if (rayStart.y < v0.y || rayStart.y > v1.y) {
+            return 0;
+        }
+    } else {
+        t_min.y = invDy * (v0.y - rayStart.y);                
+        t_max.y = invDy * (v1.y - rayStart.y);                
+        if (t_max.y < t_min.y) {
+            SWAP(t_max.y, t_min.y);
+        }
+    }
+    
+    // Z slab
+    if (stepDir.z == 0) {
+        if (rayStart.z < v0.z || rayStart.z > v1.z) {
+            return 0;
+        }
+    } else {
+        t_min.z = invDz * (v0.z - rayStart.z);                
+        t_max.z = invDz * (v1.z - rayStart.z);                
+        if (t_max.z < t_min.z) {
+            SWAP(t_max.z, t_min.z);
+        }
+    }
+    
+    float t = Max(t_min.x, Max(t_min.y, t_min.z));
+    float tExit  = Min(t_max.x, Min(t_max.y, t_max.z));
+    t = Max(t, Max(tMin, 0.0f));
+    tMax = Min(tMax, tExit);
+
+    // Exit if no point along the ray intersects the root bounding box of the SVO.
+    if (tMax < t) {
+        return 0;
+    }
+    
+    // Voxels at lvl are children of the nodes at lvl - 1, which is the deepest stack entry.
+    int maxDepth = lvl - 1;
+    int hitCount = 0;
+    SvoRayHit hit = {};
+    
+    int depth = 0;
+    SvoStackEntry stack[SVO_MAX_LEVELS];
+    SvoStackEntry* current = &stack[depth];
+    ZeroStruct(current);
+
+    float scale = rootScale * 0.5f;
+    Vector3 center = (v0 + v1) * 0.5f;
+    Vector3 p = rayStart + (rayDirection * t); 
+
+    current->corner = v0;
+    if (p.x >= center.x) { current->idx ^= 1; current->corner.x = scale; current->c.x = 1; }   
+    if (p.y >= center.y) { current->idx ^= 2; current->corner.y = scale; current->c.y = 1; }   
+    if (p.z >= center.z) { current->idx ^= 4; current->corner.z = scale; current->c.z = 1; }   
+    
+    SVO_STAT_INC(pushes);
+
+    for (;;) {
+        Vector3 upper_corner = current->corner + Vector3{scale, scale, scale};
+        
+        bool leafHit = false;
+        u8 mask = svo->masksAtLevel[depth][current->mask_idx];
+        if (depth == maxDepth) {
+            SVO_STAT_INC(leafTests);
+        }
+        if (mask & (1u << current->idx)) {            
+            u8 beforeMask = mask & ((1u << current->idx) - 1u);
+            int rank = Popcount8(beforeMask);
+            u32 childIdx = svo->firstChild[depth][current->mask_idx] + rank;
+            
+            if (depth < maxDepth) {
+                center = (current->corner + upper_corner) * 0.5f;
+                scale *= 0.5f;
+                
+                Vector3 previous_corner = current->corner;
+                Vector3Int previous_c = current->c;
+                
+                current = &stack[++depth];
+                current->mask_idx = childIdx;
+                current->idx = 0;
+                current->corner = previous_corner;
+                current->c = { previous_c.x * 2, previous_c.y * 2, previous_c.z * 2 };
+                if (p.x >= center.x) { current->idx ^= 1; current->corner.x += scale; current->c.x += 1; }
+                if (p.y >= center.y) { current->idx ^= 2; current->corner.y += scale; current->c.y += 1; }
+                if (p.z >= center.z) { current->idx ^= 4; current->corner.z += scale; current->c.z += 1; }
+
+                SVO_STAT_INC(pushes);
+                SVO_STAT_DEPTH(depth);
+                continue;
+            } else {
+                leafHit = true;
+                hit.c = current->c;
+                hit.node = childIdx;
+                hit.tEnter = t;
+            }
+        }
+        
+        // Axes the ray does not move along can never be crossed.
+        float x = (stepDir.x > 0) ? upper_corner.x : current->corner.x;
+        float tx = (stepDir.x != 0) ? (x - rayStart.x) * invDx : FLT_MAX;
+        
+        float y = (stepDir.y > 0) ? upper_corner.y : current->corner.y;
+        float ty = (stepDir.y != 0) ? (y - rayStart.y) * invDy : FLT_MAX;
+        
+        float z = (stepDir.z > 0) ? upper_corner.z : current->corner.z;
+        float tz = (stepDir.z != 0) ? (z - rayStart.z) * invDz : FLT_MAX;
+        
+        s8 stepMask = 0;
+        if (tx < ty && tx < tz) {
+            t = tx;
+            stepMask = 1 * stepDir.x;
+        } else if (ty < tz) {
+            t = ty;
+            stepMask = 2 * stepDir.y;
+        } else {
+            t = tz;
+            stepMask = 4 * stepDir.z;
+        }
+        
+        if (leafHit) {
+            hit.tExit = Min(t, tMax);
+            hitCount++;
+            if (!callback(&hit, userData)) {
+                return hitCount;
+            }
+        }
+        
+        if (t >= tMax) {
+            return hitCount;
+        }
+
+        // TODO(roger): According to https://www.nvidia.com/docs/IO/88972/nvr-2010-001.pdf
+        // POP can be simplified by mirroring the octree.
+        // This eliminates the need to check the signs of the ray direction. The stepMask can become unsigned.
+        // Then POP can check if (idx & stepMask) == 0 to check if its in bounds of the current level,  otherwise pop() to parent lvl
+        
+        s8 axisBit = (stepMask >= 0) ? stepMask : -stepMask; 
+        s8 isBitSet = (current->idx & axisBit) != 0;
+        
+        while ((stepMask > 0 && isBitSet) || (stepMask < 0 && !isBitSet)) {
+            if (depth == 0) {
+                return hitCount;
+            }
+
+            SVO_STAT_INC(pops);
+            scale *= 2;
+            current = &stack[--depth];
+            isBitSet = (current->idx & axisBit) != 0;
+        }
+
+        current->idx += stepMask;
+        p = rayStart + (rayDirection * t);
+        SVO_STAT_INC(steps);
+        
+        if (axisBit & 1) { current->corner.x += scale * stepDir.x; current->c.x += stepDir.x; }   
+        if (axisBit & 2) { current->corner.y += scale * stepDir.y; current->c.y += stepDir.y; }   
+        if (axisBit & 4) { current->corner.z += scale * stepDir.z; current->c.z += stepDir.z; }  
+    }
+}
+
+struct SvoRayHitBuffer {
+    SvoRayHit* hits;
+    int count;
+    int capacity;
+};
+
+bool AppendSvoRayHit(SvoRayHit* hit, void* userData) {
+    SvoRayHitBuffer* buffer = (SvoRayHitBuffer*)userData;
+    buffer->hits[buffer->count++] = *hit;
+    return buffer->count < buffer->capacity;
+}
+
+// Stores the hit in the SvoRayHit that userData points to and stops at the first one.
+bool StoreFirstSvoRayHit(SvoRayHit* hit, void* userData) {
+    *(SvoRayHit*)userData = *hit;
+    return false;
+}
+
+// Writes up to maxHits filled voxels along the ray into hits, in order. Returns the number written.
+int SvoRaycastAll(SvoImport* svo, float rootScale, int lvl, Vector3 rayStart, Vector3 rayDirection, 
+                  float tMin, float tMax, SvoRayHit* hits, int maxHits) {
+    if (maxHits <= 0) {
+        return 0;
+    }
+    
+    SvoRayHitBuffer buffer = { hits, 0, maxHits };
+    SvoRaycast(svo, rootScale, lvl, rayStart, rayDirection, tMin, tMax, AppendSvoRayHit, &buffer);
+    return buffer.count;
+}
+
+struct SvoExactStackEntry {
+    u32 node;         // node at this depth, its children are the cells being stepped through
+    int c[3];         // current child cell at level depth + 1, in mirrored coordinates
+    int idx;          // its child index, in mirrored coordinates
+    double tExit[3];  // t of the cell's exit plane along each axis
+};
+
+// Integer variant of SvoRaycast. Cells are tracked as integer coordinates per level and every t is divided out
+// directly from an integer plane position, t = (X - origin) / d, so nothing is accumulated while stepping and deep 
+// levels stay exact. The subtraction is exact and the division rounds once, so a ray through an edge or corner 
+// gets the same t for both planes and never a sliver of the voxels beyond it.
+//
+// Axes with a negative direction are mirrored (see the mirrored octree in https://www.nvidia.com/docs/IO/88972/nvr-2010-001.pdf), 
+// so the ray always steps in +1 and the child index only needs an xor before the mask lookup.
+// Exit planes are cached per stack entry. Stepping to the far child needs no plane, it exits through its parent's, and
+// descending only divides out the split planes of the near children.
+// Cells are half-open, so voxels the ray only grazes along an edge or corner are not reported. Without a callback the
+// ray stops at its first hit and returns 1.
+int SvoRaycastExact(SvoImport* svo, float rootScale, int lvl, Vector3 rayStart, Vector3 rayDirection, 
+                    float tMin, float tMax, SvoRayHitCallback callback, void* userData) {
+    ASSERT_DEBUG(lvl > 0 && lvl <= svo->topLevel && lvl < 31, "Invalid raycast level %d.", lvl);
+    SVO_RAY_STATS_BEGIN();
+    
+    // Work in units of voxels at lvl, t is unchanged by the scale.
+    double gridSize = (double)(1u << lvl);
+    double toGrid = gridSize / rootScale;
+    
+    double origin[3];
+    double dir[3];
+    bool moving[3];
+    int mirrorMask = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        origin[axis] = rayStart.v[axis] * toGrid;
+        dir[axis] = rayDirection.v[axis] * toGrid;
+        moving[axis] = dir[axis] != 0;
+        if (dir[axis] < 0) {
+            mirrorMask |= 1 << axis;
+            origin[axis] = gridSize - origin[axis];
+            dir[axis] = -dir[axis];
+        }
+    }
+    
+    double t = Max(tMin, 0.0f);
+    double tEnd = tMax;
+    // stack[0] only holds the exit planes of the root box, so every entry has a parent to take them from.
+    SvoExactStackEntry stack[SVO_MAX_LEVELS + 1];
+    double* rootExit = stack[0].tExit;
+    for (int axis = 0; axis < 3; axis++) {
+        if (!moving[axis]) {
+            if (origin[axis] < 0 || origin[axis] >= gridSize) {
+                return 0;
+            }
+            rootExit[axis] = DBL_MAX;
+        } else {
+            double t0 = -origin[axis] / dir[axis];
+            double t1 = (gridSize - origin[axis]) / dir[axis];
+            if (t0 > t) { t = t0; }
+            if (t1 < tEnd) { tEnd = t1; }
+            rootExit[axis] = t1;
+        }
+    }
+    
+    if (tEnd <= t) {
+        return 0;
+    }
+    
+    int hitCount = 0;
+    int maxDepth = lvl - 1;
+    int leafMirror[3];
+    for (int axis = 0; axis < 3; axis++) {
+        leafMirror[axis] = (mirrorMask & (1 << axis)) ? (1 << lvl) - 1 : 0;
+    }
+    
+    int depth = 0;
+    SvoExactStackEntry* current = &stack[1];
+    
+    // Descending takes the voxel the ray is in at t, clamped to the cell it descends from so rounding never leaves
+    // it, and reads the children off the bits of its coordinates. A ray sitting exactly on a split plane belongs to 
+    // the far half. A far child exits through the parent's exit plane, a near one through the split plane.
+    double* parentExit = rootExit;
+    u32 childNode = 0;
+    int voxel[3];
+    bool voxelAtT = true;  // until the next step
+    for (int axis = 0; axis < 3; axis++) {
+        double p = origin[axis] + dir[axis] * t;
+        voxel[axis] = (p <= 0) ? 0 : ((p >= gridSize) ? (1 << lvl) - 1 : (int)p);
+    }
+    
+    for (;;) {
+        current->node = childNode;
+        SVO_STAT_INC(pushes);
+        SVO_STAT_DEPTH(depth);
+        
+        int cellShift = maxDepth - depth;
+        current->idx = 0;
+        for (int axis = 0; axis < 3; axis++) {
+            int c = (voxel[axis] >> cellShift);
+            current->c[axis] = c;
+            current->idx |= (c & 1) << axis;
+            if (c & 1) {
+                current->tExit[axis] = parentExit[axis];
+            } else {
+                double plane = (double)((s64)(c + 1) << cellShift);
+                current->tExit[axis] = moving[axis] ? (plane - origin[axis]) / dir[axis] : DBL_MAX;
+            }
+        }
+        
+        // Step through the children of current until one needs to be descended into.
+        for (;;) {
+            int* c = current->c;
+            int idx = current->idx ^ mirrorMask;
+            u8 mask = svo->masksAtLevel[depth][current->node];
+            if (depth == maxDepth) {
+                SVO_STAT_INC(leafTests);
+            }
+            
+            bool filled = (mask & (1u << idx)) != 0;
+            if (filled) {
+                childNode = svo->firstChild[depth][current->node] + Popcount8(mask & ((1u << idx) - 1u));
+                if (depth < maxDepth) {
+                    if (!voxelAtT) {
+                        int cellShift = maxDepth - depth;
+                        for (int a = 0; a < 3; a++) {
+                            int lo = c[a] << cellShift;
+                            int hi = lo + (1 << cellShift) - 1;
+                            double p = origin[a] + dir[a] * t;
+                            voxel[a] = (p <= lo) ? lo : ((p >= hi) ? hi : (int)p);
+                        }
+                        voxelAtT = true;
+                    }
+                    parentExit = current->tExit;
+                    current++;
+                    depth++;
+                    break;
+                }
+            }
+            
+            // The cell is left through its nearest exit plane.
+            double* tAxis = current->tExit;
+            int axis;
+            if (tAxis[0] < tAxis[1] && tAxis[0] < tAxis[2]) {
+                axis = 0;
+            } else if (tAxis[1] < tAxis[2]) {
+                axis = 1;
+            } else {
+                axis = 2;
+            }
+            double tNext = tAxis[axis];
+            if (filled) {
+                double tHitExit = (tNext < tEnd) ? tNext : tEnd;
+                if (tHitExit > t && !callback) {
+                    return 1;
+                }
+                if (tHitExit > t) {
+                    SvoRayHit hit;
+                    hit.c = { c[0] ^ leafMirror[0], c[1] ^ leafMirror[1], c[2] ^ leafMirror[2] };
+                    hit.node = childNode;
+                    hit.tEnter = (float)t;
+                    hit.tExit = (float)tHitExit;
+                    hitCount++;
+                    if (!callback(&hit, userData)) {
+                        return hitCount;
+                    }
+                }
+            }
+            
+            t = tNext;
+            if (t >= tEnd) {
+                return hitCount;
+            }
+            
+            // Pop while the cell is already the far child of its parent along the step axis.
+            int axisBit = 1 << axis;
+            while (current->idx & axisBit) {
+                if (depth == 0) {
+                    return hitCount;
+                }
+                current--;
+                depth--;
+                SVO_STAT_INC(pops);
+            }
+            
+            // The far child shares its exit plane with the parent, so stepping needs no plane at all.
+            current->c[axis]++;
+            current->idx |= axisBit;
+            SVO_STAT_INC(steps);
+            voxelAtT = false;
+            current->tExit[axis] = current[-1].tExit[axis];
+        }
+    }
+}
+
+// Any-hit query: a segment is blocked by the first filled voxel along it, so this is SvoRaycastExact over t in [0, 1]
+// stopped at its first hit. Stepping front-to-back touches fewer cells than slab testing the children of every node
+// the segment passes in any order, see BenchmarkSvoSegments(). Cells are half-open: a voxel only blocks a segment 
+// that passes through it for a nonzero length, not one that grazes it along a face, edge or corner or ends on its 
+// face. A segment lying in the plane between two voxels counts as inside the one on the positive side.
+//
+// There is no batched version: the only setup a batch could share is the grid scale, the traversal itself is per 
+// segment, so many checks are just a loop over this.
+bool SvoSegmentOccluded(SvoImport* svo, float rootScale, int lvl, Vector3 from, Vector3 to) {
+    return SvoRaycastExact(svo, rootScale, lvl, from, to - from, 0, 1, 0, 0) > 0;
+}
+
+struct SvoSimdStackEntry {
+    u32 node;
+    int lvl;
+    Vector3Int c;
+};
+
+// Variant of SvoRaycast that does not step through the children of a node. Instead one SSE slab test computes the 
+// entry and exit t of all eight children at once, and the filled children the ray passes through are visited sorted 
+// by entry t. Children are pushed onto a depth-first stack in reverse, so the stack pops them front-to-back.
+// Like SvoRaycastExact, voxels the ray only grazes are not reported.
+int SvoRaycastSimd(SvoImport* svo, float rootScale, int lvl, Vector3 rayStart, Vector3 rayDirection, 
+                   float tMin, float tMax, SvoRayHitCallback callback, void* userData) {
+    ASSERT_DEBUG(lvl > 0 && lvl <= svo->topLevel, "Invalid raycast level %d.", lvl);
+    SVO_RAY_STATS_BEGIN();
+    
+    // Same treatment of axis-aligned rays as SvoRaycast, so the slab test never sees an infinite reciprocal.
+    float inv[3];
+    for (int axis = 0; axis < 3; axis++) {
+        float d = rayDirection.v[axis];
+        if (Abs(d) < EPSILON) { 
+            d = EPSILON * (d < 0 ? -1 : 1); 
+        }
+        inv[axis] = 1.0f / d;
+    }
+    
+    float t = Max(tMin, 0.0f);
+    for (int axis = 0; axis < 3; axis++) {
+        float t0 = -rayStart.v[axis] * inv[axis];
+        float t1 = (rootScale - rayStart.v[axis]) * inv[axis];
+        if (t1 < t0) {
+            SWAP(t0, t1);
+        }
+        t = Max(t, t0);
+        tMax = Min(tMax, t1);
+    }
+    
+    if (tMax <= t) {
+        return 0;
+    }
+    
+    // Lanes 0-3 hold children 0-3 and lanes 4-7 children 4-7, so x and y alternate within a register and z is constant.
+    const __m128 childX = _mm_setr_ps(0, 1, 0, 1);
+    const __m128 childY = _mm_setr_ps(0, 0, 1, 1);
+    __m128 invX  = _mm_set1_ps(inv[0]);
+    __m128 invY  = _mm_set1_ps(inv[1]);
+    __m128 originX = _mm_set1_ps(rayStart.x);
+    __m128 originY = _mm_set1_ps(rayStart.y);
+    __m128 tStart = _mm_set1_ps(t);
+    __m128 tEnd = _mm_set1_ps(tMax);
+    
+    float cellSize[SVO_MAX_LEVELS + 1];
+    ComputeSvoCellSizes(rootScale, lvl, cellSize);
+    
+    int hitCount = 0;
+    
+    // A line passes through at most 4 of the 8 octants, but the slab tests round, so a ray through a shared edge or 
+    // corner can hit more and a node pushes up to 8 children. Each pop and push then grows the stack by at most 7 per
+    // level below the root.
+    SvoSimdStackEntry stack[7 * SVO_MAX_LEVELS + 1];
+    int stackCount = 0;
+    stack[stackCount++] = { 0, 0, {0, 0, 0} };
+    
+    while (stackCount > 0) {
+        SvoSimdStackEntry entry = stack[--stackCount];
+        SVO_STAT_INC(pops);
+        SVO_STAT_DEPTH(entry.lvl);
+        
+        u8 mask = svo->masksAtLevel[entry.lvl][entry.node];
+        int childLvl = entry.lvl + 1;
+        float size = cellSize[childLvl];
+        if (childLvl == lvl) {
+            SVO_STAT_INC(leafTests);
+        }
+        
+        // Slab test of the 8 children. Planes are exact since they are integers times a power of two, and subtracting
+        // the origin before scaling keeps t accurate for small cells far from the origin.
+        __m128 sizes = _mm_set1_ps(size);
+        __m128 x0 = _mm_mul_ps(_mm_add_ps(_mm_set1_ps((float)(entry.c.x * 2)), childX), sizes);
+        __m128 y0 = _mm_mul_ps(_mm_add_ps(_mm_set1_ps((float)(entry.c.y * 2)), childY), sizes);
+        __m128 tx0 = _mm_mul_ps(_mm_sub_ps(x0, originX), invX);
+        __m128 tx1 = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(x0, sizes), originX), invX);
+        __m128 ty0 = _mm_mul_ps(_mm_sub_ps(y0, originY), invY);
+        __m128 ty1 = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(y0, sizes), originY), invY);
+        __m128 xyEnter = _mm_max_ps(_mm_max_ps(_mm_min_ps(tx0, tx1), _mm_min_ps(ty0, ty1)), tStart);
+        __m128 xyExit  = _mm_min_ps(_mm_min_ps(_mm_max_ps(tx0, tx1), _mm_max_ps(ty0, ty1)), tEnd);
+        
+        float z0 = (float)(entry.c.z * 2) * size;
+        float tz0 = (z0 - rayStart.z) * inv[2];
+        float tz1 = (z0 + size - rayStart.z) * inv[2];
+        float tz2 = (z0 + 2 * size - rayStart.z) * inv[2];
+        
+        float enter[8];
+        float exit[8];
+        __m128 lowEnter  = _mm_max_ps(xyEnter, _mm_set1_ps(Min(tz0, tz1)));
+        __m128 lowExit   = _mm_min_ps(xyExit,  _mm_set1_ps(Max(tz0, tz1)));
+        __m128 highEnter = _mm_max_ps(xyEnter, _mm_set1_ps(Min(tz1, tz2)));
+        __m128 highExit  = _mm_min_ps(xyExit,  _mm_set1_ps(Max(tz1, tz2)));
+        _mm_storeu_ps(enter, lowEnter);
+        _mm_storeu_ps(exit, lowExit);
+        _mm_storeu_ps(enter + 4, highEnter);
+        _mm_storeu_ps(exit + 4, highExit);
+        
+        int hitMask = _mm_movemask_ps(_mm_cmplt_ps(lowEnter, lowExit)) | 
+                     (_mm_movemask_ps(_mm_cmplt_ps(highEnter, highExit)) << 4);
+        hitMask &= mask;
+        SVO_STAT_INC(steps);
+        
+        if (hitMask == 0) {
+            continue;
+        }
+        
+        // Insertion sort of the hit children by entry t.
+        int order[8];
+        int orderCount = 0;
+        for (int child = 0; child < 8; child++) {
+            if ((hitMask & (1 << child)) == 0) {
+                continue;
+            }
+            int i = orderCount++;
+            while (i > 0 && enter[order[i - 1]] > enter[child]) {
+                order[i] = order[i - 1];
+                i--;
+            }
+            order[i] = child;
+        }
+        
+        u32 firstChild = svo->firstChild[entry.lvl][entry.node];
+        if (childLvl == lvl) {
+            for (int i = 0; i < orderCount; i++) {
+                int child = order[i];
+                SvoRayHit hit;
+                hit.c = { entry.c.x * 2 + (child & 1), entry.c.y * 2 + ((child >> 1) & 1), entry.c.z * 2 + ((child >> 2) & 1) };
+                hit.node = firstChild + Popcount8(mask & ((1u << child) - 1u));
+                hit.tEnter = enter[child];
+                hit.tExit = exit[child];
+                hitCount++;
+                if (!callback(&hit, userData)) {
+                    return hitCount;
+                }
+            }
+        } else {
+            for (int i = orderCount - 1; i >= 0; i--) {
+                int child = order[i];
+                SvoSimdStackEntry* push = &stack[stackCount++];
+                push->node = firstChild + Popcount8(mask & ((1u << child) - 1u));
+                push->lvl = childLvl;
+                push->c = { entry.c.x * 2 + (child & 1), entry.c.y * 2 + ((child >> 1) & 1), entry.c.z * 2 + ((child >> 2) & 1) };
+                SVO_STAT_INC(pushes);
+            }
+        }
+    }
+    
+    return hitCount;
+}
+
+// Interleaves the child index of every level, most significant level first.
+// Sorting by this code gives the breadth-first node order used by RSVO at every level.
+u64 SvoMortonCode(Vector3Int c, int lvl) {
+    u64 code = 0;
+    for (int i = lvl - 1; i >= 0; i--) {
+        u64 child = ((c.x >> i) & 1) | (((c.y >> i) & 1) << 1) | (((c.z >> i) & 1) << 2);
+        code = (code << 3) | child;
+    }
+    return code;
+}
+
+int CompareU64(const void* a, const void* b) {
+    u64 x = *(const u64*)a;
+    u64 y = *(const u64*)b;
+    return (x > y) - (x < y);
+}
+
+// Builds an SVO with topLevel levels from a list of voxel coordinates at topLevel. Duplicates are allowed.
+SvoImport BuildSvoFromVoxels(Vector3Int* voxels, int count, int topLevel, AllocFunc alloc) {
+    ASSERT_ERROR(topLevel > 0 && topLevel <= 21, "BuildSvoFromVoxels supports 1 to 21 levels, got %d.", topLevel);
+    
+    SvoImport svo = {};
+    svo.topLevel = topLevel;
+    
+    TempArenaMemory arena = TempArenaMemoryBegin(&tempAllocator);
+    
+    u64* codes = ALLOC_ARRAY(TempAllocator, u64, count);
+    for (int i = 0; i < count; i++) {
+        codes[i] = SvoMortonCode(voxels[i], topLevel);
+    }
+    qsort(codes, count, sizeof(u64), CompareU64);
+    
+    int unique = 0;
+    for (int i = 0; i < count; i++) {
+        if (unique == 0 || codes[unique - 1] != codes[i]) {
+            codes[unique++] = codes[i];
+        }
+    }
+    
+    svo.nodesAtLevel = (u32*)alloc(sizeof(u32) * (topLevel + 1));
+    svo.masksAtLevel = (u8**)alloc(sizeof(u8*) * (topLevel + 1));
+    svo.masksAtLevel[topLevel] = 0;
+    svo.nodesAtLevel[topLevel] = unique;
+    
+    for (int lvl = 0; lvl < topLevel; lvl++) {
+        int shift = 3 * (topLevel - lvl);
+        
+        u32 nodeCount = 0;
+        for (int i = 0; i < unique; i++) {
+            if (i == 0 || (codes[i] >> shift) != (codes[i - 1] >> shift)) {
+                nodeCount++;
+            }
+        }
+        
+        u8* masks = (u8*)alloc(sizeof(u8) * nodeCount);
+        int node = -1;
+        for (int i = 0; i < unique; i++) {
+            if (i == 0 || (codes[i] >> shift) != (codes[i - 1] >> shift)) {
+                masks[++node] = 0;
+            }
+            masks[node] |= (u8)(1u << ((codes[i] >> (shift - 3)) & 7));
+        }
+        
+        svo.nodesAtLevel[lvl] = nodeCount;
+        svo.masksAtLevel[lvl] = masks;
+    }
+    
+    TempArenaMemoryEnd(arena);
+    
+    ComputeSvoFirstChild(&svo, alloc);
+    ComputeSvoSolidLevels(&svo, alloc);
+    
+    return svo;
+}
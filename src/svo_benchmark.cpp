@@ -0,0 +1,1861 @@
+// Benchmarks and validation passes for the SVO code. Compiled in with 'build /benchmark' and run
+// once after InitGame. Results are printed to the console, so run the exe from a terminal.
+// They cover the mesher (merging, buffer sizes, threads, shared vertices, LODs, surface nets, ambient occlusion,
+// the vertex cache, exterior faces, solid subtrees, repeated chunks, edits and the background remesh), culling,
+// the surface voxel instances, the export formats, face culling, and the raycasts and segment queries against a
+// brute-force DDA. svo_export --benchmark runs the ones that need no renderer.
+
+u32 BenchRandomU32(u32* state) {
+    // xorshift32
+    u32 x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+float BenchRandom01(u32* state) {
+    return (BenchRandomU32(state) >> 8) * (1.0f / 16777216.0f);
+}
+
+Vector3 BenchRandomDirection(u32* state) {
+    Vector3 d;
+    do {
+        d = { BenchRandom01(state) * 2 - 1, BenchRandom01(state) * 2 - 1, BenchRandom01(state) * 2 - 1 };
+    } while (SqrMagnitude(d) < 0.01f || SqrMagnitude(d) > 1.0f);
+    return Normalize(d);
+}
+
+// Incoherent rays: random origins around the root box and random directions.
+void BenchRandomRays(u32* state, float rootScale, Vector3* origins, Vector3* directions, int count) {
+    for (int i = 0; i < count; i++) {
+        origins[i] = { (BenchRandom01(state) * 1.5f - 0.25f) * rootScale, 
+                       (BenchRandom01(state) * 1.5f - 0.25f) * rootScale,
+                       (BenchRandom01(state) * 1.5f - 0.25f) * rootScale };
+        directions[i] = BenchRandomDirection(state);
+    }
+}
+
+// Brute-force reference: the textbook DDA of Amanatides and Woo over every voxel at lvl, calling IsFilled for each 
+// cell. Crossings are divided out once and then advanced by a constant delta per cell, so it shares nothing with the
+// traversals it checks but the half-open cells: a voxel the ray only grazes has zero length and is not reported.
+int SvoRaycastDda(SvoImport* svo, float rootScale, int lvl, Vector3 rayStart, Vector3 rayDirection, 
+                  float tMin, float tMax, SvoRayHit* hits, int maxHits) {
+    s64 gridSize = (s64)1 << lvl;
+    double toGrid = (double)gridSize / rootScale;
+    double origin[3];
+    double d[3];
+    for (int axis = 0; axis < 3; axis++) {
+        origin[axis] = rayStart.v[axis] * toGrid;
+        d[axis] = rayDirection.v[axis] * toGrid;
+    }
+    
+    // Clip to the grid.
+    double t = Max(tMin, 0.0f);
+    double tEnd = tMax;
+    for (int axis = 0; axis < 3; axis++) {
+        if (d[axis] == 0) {
+            if (origin[axis] < 0 || origin[axis] >= (double)gridSize) {
+                return 0;
+            }
+            continue;
+        }
+        double t0 = (0 - origin[axis]) / d[axis];
+        double t1 = ((double)gridSize - origin[axis]) / d[axis];
+        if (t1 < t0) {
+            double temp = t0; t0 = t1; t1 = temp;
+        }
+        if (t0 > t) { t = t0; }
+        if (t1 < tEnd) { tEnd = t1; }
+    }
+    if (tEnd <= t) {
+        return 0;
+    }
+    
+    s64 c[3];
+    int step[3];
+    double tNextPlane[3];
+    double tDelta[3];
+    for (int axis = 0; axis < 3; axis++) {
+        c[axis] = (s64)floor(origin[axis] + d[axis] * t);
+        if (c[axis] < 0) { c[axis] = 0; }
+        if (c[axis] >= gridSize) { c[axis] = gridSize - 1; }
+        if (d[axis] > 0) {
+            step[axis] = 1;
+            tNextPlane[axis] = ((double)(c[axis] + 1) - origin[axis]) / d[axis];
+            tDelta[axis] = 1.0 / d[axis];
+        } else if (d[axis] < 0) {
+            step[axis] = -1;
+            tNextPlane[axis] = ((double)c[axis] - origin[axis]) / d[axis];
+            tDelta[axis] = -1.0 / d[axis];
+        } else {
+            step[axis] = 0;
+            tNextPlane[axis] = DBL_MAX;
+            tDelta[axis] = 0;
+        }
+    }
+    
+    int hitCount = 0;
+    while (hitCount < maxHits) {
+        int axis;
+        if (tNextPlane[0] < tNextPlane[1] && tNextPlane[0] < tNextPlane[2]) {
+            axis = 0;
+        } else if (tNextPlane[1] < tNextPlane[2]) {
+            axis = 1;
+        } else {
+            axis = 2;
+        }
+        double tNext = tNextPlane[axis];
+        double tHitExit = (tNext < tEnd) ? tNext : tEnd;
+        
+        Vector3Int cell = { (int)c[0], (int)c[1], (int)c[2] };
+        if (tHitExit > t && IsFilled(svo, lvl, cell)) {
+            SvoRayHit* hit = &hits[hitCount++];
+            hit->c = cell;
+            hit->node = 0;
+            hit->tEnter = (float)t;
+            hit->tExit = (float)tHitExit;
+        }
+        
+        if (tNext >= tEnd) {
+            break;
+        }
+        if (tNext > t) { t = tNext; }
+        c[axis] += step[axis];
+        tNextPlane[axis] += tDelta[axis];
+    }
+    
+    return hitCount;
+}
+
+bool SameSvoHitCells(SvoRayHit* a, int aCount, SvoRayHit* b, int bCount) {
+    if (aCount != bCount) {
+        return false;
+    }
+    for (int i = 0; i < aCount; i++) {
+        if (a[i].c.x != b[i].c.x || a[i].c.y != b[i].c.y || a[i].c.z != b[i].c.z) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Drops zero-length hits so results can be compared against the half-open traversals.
+int RemoveGrazingHits(SvoRayHit* hits, int count) {
+    int w = 0;
+    for (int i = 0; i < count; i++) {
+        if (hits[i].tExit > hits[i].tEnter) {
+            hits[w++] = hits[i];
+        }
+    }
+    return w;
+}
+
+#define BENCH_MAX_HITS 64
+
+// Compares the float, integer and SIMD traversals against the DDA reference.
+// Rays that hit more than BENCH_MAX_HITS voxels only compare their first BENCH_MAX_HITS hits.
+void ValidateSvoRaycasts(const char* name, SvoImport* svo, float rootScale, int lvl, 
+                         Vector3* origins, Vector3* directions, float* tMax, int rayCount) {
+    SvoRayHit reference[BENCH_MAX_HITS];
+    SvoRayHit hits[BENCH_MAX_HITS];
+    
+    int floatMismatches = 0;
+    int exactMismatches = 0;
+    int simdMismatches = 0;
+    int totalHits = 0;
+    for (int i = 0; i < rayCount; i++) {
+        float rayMax = tMax ? tMax[i] : FLT_MAX;
+        int refCount = SvoRaycastDda(svo, rootScale, lvl, origins[i], directions[i], 0, rayMax, reference, BENCH_MAX_HITS);
+        totalHits += refCount;
+        
+        int count = SvoRaycastAll(svo, rootScale, lvl, origins[i], directions[i], 0, rayMax, hits, BENCH_MAX_HITS);
+        count = RemoveGrazingHits(hits, count);
+        int compareCount = Min(refCount, count);
+        if (!SameSvoHitCells(hits, compareCount, reference, compareCount) || (count < refCount && count < BENCH_MAX_HITS)) {
+            floatMismatches++;
+        }
+        
+        SvoRayHitBuffer buffer = { hits, 0, BENCH_MAX_HITS };
+        SvoRaycastExact(svo, rootScale, lvl, origins[i], directions[i], 0, rayMax, AppendSvoRayHit, &buffer);
+        if (!SameSvoHitCells(buffer.hits, buffer.count, reference, refCount)) {
+            exactMismatches++;
+        }
+        
+        buffer.count = 0;
+        SvoRaycastSimd(svo, rootScale, lvl, origins[i], directions[i], 0, rayMax, AppendSvoRayHit, &buffer);
+        if (!SameSvoHitCells(buffer.hits, buffer.count, reference, refCount)) {
+            simdMismatches++;
+        }
+    }
+    
+    printf("[%s] level %d, %d rays, %d reference hits: float mismatches %d, exact mismatches %d, simd mismatches %d\n", 
+           name, lvl, rayCount, totalHits, floatMismatches, exactMismatches, simdMismatches);
+}
+
+struct BenchHitCounter {
+    int count;
+    int limit;
+};
+
+bool CountSvoRayHit(SvoRayHit*, void* userData) {
+    BenchHitCounter* counter = (BenchHitCounter*)userData;
+    counter->count++;
+    return counter->count < counter->limit;
+}
+
+typedef int (*SvoRaycastFunc)(SvoImport* svo, float rootScale, int lvl, Vector3 rayStart, Vector3 rayDirection, 
+                              float tMin, float tMax, SvoRayHitCallback callback, void* userData);
+
+// Best of 3 runs, the traversal counters are only collected in the first one.
+void TimeSvoRaycasts(const char* name, SvoRaycastFunc raycast, SvoImport* svo, float rootScale, int lvl, 
+                     Vector3* origins, Vector3* directions, int rayCount, int hitLimit) {
+#ifdef SVO_TRAVERSAL_STATS
+    // The counters slow the loops down, so timings with stats enabled are only comparable with each other.
+    SvoBatchStats stats;
+#endif // SVO_TRAVERSAL_STATS
+
+    double best = DBL_MAX;
+    BenchHitCounter counter = { 0, 0 };
+    for (int run = 0; run < 3; run++) {
+#ifdef SVO_TRAVERSAL_STATS
+        if (run == 0) {
+            BeginSvoBatchStats(&stats);
+        }
+#endif // SVO_TRAVERSAL_STATS
+    
+        counter.count = 0;
+        double start = CurrentTimeInSeconds();
+        for (int i = 0; i < rayCount; i++) {
+            counter.limit = counter.count + hitLimit;
+            raycast(svo, rootScale, lvl, origins[i], directions[i], 0, FLT_MAX, CountSvoRayHit, &counter);
+        }
+        double time = CurrentTimeInSeconds() - start;
+        if (time < best) {
+            best = time;
+        }
+    
+#ifdef SVO_TRAVERSAL_STATS
+        if (run == 0) {
+            EndSvoBatchStats();
+        }
+#endif // SVO_TRAVERSAL_STATS
+    }
+    
+    printf("    %-6s %8.3f ms, %10.0f rays/s, %d hits\n", name, best * 1000.0, rayCount / best, counter.count);
+    
+#ifdef SVO_TRAVERSAL_STATS
+    PrintSvoBatchStats(name, &stats);
+#endif // SVO_TRAVERSAL_STATS
+}
+
+void BenchmarkSvoRaycasts(SvoImport* svo, float rootScale, int lvl, Vector3* origins, Vector3* directions, int rayCount, int hitLimit) {
+    printf("[raycast] level %d, %d rays, up to %d hits each\n", lvl, rayCount, hitLimit);
+    TimeSvoRaycasts("float:", SvoRaycast, svo, rootScale, lvl, origins, directions, rayCount, hitLimit);
+    TimeSvoRaycasts("exact:", SvoRaycastExact, svo, rootScale, lvl, origins, directions, rayCount, hitLimit);
+    TimeSvoRaycasts("simd:", SvoRaycastSimd, svo, rootScale, lvl, origins, directions, rayCount, hitLimit);
+}
+
+struct SvoSegment {
+    Vector3 from;
+    Vector3 to;
+};
+
+// Segments from the random rays, up to rootScale long. With onCorners every other one runs from a voxel corner 
+// along a random mix of axes to another corner, so it grazes faces, edges and corners.
+void BenchRandomSegments(u32* state, float rootScale, int lvl, Vector3* origins, Vector3* directions, SvoSegment* segments, 
+                         int count, bool onCorners) {
+    float unit = rootScale / (1 << lvl);
+    for (int i = 0; i < count; i++) {
+        if (onCorners && (i & 1)) {
+            int moves = BenchRandomU32(state) % 8;
+            for (int axis = 0; axis < 3; axis++) {
+                int from = (int)(BenchRandomU32(state) % ((1 << lvl) + 1));
+                int length = (moves & (1 << axis)) ? (int)(BenchRandomU32(state) % 9) - 4 : 0;
+                segments[i].from.v[axis] = from * unit;
+                segments[i].to.v[axis] = (from + length) * unit;
+            }
+        } else {
+            segments[i].from = origins[i];
+            segments[i].to = origins[i] + directions[i] * (BenchRandom01(state) * rootScale);
+        }
+    }
+}
+
+// Any-hit segment checks against the DDA reference, which blocks a segment when it returns any hit for t in [0, 1].
+void ValidateSvoSegments(SvoImport* svo, float rootScale, int lvl, SvoSegment* segments, int count) {
+    SvoRayHit reference;
+    int blocked = 0;
+    int mismatches = 0;
+    for (int i = 0; i < count; i++) {
+        SvoSegment* segment = &segments[i];
+        bool expected = SvoRaycastDda(svo, rootScale, lvl, segment->from, segment->to - segment->from, 0, 1, &reference, 1) > 0;
+        bool occluded = SvoSegmentOccluded(svo, rootScale, lvl, segment->from, segment->to);
+        blocked += expected;
+        mismatches += (occluded != expected);
+    }
+    printf("[segments] level %d, %d segments, half on voxel corners, %d blocked by the reference: %d mismatches\n", lvl, count, 
+           blocked, mismatches);
+}
+
+// Counts the segments that SvoSegmentOccluded finds blocked.
+int CountSvoSegmentsOccluded(SvoImport* svo, float rootScale, int lvl, SvoSegment* segments, int count) {
+    int blocked = 0;
+    for (int i = 0; i < count; i++) {
+        blocked += SvoSegmentOccluded(svo, rootScale, lvl, segments[i].from, segments[i].to);
+    }
+    return blocked;
+}
+
+// Line-of-sight throughput of SvoSegmentOccluded against stopping SvoRaycast at its first hit, best of 3.
+void BenchmarkSvoSegments(SvoImport* svo, float rootScale, int lvl, SvoSegment* segments, int count) {
+#ifdef SVO_TRAVERSAL_STATS
+    SvoBatchStats stats;
+    BeginSvoBatchStats(&stats);
+    CountSvoSegmentsOccluded(svo, rootScale, lvl, segments, count);
+    EndSvoBatchStats();
+#endif // SVO_TRAVERSAL_STATS
+    
+    int blocked = 0;
+    int firstHits = 0;
+    double anyTime = DBL_MAX;
+    double firstTime = DBL_MAX;
+    for (int run = 0; run < 3; run++) {
+        double start = CurrentTimeInSeconds();
+        blocked = CountSvoSegmentsOccluded(svo, rootScale, lvl, segments, count);
+        double time = CurrentTimeInSeconds() - start;
+        if (time < anyTime) {
+            anyTime = time;
+        }
+        
+        firstHits = 0;
+        start = CurrentTimeInSeconds();
+        for (int i = 0; i < count; i++) {
+            SvoRayHit hit;
+            firstHits += SvoRaycast(svo, rootScale, lvl, segments[i].from, segments[i].to - segments[i].from, 0, 1, 
+                                    StoreFirstSvoRayHit, &hit);
+        }
+        time = CurrentTimeInSeconds() - start;
+        if (time < firstTime) {
+            firstTime = time;
+        }
+    }
+    
+    printf("[segments] level %d, %d segments up to %.1f long, %d blocked\n", lvl, count, rootScale, blocked);
+    printf("    any:   %8.3f ms, %10.0f checks/s\n", anyTime * 1000.0, count / anyTime);
+    printf("    first: %8.3f ms, %10.0f checks/s, %d blocked\n", firstTime * 1000.0, count / firstTime, firstHits);
+    
+#ifdef SVO_TRAVERSAL_STATS
+    PrintSvoBatchStats("segments", &stats);
+#endif // SVO_TRAVERSAL_STATS
+}
+
+// Level 20 model made of axis-aligned runs of voxels. Rays are aimed at a random voxel from nearby, 
+// some of them almost parallel to an axis, which is where the float traversal drifts.
+void ValidateDeepSvoRaycasts(float rootScale, int rayCount) {
+    int lvl = 20;
+    int runLength = 48;
+    int runCount = 4096;
+    
+    TempArenaMemory arena = TempArenaMemoryBegin(&tempAllocator);
+    
+    u32 state = 0x9E3779B9;
+    Vector3Int* voxels = ALLOC_ARRAY(TempAllocator, Vector3Int, runCount * runLength);
+    int voxelCount = 0;
+    int extent = (1 << lvl) - runLength;
+    for (int r = 0; r < runCount; r++) {
+        Vector3Int c = { (int)(BenchRandomU32(&state) % extent), (int)(BenchRandomU32(&state) % extent), (int)(BenchRandomU32(&state) % extent) };
+        int axis = r % 3;
+        for (int i = 0; i < runLength; i++) {
+            Vector3Int v = c;
+            if (axis == 0) { v.x += i; } else if (axis == 1) { v.y += i; } else { v.z += i; }
+            voxels[voxelCount++] = v;
+        }
+    }
+    
+    SvoImport svo = BuildSvoFromVoxels(voxels, voxelCount, lvl, TempAlloc);
+    
+    float voxelSize = rootScale / (1 << lvl);
+    Vector3* origins = ALLOC_ARRAY(TempAllocator, Vector3, rayCount);
+    Vector3* directions = ALLOC_ARRAY(TempAllocator, Vector3, rayCount);
+    float* tMax = ALLOC_ARRAY(TempAllocator, float, rayCount);
+    for (int i = 0; i < rayCount; i++) {
+        Vector3Int target = voxels[BenchRandomU32(&state) % voxelCount];
+        Vector3 targetCenter = { (target.x + BenchRandom01(&state)) * voxelSize, 
+                                 (target.y + BenchRandom01(&state)) * voxelSize, 
+                                 (target.z + BenchRandom01(&state)) * voxelSize };
+        Vector3 d = BenchRandomDirection(&state);
+        if (i & 1) {
+            // Nearly axis-aligned, tiny components get nudged to EPSILON by the float traversal.
+            int axis = (i >> 1) % 3;
+            for (int a = 0; a < 3; a++) {
+                if (a != axis) { d.v[a] *= 1e-7f; }
+            }
+            d = Normalize(d);
+        }
+        
+        float distance = 64 * voxelSize;
+        origins[i] = targetCenter - d * distance;
+        directions[i] = d;
+        tMax[i] = 2 * distance;
+    }
+    
+    ValidateSvoRaycasts("deep", &svo, rootScale, lvl, origins, directions, tMax, rayCount);
+    
+    TempArenaMemoryEnd(arena);
+}
+
+// Triangle counts of the mesh built by PackSvoMesh, without merging (one quad per exposed face) and with greedy merging.
+// The buffer sizes are what every full pack uploads, compared to Vertex_XYZ_N vertices with u32 indices.
+void PrintSvoMeshStats(int lvl, SvoMeshStats* stats, double meshTime) {
+    u32 trianglesBefore = stats->faceCount * 2;
+    u32 trianglesAfter = stats->quadCount * 2;
+    printf("[mesh] level %d, %.3f ms\n", lvl, meshTime * 1000.0);
+    printf("    unmerged: %10u triangles, %10u vertices\n", trianglesBefore, stats->faceCount * 4);
+    printf("    greedy:   %10u triangles, %10u vertices (%.1fx fewer)\n", trianglesAfter, stats->quadCount * 4, 
+           trianglesAfter ? (double)trianglesBefore / trianglesAfter : 0.0);
+    
+    u32 indexCount = stats->indexCount + stats->shortIndexCount;
+    double oldVertexBytes = (double)stats->vertexCount * sizeof(Vertex_XYZ_N);
+    double oldIndexBytes = (double)indexCount * sizeof(u32);
+    double vertexBytes = (double)stats->vertexCount * sizeof(Vertex_Voxel);
+    double indexBytes = (double)stats->shortIndexCount * sizeof(u16) + (double)stats->indexCount * sizeof(u32);
+    printf("    Vertex_XYZ_N, u32 indices: %8.2f MB vertices, %8.2f MB indices\n", oldVertexBytes / MEGABYTES(1), oldIndexBytes / MEGABYTES(1));
+    printf("    Vertex_Voxel, per chunk:   %8.2f MB vertices, %8.2f MB indices (%u of %u u16), %.1fx less to upload\n", 
+           vertexBytes / MEGABYTES(1), indexBytes / MEGABYTES(1), stats->shortIndexCount, indexCount,
+           (vertexBytes + indexBytes) > 0 ? (oldVertexBytes + oldIndexBytes) / (vertexBytes + indexBytes) : 0.0);
+}
+
+// A CPU side output for MeshSvoChunks() that grows to whatever the mesh needs.
+SvoMeshBuffer AllocSvoMeshOutput() {
+    SvoMeshBuffer mesh = {};
+    mesh.reserve = GrowSvoMeshBuffer;
+    return mesh;
+}
+
+void ClearSvoMeshOutput(SvoMeshBuffer* mesh) {
+    mesh->vertexCount = 0;
+    mesh->indexCount = 0;
+    mesh->shortIndexCount = 0;
+    mesh->clusterCount = 0;
+}
+
+bool SameSvoMeshOutput(SvoMeshBuffer* a, SvoMeshBuffer* b) {
+    return a->vertexCount == b->vertexCount && a->indexCount == b->indexCount && a->shortIndexCount == b->shortIndexCount &&
+           a->clusterCount == b->clusterCount &&
+           memcmp(a->vertices, b->vertices, a->vertexCount * sizeof(Vertex_Voxel)) == 0 &&
+           memcmp(a->clusters, b->clusters, a->clusterCount * sizeof(SvoMeshCluster)) == 0 &&
+           memcmp(a->indices, b->indices, a->indexCount * sizeof(u32)) == 0 &&
+           memcmp(a->shortIndices, b->shortIndices, a->shortIndexCount * sizeof(u16)) == 0;
+}
+
+// Best of 3 runs of MeshSvo into mesh, the first one also grows the buffer. Returns the best time.
+double TimeMeshSvo(SvoImport* svo, SvoChunkGrid* grid, int threadCount, SvoMeshBuffer* mesh, SvoMeshStats* stats) {
+    double best = DBL_MAX;
+    for (int run = 0; run < 3; run++) {
+        ClearSvoMeshOutput(mesh);
+        double start = CurrentTimeInSeconds();
+        MeshSvo(svo, grid, threadCount, mesh, stats);
+        double time = CurrentTimeInSeconds() - start;
+        if (time < best) {
+            best = time;
+        }
+    }
+    return best;
+}
+
+// Runs MeshSvo with 1, 2, 4, ... threads up to the processor count and checks that every run 
+// produces exactly the same buffers as the single threaded one.
+void BenchmarkSvoMeshThreads(SvoImport* svo, float rootScale, int lvl, SvoMeshStats* stats) {
+    SvoMeshBuffer reference = AllocSvoMeshOutput();
+    SvoMeshBuffer mesh = AllocSvoMeshOutput();
+    
+    TempArenaMemory arena = TempArenaMemoryBegin(&tempAllocator);
+    SvoChunkGrid grid;
+    InitSvoChunkGrid(&grid, lvl, SVO_MESH_CHUNK_SHIFT, SVO_MESH_MAX_LODS, rootScale, TempAllocator);
+    
+    int processorCount = GetProcessorCount();
+    printf("[mesh threads] level %d, %u quads, %d processors\n", lvl, stats->quadCount, processorCount);
+    
+    SvoMeshStats threadStats;
+    double singleTime = 0;
+    for (int threadCount = 1; threadCount <= processorCount; threadCount *= 2) {
+        if (threadCount * 2 > processorCount) {
+            threadCount = processorCount;
+        }
+        
+        double best = TimeMeshSvo(svo, &grid, threadCount, (threadCount == 1) ? &reference : &mesh, &threadStats);
+        if (threadCount == 1) {
+            singleTime = best;
+            printf("    %2d threads: %8.3f ms\n", threadCount, best * 1000.0);
+        } else {
+            bool identical = SameSvoMeshOutput(&mesh, &reference);
+            printf("    %2d threads: %8.3f ms, %5.2fx, %s\n", threadCount, best * 1000.0, singleTime / best, 
+                   identical ? "identical output" : "OUTPUT DIFFERS");
+        }
+    }
+    
+    FreeSvoMeshBuffer(&reference);
+    FreeSvoMeshBuffer(&mesh);
+    
+    TempArenaMemoryEnd(arena);
+}
+
+// Meshes every chunk with 4 vertices per quad and with shared vertices, and checks that both meshes
+// draw the same triangles when the indices are resolved.
+void BenchmarkSvoSharedVertices(SvoImport* svo, float rootScale, int lvl) {
+    TempArenaMemory arena = TempArenaMemoryBegin(&tempAllocator);
+    
+    SvoChunkGrid grids[2];
+    SvoMeshBuffer meshes[2];
+    double times[2];
+    SvoMeshStats stats;
+    for (int shared = 0; shared < 2; shared++) {
+        SvoChunkGrid* grid = &grids[shared];
+        InitSvoChunkGrid(grid, lvl, SVO_MESH_CHUNK_SHIFT, SVO_MESH_MAX_LODS, rootScale, TempAllocator);
+        grid->shareVertices = (shared == 1);
+        
+        meshes[shared] = AllocSvoMeshOutput();
+        times[shared] = TimeMeshSvo(svo, grid, 1, &meshes[shared], &stats);
+    }
+    
+    bool same = true;
+    for (u32 i = 0; i < grids[0].chunkCount * grids[0].lodCount && same; i++) {
+        SvoChunkMesh* a = &grids[0].chunks[i / grids[0].lodCount].lods[i % grids[0].lodCount];
+        SvoChunkMesh* b = &grids[1].chunks[i / grids[1].lodCount].lods[i % grids[1].lodCount];
+        same = (a->indexCount == b->indexCount);
+        for (u32 j = 0; j < a->indexCount && same; j++) {
+            u32 ia = (a->indexFormat == IndexFormat_U16) ? meshes[0].shortIndices[a->firstIndex + j] : meshes[0].indices[a->firstIndex + j];
+            u32 ib = (b->indexFormat == IndexFormat_U16) ? meshes[1].shortIndices[b->firstIndex + j] : meshes[1].indices[b->firstIndex + j];
+            same = memcmp(&meshes[0].vertices[a->firstVertex + ia], &meshes[1].vertices[b->firstVertex + ib], sizeof(Vertex_Voxel)) == 0;
+        }
+    }
+    
+    printf("[shared vertices] level %d\n", lvl);
+    printf("    per quad: %10u vertices, %10u u16 indices, %8.3f ms\n", meshes[0].vertexCount, meshes[0].shortIndexCount, times[0] * 1000.0);
+    printf("    shared:   %10u vertices, %10u u16 indices, %8.3f ms, %.2fx fewer vertices, %+.1f%% build time, %s\n",
+           meshes[1].vertexCount, meshes[1].shortIndexCount, times[1] * 1000.0, 
+           meshes[1].vertexCount ? (double)meshes[0].vertexCount / meshes[1].vertexCount : 0.0,
+           (times[1] / times[0] - 1.0) * 100.0, same ? "same triangles" : "TRIANGLES DIFFER");
+    
+    FreeSvoMeshBuffer(&meshes[0]);
+    FreeSvoMeshBuffer(&meshes[1]);
+    TempArenaMemoryEnd(arena);
+}
+
+// Triangles per LOD, the cost of building them, and what SelectSvoChunkLods() draws for a few camera positions 
+// with and without a triangle budget of a quarter of the full detail mesh.
+void BenchmarkSvoLods(SvoImport* svo, float rootScale, int lvl, float lodDistance) {
+    TempArenaMemory arena = TempArenaMemoryBegin(&tempAllocator);
+    
+    SvoChunkGrid grids[2];
+    SvoMeshBuffer meshes[2];
+    SvoMeshStats stats[2];
+    double times[2];
+    for (int i = 0; i < 2; i++) {
+        InitSvoChunkGrid(&grids[i], lvl, SVO_MESH_CHUNK_SHIFT, (i == 0) ? 1 : SVO_MESH_MAX_LODS, rootScale, TempAllocator);
+        InitSvoGameSettings(&grids[i]);
+        meshes[i] = AllocSvoMeshOutput();
+        times[i] = TimeMeshSvo(svo, &grids[i], 1, &meshes[i], &stats[i]);
+    }
+    
+    SvoChunkGrid* grid = &grids[1];
+    u32 fullTriangles = stats[1].lodQuadCounts[0] * 2;
+    printf("[lod] level %d, %d LODs, %.3f ms for LOD 0 only, %.3f ms for all LODs, %.2f MB buffers for all LODs\n", 
+           lvl, grid->lodCount, times[0] * 1000.0, times[1] * 1000.0,
+           (meshes[1].vertexCount * sizeof(Vertex_Voxel) + meshes[1].shortIndexCount * sizeof(u16) + meshes[1].indexCount * sizeof(u32)) / (double)MEGABYTES(1));
+    for (int lod = 0; lod < grid->lodCount; lod++) {
+        printf("    LOD %d (level %d): %10u triangles\n", lod, lvl - lod, stats[1].lodQuadCounts[lod] * 2);
+    }
+    
+    Vector3 cameras[] = {
+        { rootScale * 0.5f, rootScale * 0.5f, rootScale * 0.5f },
+        { 0, 0, 0 },
+        { -rootScale, rootScale * 0.5f, rootScale * 0.5f },
+    };
+    const char* cameraNames[] = { "center", "corner", "outside" };
+    u32 budget = fullTriangles / 4;
+    for (u32 i = 0; i < countOf(cameras); i++) {
+        u32 unlimited = SelectSvoChunkLods(grid, cameras[i], lodDistance, UINT32_MAX);
+        double start = CurrentTimeInSeconds();
+        u32 budgeted = SelectSvoChunkLods(grid, cameras[i], lodDistance, budget);
+        double selectTime = CurrentTimeInSeconds() - start;
+        printf("    camera %-8s %10u triangles, %10u with a budget of %u (%.3f ms to select)\n", 
+               cameraNames[i], unlimited, budgeted, budget, selectTime * 1000.0);
+    }
+    
+    FreeSvoMeshBuffer(&meshes[0]);
+    FreeSvoMeshBuffer(&meshes[1]);
+    TempArenaMemoryEnd(arena);
+}
+
+// Triangles and meshing times of the simplified surface nets against the greedy cubes at LOD 0, on 1 thread and on 
+// every processor, checking that the threaded surface nets are the same as the single threaded ones.
+void BenchmarkSvoSurfaceNets(SvoImport* svo, float rootScale, int lvl) {
+    TempArenaMemory arena = TempArenaMemoryBegin(&tempAllocator);
+    
+    int processorCount = GetProcessorCount();
+    printf("[surface nets] level %d, %d processors\n", lvl, processorCount);
+    
+    SvoMeshBuffer reference = AllocSvoMeshOutput();
+    u32 cubeTriangles = 0;
+    for (int mesher = SvoMesher_Cubes; mesher <= SvoMesher_SurfaceNets; mesher++) {
+        SvoChunkGrid grid;
+        InitSvoChunkGrid(&grid, lvl, SVO_MESH_CHUNK_SHIFT, 1, rootScale, TempAllocator);
+        InitSvoGameSettings(&grid);
+        grid.mesher = (SvoMesher)mesher;
+        
+        SvoMeshBuffer mesh = AllocSvoMeshOutput();
+        SvoMeshStats stats;
+        double times[2];
+        times[0] = TimeMeshSvo(svo, &grid, 1, &reference, &stats);
+        times[1] = TimeMeshSvo(svo, &grid, processorCount, &mesh, &stats);
+        bool identical = SameSvoMeshOutput(&mesh, &reference);
+        
+        // Simplified nets are not made of quads, so count the triangles from the indices.
+        u32 triangles = (reference.indexCount + reference.shortIndexCount) / 3;
+        if (mesher == SvoMesher_Cubes) {
+            printf("    unmerged faces: %10u triangles\n", stats.faceCount * 2);
+            cubeTriangles = triangles;
+        }
+        printf("    %-13s   %10u triangles, %10u vertices, %8.3f ms on 1 thread, %8.3f ms on %d, %s\n", 
+               (mesher == SvoMesher_Cubes) ? "cubes:" : "surface nets:", triangles, reference.vertexCount, 
+               times[0] * 1000.0, times[1] * 1000.0, processorCount, identical ? "identical output" : "OUTPUT DIFFERS");
+        if (mesher == SvoMesher_SurfaceNets) {
+            printf("    surface nets have %.1f%% of the cube triangles\n", 100.0 * triangles / cubeTriangles);
+        }
+        FreeSvoMeshBuffer(&mesh);
+    }
+    
+    FreeSvoMeshBuffer(&reference);
+    TempArenaMemoryEnd(arena);
+}
+
+// Extra triangles, vertices and meshing time of the baked ambient occlusion for every LOD on 1 thread, checking that
+// both meshes cover the same faces and that the occluded mesh is the same on every processor.
+void BenchmarkSvoAmbientOcclusion(SvoImport* svo, float rootScale, int lvl) {
+    TempArenaMemory arena = TempArenaMemoryBegin(&tempAllocator);
+    
+    int processorCount = GetProcessorCount();
+    printf("[ambient occlusion] level %d, all LODs\n", lvl);
+    
+    SvoMeshBuffer meshes[2];
+    SvoMeshStats stats[2];
+    double times[2];
+    SvoChunkGrid grid;
+    InitSvoChunkGrid(&grid, lvl, SVO_MESH_CHUNK_SHIFT, SVO_MESH_MAX_LODS, rootScale, TempAllocator);
+    InitSvoGameSettings(&grid);
+    for (int occluded = 0; occluded < 2; occluded++) {
+        grid.ambientOcclusion = (occluded == 1);
+        meshes[occluded] = AllocSvoMeshOutput();
+        times[occluded] = TimeMeshSvo(svo, &grid, 1, &meshes[occluded], &stats[occluded]);
+    }
+    
+    SvoMeshBuffer threaded = AllocSvoMeshOutput();
+    SvoMeshStats threadedStats;
+    MeshSvo(svo, &grid, processorCount, &threaded, &threadedStats);
+    bool identical = SameSvoMeshOutput(&threaded, &meshes[1]);
+    
+    printf("    without: %10u triangles at LOD 0, %10u vertices, %8.3f ms\n", 
+           stats[0].quadCount * 2, meshes[0].vertexCount, times[0] * 1000.0);
+    printf("    with:    %10u triangles at LOD 0, %10u vertices, %8.3f ms, %+.1f%% meshing time, %s, %s on %d threads\n",
+           stats[1].quadCount * 2, meshes[1].vertexCount, times[1] * 1000.0, (times[1] / times[0] - 1.0) * 100.0,
+           (stats[0].faceCount == stats[1].faceCount) ? "same faces" : "FACES DIFFER", 
+           identical ? "identical output" : "OUTPUT DIFFERS", processorCount);
+    
+    FreeSvoMeshBuffer(&threaded);
+    FreeSvoMeshBuffer(&meshes[0]);
+    FreeSvoMeshBuffer(&meshes[1]);
+    TempArenaMemoryEnd(arena);
+}
+
+// Leaves the chunk walks visit with every SvoSolidWalk and the meshing times of the three mesh paths without and 
+// with skipping the inside of solid subtrees, which must not change the output.
+void TimeSvoSolidSubtrees(const char* name, SvoImport* svo, float rootScale, int lvl) {
+    TempArenaMemory arena = TempArenaMemoryBegin(&tempAllocator);
+    
+    SvoChunkGrid grid;
+    InitSvoChunkGrid(&grid, lvl, SVO_MESH_CHUNK_SHIFT, SVO_MESH_MAX_LODS, rootScale, TempAllocator);
+    InitSvoGameSettings(&grid);
+    
+    u64 leafCounts[3] = {};
+    u64 blockCount = 0;
+    for (u32 chunk = 0; chunk < grid.chunkCount; chunk++) {
+        Vector3Int cc = SvoChunkCoord(&grid, chunk);
+        u32 node = FindSvoNode(svo, grid.chunkLevel, cc);
+        if (node == SVO_NO_NODE) {
+            continue;
+        }
+        for (int walk = SvoSolidWalk_Voxels; walk <= SvoSolidWalk_Blocks; walk++) {
+            SvoLeafIterator leaves;
+            BeginSvoLeaves(&leaves, svo, lvl, grid.chunkLevel, node, cc, 0);
+            WalkSvoSolidLeaves(&leaves, (SvoSolidWalk)walk);
+            while (NextSvoLeaf(&leaves)) {
+                leafCounts[walk]++;
+                blockCount += (leaves.blockShift > 0) ? 1 : 0;
+            }
+        }
+    }
+    printf("    %s: %llu voxels walked, %llu with the boundary walk, %llu with blocks (%llu of them solid blocks)\n", name,
+           (unsigned long long)leafCounts[SvoSolidWalk_Voxels], (unsigned long long)leafCounts[SvoSolidWalk_Boundary],
+           (unsigned long long)leafCounts[SvoSolidWalk_Blocks], (unsigned long long)blockCount);
+    
+    const char* pathNames[] = { "cubes:", "occlusion:", "surface nets:" };
+    for (int path = 0; path < 3; path++) {
+        grid.mesher = (path == 2) ? SvoMesher_SurfaceNets : SvoMesher_Cubes;
+        grid.ambientOcclusion = (path == 1);
+        
+        SvoMeshBuffer meshes[2];
+        double times[2];
+        for (int skip = 0; skip < 2; skip++) {
+            grid.solidSubtrees = (skip == 1);
+            meshes[skip] = AllocSvoMeshOutput();
+            SvoMeshStats stats;
+            times[skip] = TimeMeshSvo(svo, &grid, 1, &meshes[skip], &stats);
+        }
+        
+        printf("        %-13s %8.3f ms, %8.3f ms skipping solid subtrees, %5.2fx, %s\n", pathNames[path], times[0] * 1000.0, 
+               times[1] * 1000.0, times[0] / times[1], SameSvoMeshOutput(&meshes[0], &meshes[1]) ? "identical output" : "OUTPUT DIFFERS");
+        FreeSvoMeshBuffer(&meshes[0]);
+        FreeSvoMeshBuffer(&meshes[1]);
+    }
+    
+    TempArenaMemoryEnd(arena);
+}
+
+// Solid subtree skipping on the model and on a solid ball of the same level, which is nearly all inside.
+void BenchmarkSvoSolidSubtrees(SvoImport* svo, float rootScale, int lvl) {
+    printf("[solid subtrees] level %d, all LODs, single thread\n", lvl);
+    TimeSvoSolidSubtrees("model", svo, rootScale, lvl);
+    
+    TempArenaMemory arena = TempArenaMemoryBegin(&tempAllocator);
+    
+    int side = 1 << lvl;
+    float radius = side * 0.45f;
+    Vector3Int* voxels = ALLOC_ARRAY(TempAllocator, Vector3Int, side * side * side);
+    int voxelCount = 0;
+    for (int z = 0; z < side; z++) {
+        for (int y = 0; y < side; y++) {
+            for (int x = 0; x < side; x++) {
+                Vector3 d = { x + 0.5f - side * 0.5f, y + 0.5f - side * 0.5f, z + 0.5f - side * 0.5f };
+                if (DotProduct(d, d) < radius * radius) {
+                    voxels[voxelCount++] = Vector3Int{ x, y, z };
+                }
+            }
+        }
+    }
+    SvoImport ball = BuildSvoFromVoxels(voxels, voxelCount, lvl, HeapAlloc);
+    TimeSvoSolidSubtrees("solid ball", &ball, rootScale, lvl);
+    
+    FreeSvo(&ball, HeapFree);
+    TempArenaMemoryEnd(arena);
+}
+
+// Cost of flooding the exterior of the SVO and the LOD 0 triangles that meshing only the faces towards it removes, 
+// for both meshers with ambient occlusion on like the game.
+void BenchmarkSvoExterior(SvoImport* svo, float rootScale, int lvl) {
+    TempArenaMemory arena = TempArenaMemoryBegin(&tempAllocator);
+    
+    SvoChunkGrid grid;
+    InitSvoChunkGrid(&grid, lvl, SVO_MESH_CHUNK_SHIFT, SVO_MESH_MAX_LODS, rootScale, TempAllocator);
+    InitSvoGameSettings(&grid);
+    
+    // Best of 3.
+    SvoExterior exterior = {};
+    double floodTime = DBL_MAX;
+    for (int run = 0; run < 3; run++) {
+        double start = CurrentTimeInSeconds();
+        UpdateSvoExterior(svo, &grid, &exterior);
+        double time = CurrentTimeInSeconds() - start;
+        if (time < floodTime) {
+            floodTime = time;
+        }
+    }
+    u64 cavityVoxels = 0;
+    for (u32 i = 0; i < grid.chunkCount; i++) {
+        cavityVoxels += exterior.cavityCounts[i];
+    }
+    printf("[exterior] level %d, %u empty blocks reached from outside, %llu cavity voxels, %.3f ms to flood and count\n", 
+           lvl, exterior.blockCount, (unsigned long long)cavityVoxels, floodTime * 1000.0);
+    
+    for (int mesher = SvoMesher_Cubes; mesher <= SvoMesher_SurfaceNets; mesher++) {
+        grid.mesher = (SvoMesher)mesher;
+        SvoMeshBuffer mesh = AllocSvoMeshOutput();
+        SvoMeshStats stats[2];
+        double times[2];
+        for (int exteriorOnly = 0; exteriorOnly < 2; exteriorOnly++) {
+            grid.exterior = exteriorOnly ? &exterior : 0;
+            times[exteriorOnly] = TimeMeshSvo(svo, &grid, 1, &mesh, &stats[exteriorOnly]);
+        }
+        
+        u32 removed = (stats[0].quadCount - stats[1].quadCount) * 2;
+        printf("    %-13s %10u triangles at LOD 0, %10u exterior only, %10u removed (%4.1f%%), %8.3f ms to mesh, %8.3f ms exterior only\n",
+               (mesher == SvoMesher_Cubes) ? "cubes:" : "surface nets:", stats[0].quadCount * 2, stats[1].quadCount * 2, removed, 
+               stats[0].quadCount ? 100.0 * removed / (stats[0].quadCount * 2) : 0.0, times[0] * 1000.0, times[1] * 1000.0);
+        FreeSvoMeshBuffer(&mesh);
+    }
+    
+    FreeSvoExterior(&exterior);
+    TempArenaMemoryEnd(arena);
+}
+
+// What a FIFO post-transform vertex cache does with the chunk meshes of one LOD, each drawn on its own with the
+// cache empty. ACMR is misses per triangle, 0.5 at best for a large grid. ATVR is misses per vertex, 1 at best.
+struct SvoVertexCacheStats {
+    u64 triangleCount;
+    u64 vertexCount;
+    u64 missCount;
+};
+
+void SimulateSvoVertexCache(SvoChunkGrid* grid, SvoMeshBuffer* mesh, int lod, u32 cacheSize, SvoVertexCacheStats* stats) {
+    TempArenaMemory arena = TempArenaMemoryBegin(&tempAllocator);
+    
+    u32 maxVertexCount = 0;
+    for (u32 i = 0; i < grid->chunkCount; i++) {
+        maxVertexCount = Max(maxVertexCount, grid->chunks[i].lods[lod].vertexCount);
+    }
+    
+    // The FIFO never moves a vertex on a hit, so a vertex is still in it while fewer than cacheSize misses came 
+    // after the one that loaded it.
+    u32* loadedAt = ALLOC_ARRAY(TempAllocator, u32, maxVertexCount);
+    ZeroStruct(stats);
+    for (u32 i = 0; i < grid->chunkCount; i++) {
+        SvoChunkMesh* chunkMesh = &grid->chunks[i].lods[lod];
+        memset(loadedAt, 0xFF, chunkMesh->vertexCount * sizeof(u32));
+        u32 missCount = 0;
+        for (u32 j = 0; j < chunkMesh->indexCount; j++) {
+            u32 v = (chunkMesh->indexFormat == IndexFormat_U16) ? mesh->shortIndices[chunkMesh->firstIndex + j] : mesh->indices[chunkMesh->firstIndex + j];
+            if (loadedAt[v] == 0xFFFFFFFF || missCount - loadedAt[v] >= cacheSize) {
+                loadedAt[v] = missCount++;
+            }
+        }
+        stats->triangleCount += chunkMesh->indexCount / 3;
+        stats->vertexCount += chunkMesh->vertexCount;
+        stats->missCount += missCount;
+    }
+    
+    TempArenaMemoryEnd(arena);
+}
+
+// Order independent sum of the triangles from start to end of a chunk mesh, by their vertices and winding.
+u64 SvoTriangleChecksum(SvoMeshBuffer* mesh, SvoChunkMesh* chunkMesh, u32 start, u32 end) {
+    u64 sum = 0;
+    for (u32 i = start; i < end; i += 3) {
+        u64 keys[3];
+        for (int j = 0; j < 3; j++) {
+            u32 v = (chunkMesh->indexFormat == IndexFormat_U16) ? mesh->shortIndices[chunkMesh->firstIndex + i + j] : mesh->indices[chunkMesh->firstIndex + i + j];
+            memcpy(&keys[j], &mesh->vertices[chunkMesh->firstVertex + v], sizeof(u64));
+        }
+        
+        // Start at the smallest key so every rotation of the triangle hashes the same.
+        int first = (keys[1] < keys[0]) ? 1 : 0;
+        first = (keys[2] < keys[first]) ? 2 : first;
+        u64 hash = 0;
+        for (int j = 0; j < 3; j++) {
+            hash = (hash ^ keys[(first + j) % 3]) * 0x9E3779B97F4A7C15ull;
+            hash ^= hash >> 29;
+        }
+        sum += hash;
+    }
+    return sum;
+}
+
+// Vertex cache misses before and after OptimizeSvoVertexCache() at LOD 0 for FIFO caches of 16 and 32 vertices,
+// and what it adds to meshing every LOD on 1 thread. Both orders must hold the same triangles in every bucket.
+void BenchmarkSvoVertexCache(SvoImport* svo, float rootScale, int lvl) {
+    TempArenaMemory arena = TempArenaMemoryBegin(&tempAllocator);
+    
+    printf("[vertex cache] level %d, ACMR and ATVR at LOD 0 for 16 and 32 vertex FIFOs, optimized for %d\n", lvl, SVO_MESH_VERTEX_CACHE_SIZE);
+    for (int mesher = SvoMesher_Cubes; mesher <= SvoMesher_SurfaceNets; mesher++) {
+        SvoChunkGrid grids[2];
+        SvoMeshBuffer meshes[2];
+        double times[2];
+        SvoMeshStats stats;
+        for (int optimized = 0; optimized < 2; optimized++) {
+            SvoChunkGrid* grid = &grids[optimized];
+            InitSvoChunkGrid(grid, lvl, SVO_MESH_CHUNK_SHIFT, SVO_MESH_MAX_LODS, rootScale, TempAllocator);
+            InitSvoGameSettings(grid);
+            grid->mesher = (SvoMesher)mesher;
+            grid->optimizeVertexCache = (optimized == 1);
+            meshes[optimized] = AllocSvoMeshOutput();
+            times[optimized] = TimeMeshSvo(svo, grid, 1, &meshes[optimized], &stats);
+        }
+        
+        bool same = true;
+        for (u32 i = 0; i < grids[0].chunkCount * grids[0].lodCount && same; i++) {
+            SvoChunkMesh* a = &grids[0].chunks[i / grids[0].lodCount].lods[i % grids[0].lodCount];
+            SvoChunkMesh* b = &grids[1].chunks[i / grids[1].lodCount].lods[i % grids[1].lodCount];
+            same = a->indexCount == b->indexCount && a->vertexCount == b->vertexCount &&
+                   memcmp(a->faceIndexCounts, b->faceIndexCounts, sizeof(a->faceIndexCounts)) == 0;
+            u32 end = a->indexCount;
+            for (int bucket = SvoFace_Count; bucket >= 0 && same; bucket--) {
+                u32 start = (bucket > 0) ? end - a->faceIndexCounts[bucket - 1] : 0;
+                same = SvoTriangleChecksum(&meshes[0], a, start, end) == SvoTriangleChecksum(&meshes[1], b, start, end);
+                end = start;
+            }
+        }
+        
+        printf("    %s\n", (mesher == SvoMesher_Cubes) ? "cubes with ambient occlusion:" : "surface nets:");
+        for (int optimized = 0; optimized < 2; optimized++) {
+            printf("        %-9s", optimized ? "tipsify:" : "meshed:");
+            u32 cacheSizes[2] = { 16, 32 };
+            for (int i = 0; i < 2; i++) {
+                SvoVertexCacheStats cache;
+                SimulateSvoVertexCache(&grids[optimized], &meshes[optimized], 0, cacheSizes[i], &cache);
+                printf(" ACMR %5.3f ATVR %5.3f,", cache.triangleCount ? (double)cache.missCount / cache.triangleCount : 0.0,
+                       cache.vertexCount ? (double)cache.missCount / cache.vertexCount : 0.0);
+            }
+            if (optimized) {
+                printf(" %8.3f ms, %+.1f%% meshing time, %s\n", times[1] * 1000.0, (times[1] / times[0] - 1.0) * 100.0, 
+                       same ? "same triangles" : "TRIANGLES DIFFER");
+            } else {
+                printf(" %8.3f ms\n", times[0] * 1000.0);
+            }
+        }
+        
+        FreeSvoMeshBuffer(&meshes[0]);
+        FreeSvoMeshBuffer(&meshes[1]);
+    }
+    
+    TempArenaMemoryEnd(arena);
+}
+
+// Counts the triangles of the drawn LODs that ranges leave out although they could be seen: in front of the camera
+// on their outer side with a corner inside the frustum. A point on a plane counts as outside, the rasterizer would 
+// not draw it either.
+u32 CountVisibleCulledSvoTriangles(SvoChunkGrid* grid, SvoMeshBuffer* mesh, SvoDrawRange* ranges, u32 rangeCount, 
+                                   Vector3 camera, SvoFrustum* frustum) {
+    TempArenaMemory arena = TempArenaMemoryBegin(&tempAllocator);
+    
+    // A flag per index, only the first of every triangle is looked at.
+    bool* drawnShort = ALLOC_ARRAY(TempAllocator, bool, mesh->shortIndexCount);
+    bool* drawn = ALLOC_ARRAY(TempAllocator, bool, mesh->indexCount);
+    memset(drawnShort, 0, mesh->shortIndexCount * sizeof(bool));
+    memset(drawn, 0, mesh->indexCount * sizeof(bool));
+    for (u32 i = 0; i < rangeCount; i++) {
+        bool* flags = (ranges[i].indexFormat == IndexFormat_U16) ? drawnShort : drawn;
+        memset(flags + ranges[i].firstIndex, 1, ranges[i].indexCount * sizeof(bool));
+    }
+    
+    float unit = SvoMeshUnit(grid);
+    u32 visible = 0;
+    for (u32 i = 0; i < grid->chunkCount; i++) {
+        SvoChunkMesh* chunkMesh = &grid->chunks[i].lods[grid->chunks[i].lod];
+        bool* flags = (chunkMesh->indexFormat == IndexFormat_U16) ? drawnShort : drawn;
+        for (u32 j = 0; j < chunkMesh->indexCount; j += 3) {
+            u32 index = chunkMesh->firstIndex + j;
+            if (flags[index]) {
+                continue;
+            }
+            
+            Vector3 p[3];
+            for (int k = 0; k < 3; k++) {
+                u32 vertex = (chunkMesh->indexFormat == IndexFormat_U16) ? mesh->shortIndices[index + k] : mesh->indices[index + k];
+                Vertex_Voxel* v = &mesh->vertices[chunkMesh->firstVertex + vertex];
+                p[k] = Vector3{ (float)v->x, (float)v->y, (float)v->z } * unit;
+            }
+            
+            Vector3 normal = CrossProduct(p[1] - p[0], p[2] - p[0]);
+            bool facing = DotProduct(p[0] - camera, normal) < 0;
+            bool inside = false;
+            for (int k = 0; k < 3 && !inside; k++) {
+                inside = SvoBoxInFrustum(frustum, p[k], p[k]);
+            }
+            if (facing && inside) {
+                visible++;
+            }
+        }
+    }
+    
+    TempArenaMemoryEnd(arena);
+    return visible;
+}
+
+// Culls the chunk meshes of all LODs by direction buckets only and then with the clusters too, for a few cameras 
+// looking along the axes, and checks that nothing left out could be seen. Corners that poke into the frustum while 
+// the triangle covers none of it are missed, so this only catches culling that is wrong outright.
+void BenchmarkSvoClusters(SvoImport* svo, float rootScale, int lvl, float lodDistance) {
+    TempArenaMemory arena = TempArenaMemoryBegin(&tempAllocator);
+    
+    SvoChunkGrid grid;
+    InitSvoChunkGrid(&grid, lvl, SVO_MESH_CHUNK_SHIFT, SVO_MESH_MAX_LODS, rootScale, TempAllocator);
+    InitSvoGameSettings(&grid);
+    SvoMeshBuffer mesh = AllocSvoMeshOutput();
+    SvoMeshStats stats;
+    MeshSvo(svo, &grid, 1, &mesh, &stats);
+    
+    printf("[culling] level %d, %u clusters of up to %d triangles for all LODs\n", lvl, mesh.clusterCount, SVO_MESH_CLUSTER_TRIANGLES);
+    
+    Vector3 cameras[] = {
+        { rootScale * 0.5f, rootScale * 0.5f, rootScale * 0.5f },
+        { -rootScale * 0.5f, rootScale * 0.5f, rootScale * 0.5f },
+    };
+    const char* cameraNames[] = { "center", "outside" };
+    Vector3 forwards[] = { {1, 0, 0}, {-1, 0, 0}, {0, 0, 1}, {0, 0, -1} };
+    const char* forwardNames[] = { "+x", "-x", "+z", "-z" };
+    
+    Matrix4 projection = PerspectiveLH(16.0f / 9.0f, DegreesToRadians(90), 0.001f, 100.0f);
+    SvoDrawRange* ranges = ALLOC_ARRAY(TempAllocator, SvoDrawRange, mesh.clusterCount);
+    for (u32 i = 0; i < countOf(cameras); i++) {
+        SelectSvoChunkLods(&grid, cameras[i], lodDistance, UINT32_MAX);
+        for (u32 f = 0; f < countOf(forwards); f++) {
+            Matrix4 view = LookToLH(cameras[i], forwards[f], Vector3{0, 1, 0});
+            SvoFrustum frustum = SvoFrustumFromMatrix(view * projection);
+            printf("    camera %-8s %s:\n", cameraNames[i], forwardNames[f]);
+            
+            for (int mode = SvoCull_Directions; mode <= SvoCull_Clusters; mode++) {
+                SvoCullStats cull;
+                double start = CurrentTimeInSeconds();
+                u32 rangeCount = CullSvoClusters(&grid, mesh.clusters, true, (SvoCullMode)mode, cameras[i], &frustum, ranges, &cull);
+                double time = CurrentTimeInSeconds() - start;
+                u32 visible = CountVisibleCulledSvoTriangles(&grid, &mesh, ranges, rangeCount, cameras[i], &frustum);
+                
+                u32 culled = cull.directionTriangles + cull.frustumTriangles + cull.backfaceTriangles;
+                printf("        %-10s %9u of %9u triangles culled (%4.1f%%), %9u by direction, %9u frustum, %9u facing away, %6u draws, %.3f ms, %s\n", 
+                       (mode == SvoCull_Directions) ? "directions" : "clusters", culled, cull.triangleCount, 
+                       cull.triangleCount ? 100.0 * culled / cull.triangleCount : 0.0, cull.directionTriangles, cull.frustumTriangles, 
+                       cull.backfaceTriangles, cull.drawCount, time * 1000.0, (visible == 0) ? "no visible triangle culled" : "VISIBLE TRIANGLES CULLED");
+            }
+        }
+    }
+    
+    FreeSvoMeshBuffer(&mesh);
+    TempArenaMemoryEnd(arena);
+}
+
+// Voxel and face mask in one sortable key, z first.
+u64 SvoInstanceKey(int x, int y, int z, u32 faces) {
+    return ((u64)z << 38) | ((u64)y << 22) | ((u64)x << 6) | faces;
+}
+
+// Counts the exposed faces of the instances outside ranges that could be seen: in front of the camera on their outer 
+// side with a corner inside the frustum, like CountVisibleCulledSvoTriangles().
+u32 CountVisibleCulledSvoInstances(SvoInstanceBuffer* buffer, SvoInstanceRange* ranges, u32 rangeCount, float unit, 
+                                   Vector3 camera, SvoFrustum* frustum) {
+    TempArenaMemory arena = TempArenaMemoryBegin(&tempAllocator);
+    
+    bool* drawn = ALLOC_ARRAY(TempAllocator, bool, buffer->instanceCount);
+    memset(drawn, 0, buffer->instanceCount * sizeof(bool));
+    for (u32 i = 0; i < rangeCount; i++) {
+        memset(drawn + ranges[i].firstInstance, 1, ranges[i].instanceCount * sizeof(bool));
+    }
+    
+    u32 visible = 0;
+    for (u32 i = 0; i < buffer->instanceCount; i++) {
+        Instance_Voxel* instance = &buffer->instances[i];
+        if (drawn[i]) {
+            continue;
+        }
+        
+        float lo[3] = { instance->x * unit, instance->y * unit, instance->z * unit };
+        float cameraAxis[3] = { camera.x, camera.y, camera.z };
+        for (int direction = 0; direction < SvoFace_Count; direction++) {
+            if (!(instance->faces & (1 << direction))) {
+                continue;
+            }
+            
+            // The face's plane and the box of its 4 corners.
+            int axis = direction >> 1;
+            float plane = lo[axis] + (((direction & 1) == 0) ? unit : 0.0f);
+            bool facing = ((direction & 1) == 0) ? (cameraAxis[axis] > plane) : (cameraAxis[axis] < plane);
+            Vector3 min = { lo[0], lo[1], lo[2] };
+            Vector3 max = { lo[0] + unit, lo[1] + unit, lo[2] + unit };
+            float* minAxis = &min.x;
+            float* maxAxis = &max.x;
+            minAxis[axis] = plane;
+            maxAxis[axis] = plane;
+            if (facing && SvoBoxInFrustum(frustum, min, max)) {
+                visible++;
+            }
+        }
+    }
+    
+    TempArenaMemoryEnd(arena);
+    return visible;
+}
+
+// Build time and memory of the surface voxel instances against the chunk meshes PackSvoMesh() builds with the game's
+// settings, and against LOD 0 meshed without ambient occlusion, which is all the instances cover. All on 1 thread. 
+// The instances must have the face masks ComputeSvoFaceMasks() gives every voxel, and culling them for a few cameras 
+// must not leave out a face that could be seen.
+void BenchmarkSvoInstances(SvoImport* svo, float rootScale, int lvl) {
+    TempArenaMemory arena = TempArenaMemoryBegin(&tempAllocator);
+    
+    printf("[instances] level %d, 1 thread\n", lvl);
+    
+    const char* meshNames[] = { "PackSvoMesh", "LOD 0, no AO" };
+    SvoChunkGrid grids[2];
+    for (int i = 0; i < 2; i++) {
+        SvoChunkGrid* grid = &grids[i];
+        InitSvoChunkGrid(grid, lvl, SVO_MESH_CHUNK_SHIFT, (i == 0) ? SVO_MESH_MAX_LODS : 1, rootScale, TempAllocator);
+        InitSvoGameSettings(grid);
+        grid->ambientOcclusion = (i == 0);
+        
+        SvoMeshBuffer mesh = AllocSvoMeshOutput();
+        SvoMeshStats stats;
+        double best = TimeMeshSvo(svo, grid, 1, &mesh, &stats);
+        
+        u64 gpuBytes = (u64)mesh.vertexCount * sizeof(Vertex_Voxel) + (u64)mesh.shortIndexCount * sizeof(u16) + (u64)mesh.indexCount * sizeof(u32);
+        printf("    %-13s %8.3f ms, %10u triangles at LOD 0, %8.2f MB GPU, %8.2f MB clusters\n", meshNames[i], best * 1000.0, 
+               stats.quadCount * 2, gpuBytes / (double)MEGABYTES(1), mesh.clusterCount * sizeof(SvoMeshCluster) / (double)MEGABYTES(1));
+        FreeSvoMeshBuffer(&mesh);
+    }
+    
+    SvoInstanceBuffer instances = {};
+    double instanceTime = DBL_MAX;
+    for (int run = 0; run < 3; run++) {
+        double start = CurrentTimeInSeconds();
+        BuildSvoInstances(svo, &grids[0], &instances);
+        double time = CurrentTimeInSeconds() - start;
+        if (time < instanceTime) {
+            instanceTime = time;
+        }
+    }
+    
+    // Every voxel with an exposed face must be an instance with its face mask.
+    u32 voxelCount = svo->nodesAtLevel[lvl];
+    u8* faceMasks = ALLOC_ARRAY(TempAllocator, u8, voxelCount);
+    Vector3Int* coords = ALLOC_ARRAY(TempAllocator, Vector3Int, voxelCount);
+    SvoNodeNeighbors rootNeighbors;
+    memset(&rootNeighbors, 0xFF, sizeof(rootNeighbors));
+    ComputeSvoFaceMasks(svo, lvl, 0, 0, Vector3Int{0, 0, 0}, &rootNeighbors, faceMasks, coords);
+    u64* expected = ALLOC_ARRAY(TempAllocator, u64, voxelCount);
+    u32 expectedCount = 0;
+    for (u32 i = 0; i < voxelCount; i++) {
+        if (faceMasks[i]) {
+            expected[expectedCount++] = SvoInstanceKey(coords[i].x, coords[i].y, coords[i].z, faceMasks[i]);
+        }
+    }
+    u64* keys = ALLOC_ARRAY(TempAllocator, u64, instances.instanceCount);
+    for (u32 i = 0; i < instances.instanceCount; i++) {
+        Instance_Voxel* instance = &instances.instances[i];
+        keys[i] = SvoInstanceKey(instance->x, instance->y, instance->z, instance->faces);
+    }
+    qsort(expected, expectedCount, sizeof(u64), CompareU64);
+    qsort(keys, instances.instanceCount, sizeof(u64), CompareU64);
+    bool same = (expectedCount == instances.instanceCount) && memcmp(expected, keys, expectedCount * sizeof(u64)) == 0;
+    
+    u64 instanceBytes = (u64)instances.instanceCount * sizeof(Instance_Voxel);
+    printf("    %-13s %8.3f ms, %10u instances with %u faces, %8.2f MB GPU, %8.2f MB clusters (%u), %s\n", "instances", 
+           instanceTime * 1000.0, instances.instanceCount, instances.faceCount, instanceBytes / (double)MEGABYTES(1),
+           instances.clusterCount * sizeof(SvoInstanceCluster) / (double)MEGABYTES(1), instances.clusterCount,
+           same ? "same faces as every voxel's face mask" : "FACES DIFFER");
+    
+    Vector3 cameras[] = {
+        { rootScale * 0.5f, rootScale * 0.5f, rootScale * 0.5f },
+        { -rootScale * 0.5f, rootScale * 0.5f, rootScale * 0.5f },
+    };
+    const char* cameraNames[] = { "center", "outside" };
+    Vector3 forwards[] = { {1, 0, 0}, {-1, 0, 0}, {0, 0, 1}, {0, 0, -1} };
+    const char* forwardNames[] = { "+x", "-x", "+z", "-z" };
+    
+    Matrix4 projection = PerspectiveLH(16.0f / 9.0f, DegreesToRadians(90), 0.001f, 100.0f);
+    SvoInstanceRange* ranges = ALLOC_ARRAY(TempAllocator, SvoInstanceRange, instances.clusterCount);
+    float unit = rootScale / (1 << lvl);
+    for (u32 i = 0; i < countOf(cameras); i++) {
+        for (u32 f = 0; f < countOf(forwards); f++) {
+            Matrix4 view = LookToLH(cameras[i], forwards[f], Vector3{0, 1, 0});
+            SvoFrustum frustum = SvoFrustumFromMatrix(view * projection);
+            
+            SvoInstanceCullStats cull;
+            double start = CurrentTimeInSeconds();
+            u32 rangeCount = CullSvoInstances(&instances, cameras[i], &frustum, ranges, &cull);
+            double time = CurrentTimeInSeconds() - start;
+            u32 visible = CountVisibleCulledSvoInstances(&instances, ranges, rangeCount, unit, cameras[i], &frustum);
+            
+            u32 culled = cull.frustumInstances + cull.backfaceInstances;
+            printf("    camera %-8s %s: %9u of %9u instances culled (%4.1f%%), %9u frustum, %9u facing away, %9u faces drawn, %6u draws, %.3f ms, %s\n", 
+                   cameraNames[i], forwardNames[f], culled, cull.instanceCount, cull.instanceCount ? 100.0 * culled / cull.instanceCount : 0.0,
+                   cull.frustumInstances, cull.backfaceInstances, cull.drawnFaceCount, cull.drawCount, time * 1000.0, 
+                   (visible == 0) ? "no visible face culled" : "VISIBLE FACES CULLED");
+        }
+    }
+    
+    FreeSvoInstanceBuffer(&instances);
+    TempArenaMemoryEnd(arena);
+}
+
+// The face culling PackSvoMesh used before neighbor propagation: six IsFilled descents from the root per voxel.
+void ComputeSvoFaceMasksIsFilled(SvoImport* svo, int lvl, Vector3Int* coords, u8* faceMasks, u32 count) {
+    for (u32 i = 0; i < count; i++) {
+        Vector3Int c = coords[i];
+        u8 faceMask = 0;
+        if (!IsFilled(svo, lvl, Vector3Int{c.x + 1, c.y, c.z})) { faceMask |= 1 << SvoFace_PositiveX; }
+        if (!IsFilled(svo, lvl, Vector3Int{c.x - 1, c.y, c.z})) { faceMask |= 1 << SvoFace_NegativeX; }
+        if (!IsFilled(svo, lvl, Vector3Int{c.x, c.y + 1, c.z})) { faceMask |= 1 << SvoFace_PositiveY; }
+        if (!IsFilled(svo, lvl, Vector3Int{c.x, c.y - 1, c.z})) { faceMask |= 1 << SvoFace_NegativeY; }
+        if (!IsFilled(svo, lvl, Vector3Int{c.x, c.y, c.z + 1})) { faceMask |= 1 << SvoFace_PositiveZ; }
+        if (!IsFilled(svo, lvl, Vector3Int{c.x, c.y, c.z - 1})) { faceMask |= 1 << SvoFace_NegativeZ; }
+        faceMasks[i] = faceMask;
+    }
+}
+
+// Face culling of every voxel at lvl, with IsFilled and with neighbor propagation from the root.
+void BenchmarkSvoFaceMasks(SvoImport* svo, int lvl) {
+    TempArenaMemory arena = TempArenaMemoryBegin(&tempAllocator);
+    
+    u32 voxelCount = svo->nodesAtLevel[lvl];
+    u8* reference = ALLOC_ARRAY(TempAllocator, u8, voxelCount);
+    u8* faceMasks = ALLOC_ARRAY(TempAllocator, u8, voxelCount);
+    Vector3Int* coords = ALLOC_ARRAY(TempAllocator, Vector3Int, voxelCount);
+    
+    SvoNodeNeighbors rootNeighbors;
+    memset(&rootNeighbors, 0xFF, sizeof(rootNeighbors));
+    double start = CurrentTimeInSeconds();
+    ComputeSvoFaceMasks(svo, lvl, 0, 0, Vector3Int{0, 0, 0}, &rootNeighbors, faceMasks, coords);
+    double propagateTime = CurrentTimeInSeconds() - start;
+    
+    start = CurrentTimeInSeconds();
+    ComputeSvoFaceMasksIsFilled(svo, lvl, coords, reference, voxelCount);
+    double isFilledTime = CurrentTimeInSeconds() - start;
+    
+    u32 faceCount = 0;
+    for (u32 i = 0; i < voxelCount; i++) {
+        faceCount += Popcount8(reference[i]);
+    }
+    
+    printf("[face culling] level %d, %u voxels, %u exposed faces\n", lvl, voxelCount, faceCount);
+    printf("    IsFilled:    %8.3f ms, %12.0f faces/s\n", isFilledTime * 1000.0, faceCount / isFilledTime);
+    printf("    propagated:  %8.3f ms, %12.0f faces/s, %.1fx, %s\n", propagateTime * 1000.0, faceCount / propagateTime,
+           isFilledTime / propagateTime, memcmp(reference, faceMasks, voxelCount) == 0 ? "same faces" : "FACES DIFFER");
+    
+    TempArenaMemoryEnd(arena);
+}
+
+// Chunk-wise equality of two meshes of the same grid, indices are chunk relative so the ranges can be anywhere.
+bool SameSvoChunkMeshes(SvoChunkGrid* a, SvoMeshBuffer* aMesh, SvoChunkGrid* b, SvoMeshBuffer* bMesh) {
+    for (u32 i = 0; i < a->chunkCount * a->lodCount; i++) {
+        SvoChunkMesh* ca = &a->chunks[i / a->lodCount].lods[i % a->lodCount];
+        SvoChunkMesh* cb = &b->chunks[i / b->lodCount].lods[i % b->lodCount];
+        if (ca->vertexCount != cb->vertexCount || ca->indexCount != cb->indexCount || ca->indexFormat != cb->indexFormat ||
+            ca->clusterCount != cb->clusterCount ||
+            memcmp(aMesh->vertices + ca->firstVertex, bMesh->vertices + cb->firstVertex, ca->vertexCount * sizeof(Vertex_Voxel)) != 0 ||
+            memcmp(aMesh->clusters + ca->firstCluster, bMesh->clusters + cb->firstCluster, ca->clusterCount * sizeof(SvoMeshCluster)) != 0) {
+            return false;
+        }
+        
+        bool sameIndices = (ca->indexFormat == IndexFormat_U16) ?
+            memcmp(aMesh->shortIndices + ca->firstIndex, bMesh->shortIndices + cb->firstIndex, ca->indexCount * sizeof(u16)) == 0 :
+            memcmp(aMesh->indices + ca->firstIndex, bMesh->indices + cb->firstIndex, ca->indexCount * sizeof(u32)) == 0;
+        if (!sameIndices) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Removes and re-adds the first voxel hit by random rays on a heap copy of the SVO, remeshing only the dirty chunks
+// after every edit the way the game does, and compares that to remeshing every chunk. At the end the incrementally
+// updated mesh must match a full remesh of the edited SVO chunk for chunk.
+void BenchmarkSvoEdits(SvoImport* svo, float rootScale, int lvl) {
+    TempArenaMemory arena = TempArenaMemoryBegin(&tempAllocator);
+    
+    u32 voxelCount = svo->nodesAtLevel[lvl];
+    Vector3Int* voxels = ALLOC_ARRAY(TempAllocator, Vector3Int, voxelCount);
+    SvoNodeNeighbors rootNeighbors;
+    memset(&rootNeighbors, 0xFF, sizeof(rootNeighbors));
+    SvoLeafIterator leaves;
+    BeginSvoLeaves(&leaves, svo, lvl, 0, 0, Vector3Int{0, 0, 0}, &rootNeighbors);
+    for (u32 i = 0; NextSvoLeaf(&leaves); i++) {
+        voxels[i] = leaves.coord;
+    }
+    SvoImport edited = BuildSvoFromVoxels(voxels, voxelCount, lvl, HeapAlloc);
+    
+    SvoChunkGrid grid;
+    InitSvoChunkGrid(&grid, lvl, SVO_MESH_CHUNK_SHIFT, SVO_MESH_MAX_LODS, rootScale, TempAllocator);
+    
+    // Leave room for the full mesh twice over, appended edits fill the rest until it is repacked. After that
+    // the buffer stops growing, like the GPU buffers of the game.
+    SvoMeshStats stats;
+    SvoMeshBuffer mesh = AllocSvoMeshOutput();
+    MeshSvo(&edited, &grid, 1, &mesh, &stats);
+    GrowSvoMeshBuffer(&mesh, mesh.vertexCount, mesh.indexCount, mesh.shortIndexCount, mesh.clusterCount);
+    mesh.reserve = 0;
+    ClearSvoMeshOutput(&mesh);
+    
+    double start = CurrentTimeInSeconds();
+    MeshSvo(&edited, &grid, 1, &mesh, &stats);
+    double fullTime = CurrentTimeInSeconds() - start;
+    
+    int editCount = 200;
+    int rayCount = 4 * editCount;
+    u32 state = 777;
+    Vector3* origins = ALLOC_ARRAY(TempAllocator, Vector3, rayCount);
+    Vector3* directions = ALLOC_ARRAY(TempAllocator, Vector3, rayCount);
+    BenchRandomRays(&state, rootScale, origins, directions, rayCount);
+    
+    int edits = 0;
+    int repacks = 0;
+    u32 chunkCount = 0;
+    double editTime = 0;
+    double maxEditTime = 0;
+    for (int i = 0; i < rayCount && edits < editCount; i++) {
+        SvoRayHit hit;
+        if (SvoRaycast(&edited, rootScale, lvl, origins[i], directions[i], 0.0f, FLT_MAX, StoreFirstSvoRayHit, &hit) == 0) {
+            continue;
+        }
+        
+        for (int pass = 0; pass < 2; pass++) {
+            double editStart = CurrentTimeInSeconds();
+            SetSvoVoxel(&edited, lvl, hit.c, pass == 1, HeapAllocator);
+            MarkSvoVoxelDirty(&grid, hit.c);
+            int remeshed = RemeshDirtySvoChunks(&edited, &grid, 1, &mesh, &stats);
+            double time = CurrentTimeInSeconds() - editStart;
+            
+            // Buffer full: repack like the game does and leave this edit out of the timings.
+            if (remeshed < 0) {
+                ClearSvoMeshOutput(&mesh);
+                MeshSvo(&edited, &grid, 1, &mesh, &stats);
+                repacks++;
+                continue;
+            }
+            
+            chunkCount += remeshed;
+            editTime += time;
+            if (time > maxEditTime) {
+                maxEditTime = time;
+            }
+            edits++;
+        }
+    }
+    
+    SvoChunkGrid fullGrid;
+    InitSvoChunkGrid(&fullGrid, lvl, SVO_MESH_CHUNK_SHIFT, SVO_MESH_MAX_LODS, rootScale, TempAllocator);
+    SvoMeshBuffer fullMesh = AllocSvoMeshOutput();
+    MeshSvo(&edited, &fullGrid, 1, &fullMesh, &stats);
+    bool same = SameSvoChunkMeshes(&grid, &mesh, &fullGrid, &fullMesh);
+    
+    printf("[edits] level %d, %d^3 voxel chunks, %d edits, %.1f chunks per edit, %d repacks when the buffer was full\n", lvl, grid.chunkSize, 
+           edits, edits ? (double)chunkCount / edits : 0.0, repacks);
+    printf("    full remesh:  %8.3f ms\n", fullTime * 1000.0);
+    printf("    edit+remesh:  %8.3f ms avg, %8.3f ms max, %.0fx faster, %s\n", edits ? editTime * 1000.0 / edits : 0.0, 
+           maxEditTime * 1000.0, edits ? fullTime * edits / editTime : 0.0, same ? "same mesh" : "MESH DIFFERS");
+    
+    FreeSvoMeshBuffer(&mesh);
+    FreeSvoMeshBuffer(&fullMesh);
+    FreeSvo(&edited, HeapFree);
+    
+    TempArenaMemoryEnd(arena);
+}
+
+// Chunk-wise equality of a mesh of grid and one of the same SVO meshed with shared repeats: the shared meshes moved to
+// their chunk's origin must be the same vertices, indices and clusters.
+bool SameSvoSharedMeshes(SvoChunkGrid* grid, SvoMeshBuffer* mesh, SvoChunkGrid* sharedGrid, SvoMeshBuffer* sharedMesh) {
+    float unit = SvoMeshUnit(grid);
+    for (u32 i = 0; i < grid->chunkCount * grid->lodCount; i++) {
+        u32 chunk = i / grid->lodCount;
+        SvoChunkMesh* a = &grid->chunks[chunk].lods[i % grid->lodCount];
+        SvoChunkMesh* b = &sharedGrid->chunks[chunk].lods[i % grid->lodCount];
+        if (a->vertexCount != b->vertexCount || a->indexCount != b->indexCount || a->indexFormat != b->indexFormat ||
+            a->clusterCount != b->clusterCount || memcmp(a->faceIndexCounts, b->faceIndexCounts, sizeof(a->faceIndexCounts)) != 0) {
+            return false;
+        }
+        
+        Vector3Int origin = SvoChunkMeshOrigin(sharedGrid, chunk);
+        for (u32 v = 0; v < a->vertexCount; v++) {
+            Vertex_Voxel va = mesh->vertices[a->firstVertex + v];
+            Vertex_Voxel vb = sharedMesh->vertices[b->firstVertex + v];
+            if (va.x != vb.x + origin.x || va.y != vb.y + origin.y || va.z != vb.z + origin.z || va.face != vb.face) {
+                return false;
+            }
+        }
+        
+        bool sameIndices = (a->indexFormat == IndexFormat_U16) ?
+            memcmp(mesh->shortIndices + a->firstIndex, sharedMesh->shortIndices + b->firstIndex, a->indexCount * sizeof(u16)) == 0 :
+            memcmp(mesh->indices + a->firstIndex, sharedMesh->indices + b->firstIndex, a->indexCount * sizeof(u32)) == 0;
+        if (!sameIndices) {
+            return false;
+        }
+        
+        // Bounds are scaled from the integer positions, so the moved ones can be off by rounding.
+        Vector3 offset = Vector3{ (float)origin.x, (float)origin.y, (float)origin.z } * unit;
+        for (u32 c = 0; c < a->clusterCount; c++) {
+            SvoMeshCluster* ca = &mesh->clusters[a->firstCluster + c];
+            SvoMeshCluster* cb = &sharedMesh->clusters[b->firstCluster + c];
+            Vector3 dMin = ca->min - (cb->min + offset);
+            Vector3 dMax = ca->max - (cb->max + offset);
+            float error = Max(Max(Abs(dMin.x), Max(Abs(dMin.y), Abs(dMin.z))), Max(Abs(dMax.x), Max(Abs(dMax.y), Abs(dMax.z))));
+            if (ca->firstIndex != cb->firstIndex || ca->indexCount != cb->indexCount || ca->direction != cb->direction ||
+                memcmp(&ca->coneAxis, &cb->coneAxis, sizeof(Vector3)) != 0 || ca->coneCutoff != cb->coneCutoff || error > unit * 0.01f) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Meshing time and size of one SVO without and with shared repeats, with the game's settings on 1 thread, best of 3.
+// The shared meshes must be the same as the others once moved, on any thread count and after edits that remesh only 
+// the dirty chunks, which share with the meshes of the chunks that are kept as well.
+void TimeSvoRepeats(const char* name, SvoImport* svo, float rootScale, int lvl) {
+    TempArenaMemory arena = TempArenaMemoryBegin(&tempAllocator);
+    
+    SvoChunkGrid grids[2];
+    SvoMeshBuffer meshes[2];
+    SvoMeshStats stats[2];
+    double times[2];
+    for (int shared = 0; shared < 2; shared++) {
+        SvoChunkGrid* grid = &grids[shared];
+        InitSvoChunkGrid(grid, lvl, SVO_MESH_CHUNK_SHIFT, SVO_MESH_MAX_LODS, rootScale, TempAllocator);
+        InitSvoGameSettings(grid);
+        grid->shareRepeats = (shared == 1);
+        meshes[shared] = AllocSvoMeshOutput();
+        times[shared] = TimeMeshSvo(svo, grid, 1, &meshes[shared], &stats[shared]);
+    }
+    bool same = SameSvoSharedMeshes(&grids[0], &meshes[0], &grids[1], &meshes[1]);
+    
+    // The same output on every thread count.
+    SvoMeshStats threadStats;
+    SvoMeshBuffer threadMesh = AllocSvoMeshOutput();
+    MeshSvo(svo, &grids[1], GetProcessorCount(), &threadMesh, &threadStats);
+    bool sameThreads = SameSvoMeshOutput(&meshes[1], &threadMesh);
+    FreeSvoMeshBuffer(&threadMesh);
+    
+    u32 meshCount = 0;
+    for (u32 i = 0; i < grids[0].chunkCount * grids[0].lodCount; i++) {
+        meshCount += (grids[0].chunks[i / grids[0].lodCount].lods[i % grids[0].lodCount].indexCount > 0) ? 1 : 0;
+    }
+    double bytes[2];
+    for (int shared = 0; shared < 2; shared++) {
+        SvoMeshBuffer* mesh = &meshes[shared];
+        bytes[shared] = (double)mesh->vertexCount * sizeof(Vertex_Voxel) + (double)mesh->shortIndexCount * sizeof(u16) + 
+                        (double)mesh->indexCount * sizeof(u32) + (double)mesh->clusterCount * sizeof(SvoMeshCluster);
+    }
+    printf("    %s: %u of %u chunk LODs with triangles shared (%.1f%%)\n", name, stats[1].sharedCount, meshCount, 
+           meshCount ? 100.0 * stats[1].sharedCount / meshCount : 0.0);
+    printf("        meshing:  %8.3f ms, %8.3f ms shared, %5.2fx\n", times[0] * 1000.0, times[1] * 1000.0, times[0] / times[1]);
+    printf("        memory:   %8.2f MB, %8.2f MB shared, %5.2fx, %s, %s\n", bytes[0] / MEGABYTES(1), bytes[1] / MEGABYTES(1), 
+           bytes[1] > 0 ? bytes[0] / bytes[1] : 0.0, same ? "same meshes at every chunk" : "MESHES DIFFER", 
+           sameThreads ? "same on every thread count" : "THREADS DIFFER");
+    
+    // Edits on a heap copy, remeshing the dirty chunks with sharing into room left after the mesh like the game.
+    u32 voxelCount = svo->nodesAtLevel[lvl];
+    Vector3Int* voxels = ALLOC_ARRAY(TempAllocator, Vector3Int, voxelCount);
+    SvoNodeNeighbors rootNeighbors;
+    memset(&rootNeighbors, 0xFF, sizeof(rootNeighbors));
+    SvoLeafIterator leaves;
+    BeginSvoLeaves(&leaves, svo, lvl, 0, 0, Vector3Int{0, 0, 0}, &rootNeighbors);
+    for (u32 i = 0; NextSvoLeaf(&leaves); i++) {
+        voxels[i] = leaves.coord;
+    }
+    SvoImport edited = BuildSvoFromVoxels(voxels, voxelCount, lvl, HeapAlloc);
+    
+    SvoMeshBuffer* mesh = &meshes[1];
+    GrowSvoMeshBuffer(mesh, mesh->vertexCount * 2, mesh->indexCount * 2, mesh->shortIndexCount * 2, mesh->clusterCount * 2);
+    mesh->reserve = 0;
+    ClearSvoMeshOutput(mesh);
+    MeshSvo(&edited, &grids[1], 1, mesh, &stats[1]);
+    
+    int rayCount = 200;
+    u32 state = 4242;
+    Vector3* origins = ALLOC_ARRAY(TempAllocator, Vector3, rayCount);
+    Vector3* directions = ALLOC_ARRAY(TempAllocator, Vector3, rayCount);
+    BenchRandomRays(&state, rootScale, origins, directions, rayCount);
+    
+    int edits = 0;
+    u32 editShared = 0;
+    for (int i = 0; i < rayCount; i++) {
+        SvoRayHit hit;
+        if (SvoRaycast(&edited, rootScale, lvl, origins[i], directions[i], 0.0f, FLT_MAX, StoreFirstSvoRayHit, &hit) == 0) {
+            continue;
+        }
+        SetSvoVoxel(&edited, lvl, hit.c, false, HeapAllocator);
+        MarkSvoVoxelDirty(&grids[1], hit.c);
+        if (RemeshDirtySvoChunks(&edited, &grids[1], 1, mesh, &stats[1]) < 0) {
+            ClearSvoMeshOutput(mesh);
+            MeshSvo(&edited, &grids[1], 1, mesh, &stats[1]);
+        } else {
+            editShared += stats[1].sharedCount;
+        }
+        edits++;
+    }
+    
+    ClearSvoMeshOutput(&meshes[0]);
+    MeshSvo(&edited, &grids[0], 1, &meshes[0], &stats[0]);
+    printf("        %d edits: %u remeshed chunk LODs shared, %s\n", edits, editShared, 
+           SameSvoSharedMeshes(&grids[0], &meshes[0], &grids[1], mesh) ? "same meshes at every chunk" : "MESHES DIFFER");
+    
+    FreeSvo(&edited, HeapFree);
+    FreeSvoMeshBuffer(&meshes[0]);
+    FreeSvoMeshBuffer(&meshes[1]);
+    TempArenaMemoryEnd(arena);
+}
+
+// Sharing the meshes of repeated chunks on the model and on tiled terrain, a 4 voxel thick height field sheet that 
+// repeats every period voxels along x and z. Tiles of the chunk size repeat in every chunk of a layer except at the 
+// border of the SVO, bigger tiles less often, and tiles that do not divide the chunk size only every few chunks.
+void BenchmarkSvoRepeats(SvoImport* svo, float rootScale, int lvl) {
+    printf("[repeats] level %d, all LODs, 1 thread\n", lvl);
+    TimeSvoRepeats("model", svo, rootScale, lvl);
+    
+    TempArenaMemory arena = TempArenaMemoryBegin(&tempAllocator);
+    
+    int side = 1 << lvl;
+    int periods[] = { 1 << SVO_MESH_CHUNK_SHIFT, 2 << SVO_MESH_CHUNK_SHIFT, 3 << (SVO_MESH_CHUNK_SHIFT - 1) };
+    Vector3Int* voxels = ALLOC_ARRAY(TempAllocator, Vector3Int, side * side * 4);
+    for (u32 p = 0; p < countOf(periods); p++) {
+        int period = periods[p];
+        int voxelCount = 0;
+        for (int z = 0; z < side; z++) {
+            for (int x = 0; x < side; x++) {
+                float u = TAU * (x % period) / period;
+                float v = TAU * (z % period) / period;
+                int height = side / 2 + (int)(side / 16 * sinf(u) * cosf(v));
+                for (int y = Max(0, height - 3); y <= height && y < side; y++) {
+                    voxels[voxelCount++] = Vector3Int{ x, y, z };
+                }
+            }
+        }
+        
+        char name[64];
+        snprintf(name, sizeof(name), "tiles of %d", period);
+        SvoImport tiles = BuildSvoFromVoxels(voxels, voxelCount, lvl, HeapAlloc);
+        TimeSvoRepeats(name, &tiles, rootScale, lvl);
+        FreeSvo(&tiles, HeapFree);
+    }
+    
+    TempArenaMemoryEnd(arena);
+}
+
+// Removes the first voxel the ray hits and marks its chunks dirty, the edit of the benchmarks below.
+bool RemoveSvoVoxelOnRay(SvoImport* svo, SvoChunkGrid* grid, Vector3 origin, Vector3 direction) {
+    SvoRayHit hit;
+    if (SvoRaycast(svo, grid->rootScale, grid->lvl, origin, direction, 0.0f, FLT_MAX, StoreFirstSvoRayHit, &hit) == 0) {
+        return false;
+    }
+    SetSvoVoxel(svo, grid->lvl, hit.c, false, HeapAllocator);
+    MarkSvoVoxelDirty(grid, hit.c);
+    return true;
+}
+
+// Edits and repacks with the remesh in the background the way the game runs them, against running them in the frame,
+// on a heap copy of the SVO with the game's mesh settings and the surface voxel instances drawn. The background side 
+// simulates frames at 60 FPS: a request is queued every 4 frames, every 8th one a repack with ambient occlusion toggled
+// and the rest edits, and every frame the calling thread takes over a finished remesh, copying its staging buffers 
+// into the mesh the game keeps on the GPU, a repack into the back one a slice per frame, then the instances the worker
+// built into the back instance array a slice per frame, then starts the next one with what was queued meanwhile. The 
+// time the calling thread spends on that is what a frame can hitch by, the latency runs from a request to the frame its
+// meshes are taken over in. At the end the mesh must match a full remesh chunk for chunk, and the instances a build
+// from the edited SVO.
+void BenchmarkSvoBackgroundRemesh(SvoImport* svo, float rootScale, int lvl) {
+    TempArenaMemory arena = TempArenaMemoryBegin(&tempAllocator);
+    
+    u32 voxelCount = svo->nodesAtLevel[lvl];
+    Vector3Int* voxels = ALLOC_ARRAY(TempAllocator, Vector3Int, voxelCount);
+    SvoNodeNeighbors rootNeighbors;
+    memset(&rootNeighbors, 0xFF, sizeof(rootNeighbors));
+    SvoLeafIterator leaves;
+    BeginSvoLeaves(&leaves, svo, lvl, 0, 0, Vector3Int{0, 0, 0}, &rootNeighbors);
+    for (u32 i = 0; NextSvoLeaf(&leaves); i++) {
+        voxels[i] = leaves.coord;
+    }
+    SvoImport edited = BuildSvoFromVoxels(voxels, voxelCount, lvl, HeapAlloc);
+    int threadCount = GetProcessorCount();
+    
+    SvoChunkGrid grids[2];
+    SvoMeshBuffer meshes[2];
+    SvoMeshStats stats;
+    for (int i = 0; i < 2; i++) {
+        InitSvoChunkGrid(&grids[i], lvl, SVO_MESH_CHUNK_SHIFT, SVO_MESH_MAX_LODS, rootScale, TempAllocator);
+        InitSvoGameSettings(&grids[i]);
+        
+        // Room for half the mesh more like the GPU buffers of the game, see ReserveSvoGpuBuffer().
+        meshes[i] = AllocSvoMeshOutput();
+        MeshSvo(&edited, &grids[i], threadCount, &meshes[i], &stats);
+        SvoMeshBuffer* mesh = &meshes[i];
+        GrowSvoMeshBuffer(mesh, mesh->vertexCount / 2, mesh->indexCount / 2, mesh->shortIndexCount / 2, mesh->clusterCount / 2);
+        mesh->reserve = 0;
+    }
+    
+    int requestCount = 64;
+    u32 state = 9001;
+    Vector3* origins = ALLOC_ARRAY(TempAllocator, Vector3, requestCount);
+    Vector3* directions = ALLOC_ARRAY(TempAllocator, Vector3, requestCount);
+    BenchRandomRays(&state, rootScale, origins, directions, requestCount);
+    
+    // In the frame, like the game did before: every edit remeshed right away, on every thread, and the instances rebuilt.
+    SvoInstanceBuffer frameInstances = {};
+    double instanceTime = 0;
+    int edits = 0;
+    int repacks = 0;
+    double editTime = 0;
+    double maxEditTime = 0;
+    double repackTime = 0;
+    for (int i = 0; i < requestCount; i++) {
+        double start = CurrentTimeInSeconds();
+        if (i % 8 == 7) {
+            grids[0].ambientOcclusion = !grids[0].ambientOcclusion;
+            ClearSvoMeshOutput(&meshes[0]);
+            MeshSvo(&edited, &grids[0], threadCount, &meshes[0], &stats);
+            double instanceStart = CurrentTimeInSeconds();
+            BuildSvoInstances(&edited, &grids[0], &frameInstances);
+            instanceTime += CurrentTimeInSeconds() - instanceStart;
+            repackTime += CurrentTimeInSeconds() - start;
+            repacks++;
+        } else if (RemoveSvoVoxelOnRay(&edited, &grids[0], origins[i], directions[i])) {
+            if (RemeshDirtySvoChunks(&edited, &grids[0], threadCount, &meshes[0], &stats) < 0) {
+                ClearSvoMeshOutput(&meshes[0]);
+                MeshSvo(&edited, &grids[0], threadCount, &meshes[0], &stats);
+            }
+            double instanceStart = CurrentTimeInSeconds();
+            BuildSvoInstances(&edited, &grids[0], &frameInstances);
+            instanceTime += CurrentTimeInSeconds() - instanceStart;
+            double time = CurrentTimeInSeconds() - start;
+            editTime += time;
+            if (time > maxEditTime) {
+                maxEditTime = time;
+            }
+            edits++;
+        }
+    }
+    
+    // The same requests in the background, along the lines of UpdateSvoRemesh(). Later rays hit the voxels behind
+    // the ones the first pass removed.
+    double frameTime = 1.0 / 60.0;
+    double* requestTimes = ALLOC_ARRAY(TempAllocator, double, requestCount);
+    int* requestFrames = ALLOC_ARRAY(TempAllocator, int, requestCount);
+    SvoRemesh remesh = {};
+    SvoChunkGrid* grid = &grids[1];
+    SvoMeshBuffer* mesh = &meshes[1];
+    SvoMeshBuffer backMesh = {};  // a repack is copied into it a slice per frame, then swapped with mesh
+    SvoInstanceBuffer instances = {};         // what the worker builds
+    SvoInstanceBuffer drawnInstances = {};    // swapped with instances once uploaded, the GPU copy is separate
+    Instance_Voxel* gpuInstances[2] = {};     // drawn and back, the instances are copied into the back one
+    u32 gpuInstanceCapacity[2] = {};
+    u32 instanceUploadCount = 0;
+    int instanceUploadFrames = 0;
+    int takeovers = 0;
+    double workerInstanceTime = 0;
+    bool meshUploaded = false;
+    bool uploading = false;
+    int uploadFrames = 0;
+    int uploads = 0;    // repacks, the requested ones and appends that ran out of room
+    int queued = 0;     // requests made so far
+    int started = 0;    // requests a remesh was started for
+    int finished = 0;   // requests whose meshes were taken over
+    int remeshFirst = 0;
+    double mainTime = 0;
+    double maxMainTime = 0;
+    double latency = 0;
+    double maxLatency = 0;
+    int latencyFrames = 0;
+    int maxLatencyFrames = 0;
+    double begin = CurrentTimeInSeconds();
+    int frame = 0;
+    for (; finished < requestCount; frame++) {
+        while (CurrentTimeInSeconds() < begin + frame * frameTime) {
+            // Waiting for the next frame.
+        }
+        if (frame % 4 == 0 && queued < requestCount) {
+            requestTimes[queued] = CurrentTimeInSeconds();
+            requestFrames[queued] = frame;
+            queued++;
+        }
+        
+        double start = CurrentTimeInSeconds();
+        bool uploaded = false;
+        bool sliced = false;
+        if (SvoRemeshDone(&remesh) && !meshUploaded) {
+            SvoMeshBuffer* staging = &remesh.staging;
+            if (remesh.repack) {
+                if (!uploading) {
+                    ClearSvoMeshOutput(&backMesh);
+                    GrowSvoMeshBuffer(&backMesh, staging->vertexCount + staging->vertexCount / 2, staging->indexCount + staging->indexCount / 2, 
+                                      staging->shortIndexCount + staging->shortIndexCount / 2, staging->clusterCount + staging->clusterCount / 2);
+                    uploading = true;
+                }
+                uploadFrames++;
+                sliced = true;
+                if (CopySvoMeshStagingSlice(staging, &backMesh, SVO_MESH_UPLOAD_SLICE_BYTES)) {
+                    uploading = false;
+                    meshUploaded = true;
+                    uploads++;
+                }
+            } else {
+                CopySvoMeshStagingSlice(staging, mesh, 0xFFFFFFFF);
+                meshUploaded = true;
+            }
+        }
+        if (meshUploaded && !sliced) {
+            // The instances after the mesh, a slice per frame into the back array like UploadSvoInstanceSlice().
+            if (instanceUploadCount == 0 && instances.instanceCount > gpuInstanceCapacity[1]) {
+                gpuInstanceCapacity[1] = instances.instanceCount + instances.instanceCount / 2;
+                gpuInstances[1] = (Instance_Voxel*)HeapAllocator.realloc(gpuInstances[1], gpuInstanceCapacity[1] * sizeof(Instance_Voxel));
+            }
+            u32 count = Min(instances.instanceCount - instanceUploadCount, SVO_MESH_UPLOAD_SLICE_BYTES / (u32)sizeof(Instance_Voxel));
+            memcpy(gpuInstances[1] + instanceUploadCount, instances.instances + instanceUploadCount, count * sizeof(Instance_Voxel));
+            instanceUploadCount += count;
+            instanceUploadFrames++;
+            uploaded = (instanceUploadCount == instances.instanceCount);
+        }
+        if (uploaded) {
+            if (remesh.repack) {
+                SvoMeshBuffer drawn = *mesh;
+                *mesh = backMesh;
+                backMesh = drawn;
+            }
+            Instance_Voxel* drawnGpuInstances = gpuInstances[0];
+            u32 drawnGpuCapacity = gpuInstanceCapacity[0];
+            gpuInstances[0] = gpuInstances[1];
+            gpuInstanceCapacity[0] = gpuInstanceCapacity[1];
+            gpuInstances[1] = drawnGpuInstances;
+            gpuInstanceCapacity[1] = drawnGpuCapacity;
+            SvoInstanceBuffer built = instances;
+            instances = drawnInstances;
+            drawnInstances = built;
+            workerInstanceTime += remesh.instanceTime;
+            takeovers++;
+            instanceUploadCount = 0;
+            meshUploaded = false;
+            FinishSvoRemesh(&remesh, grid);
+            double now = CurrentTimeInSeconds();
+            for (int i = remeshFirst; i < started; i++) {
+                latency += now - requestTimes[i];
+                if (now - requestTimes[i] > maxLatency) {
+                    maxLatency = now - requestTimes[i];
+                }
+                latencyFrames += frame - requestFrames[i];
+                maxLatencyFrames = Max(maxLatencyFrames, frame - requestFrames[i]);
+            }
+            finished = started;
+        }
+        
+        // A repack goes alone, edits up to the next repack together.
+        if (!remesh.running && started < queued) {
+            remeshFirst = started;
+            bool repack = (started % 8 == 7);
+            if (repack) {
+                started++;
+            }
+            while (!repack && started < queued && started % 8 != 7) {
+                RemoveSvoVoxelOnRay(&edited, grid, origins[started], directions[started]);
+                started++;
+            }
+            SvoMeshBuffer target = *mesh;
+            BeginSvoRemesh(&remesh, &edited, grid, &target, repack);
+            if (repack) {
+                remesh.grid.ambientOcclusion = !grid->ambientOcclusion;
+            }
+            remesh.instances = &instances;
+            StartSvoRemesh(&remesh);
+        }
+        double time = CurrentTimeInSeconds() - start;
+        mainTime += time;
+        if (time > maxMainTime) {
+            maxMainTime = time;
+        }
+    }
+    FreeSvoRemesh(&remesh);
+    
+    SvoChunkGrid fullGrid;
+    InitSvoChunkGrid(&fullGrid, lvl, SVO_MESH_CHUNK_SHIFT, SVO_MESH_MAX_LODS, rootScale, TempAllocator);
+    InitSvoGameSettings(&fullGrid);
+    fullGrid.ambientOcclusion = grid->ambientOcclusion;
+    SvoMeshBuffer fullMesh = AllocSvoMeshOutput();
+    MeshSvo(&edited, &fullGrid, threadCount, &fullMesh, &stats);
+    bool same = SameSvoChunkMeshes(grid, mesh, &fullGrid, &fullMesh);
+    SvoInstanceBuffer fullInstances = {};
+    BuildSvoInstances(&edited, &fullGrid, &fullInstances);
+    bool sameInstances = (drawnInstances.instanceCount == fullInstances.instanceCount) && 
+                         (fullInstances.instanceCount == 0 || 
+                          memcmp(gpuInstances[0], fullInstances.instances, fullInstances.instanceCount * sizeof(Instance_Voxel)) == 0);
+    
+    printf("[background remesh] level %d, %d threads, %d requests, one every 4 frames at 60 FPS, every 8th a repack\n", lvl, 
+           threadCount, requestCount);
+    printf("    in the frame:  %8.3f ms avg, %8.3f ms max per edit, %8.3f ms per repack\n", edits ? editTime * 1000.0 / edits : 0.0, 
+           maxEditTime * 1000.0, repacks ? repackTime * 1000.0 / repacks : 0.0);
+    printf("    background:    %8.3f ms avg, %8.3f ms max per frame on the calling thread, %d frames\n", mainTime * 1000.0 / frame, 
+           maxMainTime * 1000.0, frame);
+    printf("    upload:        %d frames for %d repacks, %u MB per frame\n", uploadFrames, uploads, 
+           SVO_MESH_UPLOAD_SLICE_BYTES / MEGABYTES(1));
+    printf("    latency:       %8.3f ms avg, %8.3f ms max, %.1f frames avg, %d max, %s\n", latency * 1000.0 / requestCount, 
+           maxLatency * 1000.0, (double)latencyFrames / requestCount, maxLatencyFrames, same ? "same mesh" : "MESH DIFFERS");
+    printf("    instances:     %u, %8.3f ms avg per build in the frame, %8.3f ms on the worker, %d upload frames, %s\n", 
+           fullInstances.instanceCount, instanceTime * 1000.0 / Max(edits + repacks, 1), workerInstanceTime * 1000.0 / Max(takeovers, 1), 
+           instanceUploadFrames, sameInstances ? "same instances" : "INSTANCES DIFFER");
+    
+    FreeSvoMeshBuffer(&meshes[0]);
+    FreeSvoMeshBuffer(&meshes[1]);
+    FreeSvoMeshBuffer(&backMesh);
+    FreeSvoMeshBuffer(&fullMesh);
+    FreeSvoInstanceBuffer(&frameInstances);
+    FreeSvoInstanceBuffer(&instances);
+    FreeSvoInstanceBuffer(&drawnInstances);
+    FreeSvoInstanceBuffer(&fullInstances);
+    HeapAllocator.free(gpuInstances[0]);
+    HeapAllocator.free(gpuInstances[1]);
+    FreeSvo(&edited, HeapFree);
+    TempArenaMemoryEnd(arena);
+}
+
+// Time to write LOD 0 of the mesh the game builds to every export format, from the mesh in memory to the file closed.
+// Best of 3 into a file in the working directory that is removed afterwards.
+void BenchmarkSvoExport(SvoImport* svo, float rootScale, int lvl) {
+    TempArenaMemory arena = TempArenaMemoryBegin(&tempAllocator);
+    
+    SvoChunkGrid grid;
+    InitSvoChunkGrid(&grid, lvl, SVO_MESH_CHUNK_SHIFT, 1, rootScale, TempAllocator);
+    InitSvoGameSettings(&grid);
+    
+    SvoMeshStats meshStats;
+    SvoMeshBuffer mesh = AllocSvoMeshOutput();
+    MeshSvo(svo, &grid, GetProcessorCount(), &mesh, &meshStats);
+    printf("[export] level %d, LOD 0, %u triangles, %u vertices\n", lvl, meshStats.quadCount * 2, mesh.vertexCount);
+    
+    for (int format = 0; format < SvoExport_Count; format++) {
+        char path[64];
+        snprintf(path, sizeof(path), "svo_export_benchmark%s", svoExportExtensions[format]);
+        
+        SvoExportStats stats = {};
+        double best = DBL_MAX;
+        bool written = true;
+        for (int run = 0; run < 3 && written; run++) {
+            double start = CurrentTimeInSeconds();
+            written = ExportSvoMesh(path, (SvoExportFormat)format, &grid, &mesh, 0, &stats);
+            double time = CurrentTimeInSeconds() - start;
+            if (time < best) {
+                best = time;
+            }
+        }
+        if (!written) {
+            printf("    %s: cannot write %s\n", svoExportExtensions[format], path);
+            continue;
+        }
+        RemoveFile(path);
+        
+        printf("    %s: %8.2f MB, %8.3f ms, %8.1f MB/s, %6.1f M triangles/s\n", svoExportExtensions[format], 
+               stats.byteCount / (double)MEGABYTES(1), best * 1000.0, stats.byteCount / (double)MEGABYTES(1) / best, 
+               stats.triangleCount / best / 1000000.0);
+    }
+    
+    FreeSvoMeshBuffer(&mesh);
+    TempArenaMemoryEnd(arena);
+}
+
+void RunSvoBenchmarks(SvoImport* svo, float rootScale, int lvl) {
+    printf("---- SVO benchmarks ----\n");
+    
+    TempArenaMemory arena = TempArenaMemoryBegin(&tempAllocator);
+    
+    int rayCount = 100000;
+    u32 state = 12345;
+    Vector3* origins = ALLOC_ARRAY(TempAllocator, Vector3, rayCount);
+    Vector3* directions = ALLOC_ARRAY(TempAllocator, Vector3, rayCount);
+    BenchRandomRays(&state, rootScale, origins, directions, rayCount);
+    
+    BenchmarkSvoRaycasts(svo, rootScale, lvl, origins, directions, rayCount, 1);
+    BenchmarkSvoRaycasts(svo, rootScale, lvl, origins, directions, rayCount, BENCH_MAX_HITS);
+    ValidateSvoRaycasts("model", svo, rootScale, lvl, origins, directions, 0, 2000);
+    ValidateDeepSvoRaycasts(rootScale, 2000);
+    
+    SvoSegment* segments = ALLOC_ARRAY(TempAllocator, SvoSegment, rayCount);
+    BenchRandomSegments(&state, rootScale, lvl, origins, directions, segments, rayCount, false);
+    BenchmarkSvoSegments(svo, rootScale, lvl, segments, rayCount);
+    BenchRandomSegments(&state, rootScale, lvl, origins, directions, segments, 4000, true);
+    ValidateSvoSegments(svo, rootScale, lvl, segments, 4000);
+    
+    TempArenaMemoryEnd(arena);
+    
+    printf("------------------------\n");
+}
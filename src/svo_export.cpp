@@ -0,0 +1,381 @@
+// Headless export of the chunk meshes of one LOD as a single mesh, for offline pipelines that have no use for the
+// Vertex_Voxel encoding: positions become floats in world units and normals are decoded like the voxel shader does.
+// Every format is streamed a chunk at a time straight into the write buffer of the File, see FileReserve(), so the
+// export never holds a copy of the mesh next to the SvoMeshBuffer it comes from.
+
+enum SvoExportFormat {
+    SvoExport_Ply,  // binary little endian PLY with an occlusion property when the cubes have ambient occlusion
+    SvoExport_Obj,  // text, positions and normals only
+    SvoExport_Glb,  // binary glTF 2.0, interleaved vertices and u32 indices in one buffer, occlusion as _OCCLUSION
+    SvoExport_Count
+};
+
+const char* svoExportExtensions[SvoExport_Count] = { ".ply", ".obj", ".glb" };
+
+struct SvoExportStats {
+    u32 vertexCount;
+    u32 triangleCount;
+    u64 byteCount;
+};
+
+// What every format needs to know about the mesh before writing any of it.
+struct SvoExportMesh {
+    SvoChunkGrid* grid;
+    SvoMeshBuffer* mesh;
+    int lod;
+    float unit;
+    bool surfaceNets;
+    bool withOcclusion;
+    u32 vertexCount;
+    u32 triangleCount;
+};
+
+// Vertices and triangles are encoded in batches of at most this many, so a batch of the widest format, OBJ text,
+// always fits in the write buffer.
+#define SVO_EXPORT_BATCH 4096
+
+// Longest OBJ lines: "v " and 3 numbers plus "vn " and 3 more for a vertex, "f " and 3 "a//a" for a triangle.
+#define SVO_EXPORT_OBJ_VERTEX_CHARS 128
+#define SVO_EXPORT_OBJ_TRIANGLE_CHARS 80
+
+// The format of the file extension of path, SvoExport_Count when it has none of them.
+SvoExportFormat SvoExportFormatFromPath(const char* path) {
+    size_t length = strlen(path);
+    for (int format = 0; format < SvoExport_Count; format++) {
+        size_t extensionLength = strlen(svoExportExtensions[format]);
+        if (length >= extensionLength && strcmp(path + length - extensionLength, svoExportExtensions[format]) == 0) {
+            return (SvoExportFormat)format;
+        }
+    }
+    return SvoExport_Count;
+}
+
+// World space position and unit normal of a vertex, and its occlusion from 0 to 3, the same as the voxel shader.
+void DecodeSvoExportVertex(SvoExportMesh* exportMesh, Vertex_Voxel v, float* position, float* normal, u8* occlusion) {
+    static const float faceNormals[SvoFace_Count][3] = { {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1} };
+    
+    position[0] = v.x * exportMesh->unit;
+    position[1] = v.y * exportMesh->unit;
+    position[2] = v.z * exportMesh->unit;
+    if (exportMesh->surfaceNets) {
+        float x = (v.face & 0xFF) / 255.0f * 2.0f - 1.0f;
+        float y = (v.face >> 8) / 255.0f * 2.0f - 1.0f;
+        float z = 1.0f - Abs(x) - Abs(y);
+        if (z < 0) {
+            float fx = (1.0f - Abs(y)) * (x >= 0 ? 1.0f : -1.0f);
+            float fy = (1.0f - Abs(x)) * (y >= 0 ? 1.0f : -1.0f);
+            x = fx;
+            y = fy;
+        }
+        float length = sqrtf(x * x + y * y + z * z);
+        normal[0] = x / length;
+        normal[1] = y / length;
+        normal[2] = z / length;
+        *occlusion = 0;
+    } else {
+        const float* n = faceNormals[v.face & 7];
+        normal[0] = n[0];
+        normal[1] = n[1];
+        normal[2] = n[2];
+        *occlusion = (u8)((v.face >> SVO_MESH_OCCLUSION_SHIFT) & 3);
+    }
+}
+
+u32 SvoChunkMeshIndex(SvoMeshBuffer* mesh, SvoChunkMesh* chunkMesh, u32 i) {
+    return (chunkMesh->indexFormat == IndexFormat_U16) ? mesh->shortIndices[chunkMesh->firstIndex + i] : mesh->indices[chunkMesh->firstIndex + i];
+}
+
+// Writes value with at most 6 decimals and without trailing zeros, returns the number of characters.
+int FormatSvoExportFloat(char* out, float value) {
+    int n = 0;
+    s64 fixed = (s64)(value * 1000000.0 + (value < 0 ? -0.5 : 0.5));
+    if (fixed < 0) {
+        out[n++] = '-';
+        fixed = -fixed;
+    }
+    
+    char digits[24];
+    int digitCount = 0;
+    s64 whole = fixed / 1000000;
+    do {
+        digits[digitCount++] = (char)('0' + whole % 10);
+        whole /= 10;
+    } while (whole > 0);
+    while (digitCount > 0) {
+        out[n++] = digits[--digitCount];
+    }
+    
+    int fraction = (int)(fixed % 1000000);
+    if (fraction != 0) {
+        out[n++] = '.';
+        for (int divisor = 100000; fraction != 0; divisor /= 10) {
+            out[n++] = (char)('0' + fraction / divisor);
+            fraction %= divisor;
+        }
+    }
+    return n;
+}
+
+int FormatSvoExportU32(char* out, u32 value) {
+    char digits[10];
+    int digitCount = 0;
+    do {
+        digits[digitCount++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    
+    int n = 0;
+    while (digitCount > 0) {
+        out[n++] = digits[--digitCount];
+    }
+    return n;
+}
+
+// Bytes of one vertex and one triangle in the binary formats.
+u32 SvoExportVertexSize(SvoExportFormat format, bool withOcclusion) {
+    if (format == SvoExport_Ply) {
+        return 6 * sizeof(float) + (withOcclusion ? 1 : 0);
+    }
+    return 6 * sizeof(float) + (withOcclusion ? sizeof(float) : 0);
+}
+
+u32 SvoExportTriangleSize(SvoExportFormat format) {
+    return (format == SvoExport_Ply) ? 1 + 3 * sizeof(u32) : 3 * sizeof(u32);
+}
+
+// Writes the vertices of every chunk mesh of the LOD, in chunk order. Returns the number of bytes written. A mesh that
+// repeated chunks share is at the origin, so it is written once for each of them, moved to the chunk's place.
+u64 WriteSvoExportVertices(File& file, SvoExportFormat format, SvoExportMesh* exportMesh) {
+    SvoMeshBuffer* mesh = exportMesh->mesh;
+    u32 vertexSize = SvoExportVertexSize(format, exportMesh->withOcclusion);
+    u64 written = 0;
+    for (u32 chunk = 0; chunk < exportMesh->grid->chunkCount; chunk++) {
+        SvoChunkMesh* chunkMesh = &exportMesh->grid->chunks[chunk].lods[exportMesh->lod];
+        Vector3Int origin = SvoChunkMeshOrigin(exportMesh->grid, chunk);
+        for (u32 start = 0; start < chunkMesh->vertexCount; start += SVO_EXPORT_BATCH) {
+            u32 count = Min(chunkMesh->vertexCount - start, (u32)SVO_EXPORT_BATCH);
+            u32 reserved = count * ((format == SvoExport_Obj) ? SVO_EXPORT_OBJ_VERTEX_CHARS : vertexSize);
+            u8* out = FileReserve(file, reserved);
+            u8* end = out;
+            for (u32 i = 0; i < count; i++) {
+                Vertex_Voxel v = mesh->vertices[chunkMesh->firstVertex + start + i];
+                v.x += (u16)origin.x;
+                v.y += (u16)origin.y;
+                v.z += (u16)origin.z;
+                
+                float values[6];
+                u8 occlusion;
+                DecodeSvoExportVertex(exportMesh, v, values, values + 3, &occlusion);
+                if (format == SvoExport_Obj) {
+                    char* line = (char*)end;
+                    for (int k = 0; k < 6; k++) {
+                        if (k == 0) {
+                            *line++ = 'v';
+                        } else if (k == 3) {
+                            *line++ = '\n';
+                            *line++ = 'v';
+                            *line++ = 'n';
+                        }
+                        *line++ = ' ';
+                        line += FormatSvoExportFloat(line, values[k]);
+                    }
+                    *line++ = '\n';
+                    end = (u8*)line;
+                } else {
+                    memcpy(end, values, sizeof(values));
+                    end += sizeof(values);
+                    if (exportMesh->withOcclusion) {
+                        if (format == SvoExport_Ply) {
+                            *end++ = occlusion;
+                        } else {
+                            float occluded = occlusion / 3.0f;
+                            memcpy(end, &occluded, sizeof(float));
+                            end += sizeof(float);
+                        }
+                    }
+                }
+            }
+            FileUnreserve(file, reserved - (u32)(end - out));
+            written += (u64)(end - out);
+        }
+    }
+    return written;
+}
+
+// Writes the triangles of every chunk mesh of the LOD with the indices of the whole mesh, in chunk order. Returns the
+// number of bytes written.
+u64 WriteSvoExportTriangles(File& file, SvoExportFormat format, SvoExportMesh* exportMesh) {
+    SvoMeshBuffer* mesh = exportMesh->mesh;
+    u32 triangleSize = (format == SvoExport_Obj) ? SVO_EXPORT_OBJ_TRIANGLE_CHARS : SvoExportTriangleSize(format);
+    
+    // OBJ counts vertices from 1.
+    u32 base = (format == SvoExport_Obj) ? 1 : 0;
+    u64 written = 0;
+    for (u32 chunk = 0; chunk < exportMesh->grid->chunkCount; chunk++) {
+        SvoChunkMesh* chunkMesh = &exportMesh->grid->chunks[chunk].lods[exportMesh->lod];
+        u32 triangleCount = chunkMesh->indexCount / 3;
+        for (u32 start = 0; start < triangleCount; start += SVO_EXPORT_BATCH) {
+            u32 count = Min(triangleCount - start, (u32)SVO_EXPORT_BATCH);
+            u8* out = FileReserve(file, count * triangleSize);
+            u8* end = out;
+            for (u32 t = start; t < start + count; t++) {
+                u32 triangle[3];
+                for (int k = 0; k < 3; k++) {
+                    triangle[k] = base + SvoChunkMeshIndex(mesh, chunkMesh, t * 3 + k);
+                }
+                if (format == SvoExport_Obj) {
+                    char* line = (char*)end;
+                    *line++ = 'f';
+                    for (int k = 0; k < 3; k++) {
+                        *line++ = ' ';
+                        line += FormatSvoExportU32(line, triangle[k]);
+                        *line++ = '/';
+                        *line++ = '/';
+                        line += FormatSvoExportU32(line, triangle[k]);
+                    }
+                    *line++ = '\n';
+                    end = (u8*)line;
+                } else {
+                    if (format == SvoExport_Ply) {
+                        *end++ = 3;
+                    }
+                    memcpy(end, triangle, sizeof(triangle));
+                    end += sizeof(triangle);
+                }
+            }
+            FileUnreserve(file, count * triangleSize - (u32)(end - out));
+            written += (u64)(end - out);
+        }
+        base += chunkMesh->vertexCount;
+    }
+    return written;
+}
+
+// The JSON chunk of a GLB, padded with spaces to 4 bytes as the format asks. Returns its length.
+u32 FormatSvoGlbJson(char* json, u32 capacity, SvoExportMesh* exportMesh, u32 vertexBytes, u32 indexBytes) {
+    int n = 0;
+    if (exportMesh->triangleCount == 0) {
+        n = snprintf(json, capacity, "{\"asset\":{\"version\":\"2.0\",\"generator\":\"svo export\"},\"scene\":0,\"scenes\":[{\"nodes\":[]}]}");
+    } else {
+        // Bounds from the integer positions, which the float positions are a scale of.
+        u16 lo[3] = { 0xFFFF, 0xFFFF, 0xFFFF };
+        u16 hi[3] = { 0, 0, 0 };
+        SvoMeshBuffer* mesh = exportMesh->mesh;
+        for (u32 chunk = 0; chunk < exportMesh->grid->chunkCount; chunk++) {
+            SvoChunkMesh* chunkMesh = &exportMesh->grid->chunks[chunk].lods[exportMesh->lod];
+            Vector3Int origin = SvoChunkMeshOrigin(exportMesh->grid, chunk);
+            for (u32 i = 0; i < chunkMesh->vertexCount; i++) {
+                Vertex_Voxel v = mesh->vertices[chunkMesh->firstVertex + i];
+                u16 p[3] = { (u16)(v.x + origin.x), (u16)(v.y + origin.y), (u16)(v.z + origin.z) };
+                for (int a = 0; a < 3; a++) {
+                    lo[a] = Min(lo[a], p[a]);
+                    hi[a] = Max(hi[a], p[a]);
+                }
+            }
+        }
+        
+        float unit = exportMesh->unit;
+        u32 stride = SvoExportVertexSize(SvoExport_Glb, exportMesh->withOcclusion);
+        char occlusionAccessor[128] = "";
+        if (exportMesh->withOcclusion) {
+            snprintf(occlusionAccessor, sizeof(occlusionAccessor), 
+                     "{\"bufferView\":0,\"byteOffset\":24,\"componentType\":5126,\"count\":%u,\"type\":\"SCALAR\"},", 
+                     exportMesh->vertexCount);
+        }
+        n = snprintf(json, capacity,
+                     "{\"asset\":{\"version\":\"2.0\",\"generator\":\"svo export\"},\"scene\":0,\"scenes\":[{\"nodes\":[0]}],"
+                     "\"nodes\":[{\"mesh\":0}],\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0,\"NORMAL\":1%s},"
+                     "\"indices\":%d,\"mode\":4}]}],\"buffers\":[{\"byteLength\":%u}],"
+                     "\"bufferViews\":[{\"buffer\":0,\"byteOffset\":0,\"byteLength\":%u,\"byteStride\":%u,\"target\":34962},"
+                     "{\"buffer\":0,\"byteOffset\":%u,\"byteLength\":%u,\"target\":34963}],\"accessors\":["
+                     "{\"bufferView\":0,\"byteOffset\":0,\"componentType\":5126,\"count\":%u,\"type\":\"VEC3\","
+                     "\"min\":[%.9g,%.9g,%.9g],\"max\":[%.9g,%.9g,%.9g]},"
+                     "{\"bufferView\":0,\"byteOffset\":12,\"componentType\":5126,\"count\":%u,\"type\":\"VEC3\"},%s"
+                     "{\"bufferView\":1,\"byteOffset\":0,\"componentType\":5125,\"count\":%u,\"type\":\"SCALAR\"}]}",
+                     exportMesh->withOcclusion ? ",\"_OCCLUSION\":2" : "", exportMesh->withOcclusion ? 3 : 2,
+                     vertexBytes + indexBytes, vertexBytes, stride, vertexBytes, indexBytes, exportMesh->vertexCount,
+                     lo[0] * unit, lo[1] * unit, lo[2] * unit, hi[0] * unit, hi[1] * unit, hi[2] * unit, exportMesh->vertexCount,
+                     occlusionAccessor, exportMesh->triangleCount * 3);
+    }
+    ASSERT_ERROR(n > 0 && (u32)n + 3 < capacity, "GLB JSON does not fit in %u bytes.", capacity);
+    
+    while (n % 4 != 0) {
+        json[n++] = ' ';
+    }
+    return (u32)n;
+}
+
+// Writes the LOD of the chunk meshes in mesh, as MeshSvo() left them for grid, to filePath. Returns false if the file
+// cannot be opened, or if a GLB would pass the 4 GB its u32 lengths allow, before creating it.
+bool ExportSvoMesh(const char* filePath, SvoExportFormat format, SvoChunkGrid* grid, SvoMeshBuffer* mesh, int lod,
+                   SvoExportStats* stats) {
+    ASSERT_ERROR(format >= 0 && format < SvoExport_Count, "Invalid export format %d.", format);
+    ASSERT_ERROR(lod >= 0 && lod < grid->lodCount, "Invalid LOD %d, the grid has %d.", lod, grid->lodCount);
+    
+    SvoExportMesh exportMesh = {};
+    exportMesh.grid = grid;
+    exportMesh.mesh = mesh;
+    exportMesh.lod = lod;
+    exportMesh.unit = SvoMeshUnit(grid);
+    exportMesh.surfaceNets = (grid->mesher == SvoMesher_SurfaceNets);
+    exportMesh.withOcclusion = !exportMesh.surfaceNets && grid->ambientOcclusion && format != SvoExport_Obj;
+    for (u32 chunk = 0; chunk < grid->chunkCount; chunk++) {
+        exportMesh.vertexCount += grid->chunks[chunk].lods[lod].vertexCount;
+        exportMesh.triangleCount += grid->chunks[chunk].lods[lod].indexCount / 3;
+    }
+    
+    // GLB lengths are u32, so the whole file must stay under 4 GB. The JSON chunk is under sizeof(header).
+    u64 vertexBytes = (u64)exportMesh.vertexCount * SvoExportVertexSize(format, exportMesh.withOcclusion);
+    u64 indexBytes = (u64)exportMesh.triangleCount * SvoExportTriangleSize(format);
+    if (format == SvoExport_Glb && 12 + 8 + 4096 + 8 + vertexBytes + indexBytes > 0xFFFFFFFF) {
+        return false;
+    }
+    
+    File file = FileOpen(filePath, FileMode_Write);
+    if (file.handle == (FileHandle)-1) {
+        free(file.writeBuffer);
+        return false;
+    }
+    
+    char header[4096];
+    u64 headerSize = 0;
+    if (format == SvoExport_Ply) {
+        headerSize = snprintf(header, sizeof(header),
+                              "ply\nformat binary_little_endian 1.0\ncomment svo export, LOD %d\nelement vertex %u\n"
+                              "property float x\nproperty float y\nproperty float z\n"
+                              "property float nx\nproperty float ny\nproperty float nz\n%s"
+                              "element face %u\nproperty list uchar uint vertex_indices\nend_header\n",
+                              lod, exportMesh.vertexCount, exportMesh.withOcclusion ? "property uchar occlusion\n" : "",
+                              exportMesh.triangleCount);
+        FileWrite(file, header, headerSize);
+    } else if (format == SvoExport_Obj) {
+        headerSize = snprintf(header, sizeof(header), "# svo export, LOD %d, %u vertices, %u triangles\n",
+                              lod, exportMesh.vertexCount, exportMesh.triangleCount);
+        FileWrite(file, header, headerSize);
+    } else {
+        u32 jsonBytes = FormatSvoGlbJson(header + 20, sizeof(header) - 20, &exportMesh, (u32)vertexBytes, (u32)indexBytes);
+        u32 binBytes = (u32)(vertexBytes + indexBytes);
+        bool withBin = (exportMesh.triangleCount > 0);
+        
+        // The GLB header, then the JSON chunk header right in front of the JSON. The BIN chunk header follows it.
+        u32 words[5] = { 0x46546C67, 2, 12 + 8 + jsonBytes + (withBin ? 8 + binBytes : 0), jsonBytes, 0x4E4F534A };
+        memcpy(header, words, sizeof(words));
+        headerSize = 20 + jsonBytes;
+        if (withBin) {
+            u32 binHeader[2] = { binBytes, 0x004E4942 };
+            memcpy(header + headerSize, binHeader, sizeof(binHeader));
+            headerSize += sizeof(binHeader);
+        }
+        FileWrite(file, header, headerSize);
+    }
+    
+    u64 byteCount = headerSize;
+    byteCount += WriteSvoExportVertices(file, format, &exportMesh);
+    byteCount += WriteSvoExportTriangles(file, format, &exportMesh);
+    FileClose(file);
+    
+    stats->vertexCount = exportMesh.vertexCount;
+    stats->triangleCount = exportMesh.triangleCount;
+    stats->byteCount = byteCount;
+    return true;
+}
@@ -0,0 +1,211 @@
+// Instanced rendering of the surface voxels, the alternative to the chunk meshes of svo_mesh.cpp. Instead of 4
+// vertices per merged face every voxel with an exposed face becomes one Instance_Voxel, its corner plus a 6 bit mask
+// of its exposed faces, and the GPU draws a 36 vertex cube per instance with the faces outside the mask collapsed,
+// see voxel_instance.fxh. Nothing is merged and there are no LODs, the instances are LOD 0 at the grid's level.
+//
+// The exposed faces come from the same occupancy lookup as MeshSvoRegionOccupancy(), so solid subtrees and
+// faces towards closed cavities are handled the same way. Instances are written per brick of 8^3 voxels, and every
+// brick is a cluster with bounds and the faces its instances have, which is what CullSvoInstances() works with.
+// Everything here is CPU side, the game uploads the instances as they are.
+
+#define SVO_INSTANCE_BRICK_SHIFT 3
+#define SVO_INSTANCE_BRICK_SIZE (1 << SVO_INSTANCE_BRICK_SHIFT)
+
+// Vertices of the cube every instance is drawn with, 2 triangles for every SvoFaceDirection.
+#define SVO_INSTANCE_CUBE_VERTICES 36
+
+// The instances of one brick, consecutive in SvoInstanceBuffer::instances.
+struct SvoInstanceCluster {
+    u32 firstInstance;
+    u32 instanceCount;
+    u32 faces;      // a bit per SvoFaceDirection that any of its instances has
+    u32 faceCount;  // exposed faces of all its instances
+    Vector3 min;    // world space bounds of its instances
+    Vector3 max;
+};
+
+struct SvoInstanceBuffer {
+    Instance_Voxel* instances;
+    u32 instanceCount;
+    u32 instanceCapacity;
+    SvoInstanceCluster* clusters;
+    u32 clusterCount;
+    u32 clusterCapacity;
+    u32 faceCount;  // exposed faces of all instances, the same as the unmerged faces of the LOD 0 mesh
+};
+
+// Grows the heap allocated arrays so they take the given number of elements more, like GrowSvoMeshBuffer().
+void GrowSvoInstanceBuffer(SvoInstanceBuffer* buffer, u32 instanceCount, u32 clusterCount) {
+    instanceCount += buffer->instanceCount;
+    if (instanceCount > buffer->instanceCapacity) {
+        buffer->instanceCapacity = Max(instanceCount, buffer->instanceCapacity * 2);
+        buffer->instances = (Instance_Voxel*)HeapAllocator.realloc(buffer->instances, buffer->instanceCapacity * sizeof(Instance_Voxel));
+    }
+    
+    clusterCount += buffer->clusterCount;
+    if (clusterCount > buffer->clusterCapacity) {
+        buffer->clusterCapacity = Max(clusterCount, buffer->clusterCapacity * 2);
+        buffer->clusters = (SvoInstanceCluster*)HeapAllocator.realloc(buffer->clusters, buffer->clusterCapacity * sizeof(SvoInstanceCluster));
+    }
+}
+
+void FreeSvoInstanceBuffer(SvoInstanceBuffer* buffer) {
+    HeapAllocator.free(buffer->instances);
+    HeapAllocator.free(buffer->clusters);
+    ZeroStruct(buffer);
+}
+
+// Appends the instances of the chunk at cc from the occupancy FillSvoOccupancy() left in scratch, a cluster per
+// brick that has any. surface is scratch for the voxels with any exposed face, laid out like the rows of scratch.
+// unit is the world size of a voxel.
+void AppendSvoChunkInstances(SvoMeshScratch* scratch, u64 (*surface)[SVO_MESH_REGION_SIZE], Vector3Int cc, int size, 
+                             float unit, SvoInstanceBuffer* buffer) {
+    u64 inside = ((size == 64) ? ~0ull : ((1ull << size) - 1)) << 1;
+    
+    u32 faceCount = 0;
+    u32 instanceCount = 0;
+    for (int z = 0; z < size; z++) {
+        for (int y = 0; y < size; y++) {
+            u64 faceRows[SvoFace_Count];
+            SvoOccupancyFaceRows(scratch, inside, y, z, faceRows);
+            
+            u64 any = 0;
+            for (int direction = 0; direction < SvoFace_Count; direction++) {
+                scratch->rows[direction][z][y] = faceRows[direction] >> 1;
+                any |= faceRows[direction];
+                faceCount += Popcount64(faceRows[direction]);
+            }
+            surface[z][y] = any >> 1;
+            instanceCount += Popcount64(any);
+        }
+    }
+    if (faceCount == 0) {
+        return;
+    }
+    buffer->faceCount += faceCount;
+    
+    int brickCount = Max(1, size >> SVO_INSTANCE_BRICK_SHIFT);
+    int brickSize = Min(size, SVO_INSTANCE_BRICK_SIZE);
+    u64 brickMask = (brickSize == 64) ? ~0ull : ((1ull << brickSize) - 1);
+    GrowSvoInstanceBuffer(buffer, instanceCount, brickCount * brickCount * brickCount);
+    
+    Vector3Int origin = { cc.x * size, cc.y * size, cc.z * size };
+    for (int bz = 0; bz < brickCount; bz++) {
+        for (int by = 0; by < brickCount; by++) {
+            for (int bx = 0; bx < brickCount; bx++) {
+                SvoInstanceCluster cluster = {};
+                cluster.firstInstance = buffer->instanceCount;
+                int lo[3] = { INT_MAX, INT_MAX, INT_MAX };
+                int hi[3] = { INT_MIN, INT_MIN, INT_MIN };
+                
+                int shift = bx * brickSize;
+                for (int z = bz * brickSize; z < (bz + 1) * brickSize; z++) {
+                    for (int y = by * brickSize; y < (by + 1) * brickSize; y++) {
+                        u64 voxels = (surface[z][y] >> shift) & brickMask;
+                        while (voxels) {
+                            int x = shift + CountTrailingZeros64(voxels);
+                            voxels &= voxels - 1;
+                            
+                            u32 faces = 0;
+                            for (int direction = 0; direction < SvoFace_Count; direction++) {
+                                faces |= (u32)((scratch->rows[direction][z][y] >> x) & 1) << direction;
+                            }
+                            cluster.faces |= faces;
+                            cluster.faceCount += Popcount64(faces);
+                            buffer->instances[buffer->instanceCount++] = { (u16)(origin.x + x), (u16)(origin.y + y), (u16)(origin.z + z), (u16)faces };
+                            
+                            int p[3] = { x, y, z };
+                            for (int a = 0; a < 3; a++) {
+                                lo[a] = Min(lo[a], p[a]);
+                                hi[a] = Max(hi[a], p[a] + 1);
+                            }
+                        }
+                    }
+                }
+                
+                cluster.instanceCount = buffer->instanceCount - cluster.firstInstance;
+                if (cluster.instanceCount > 0) {
+                    cluster.min = Vector3{ (origin.x + lo[0]) * unit, (origin.y + lo[1]) * unit, (origin.z + lo[2]) * unit };
+                    cluster.max = Vector3{ (origin.x + hi[0]) * unit, (origin.y + hi[1]) * unit, (origin.z + hi[2]) * unit };
+                    buffer->clusters[buffer->clusterCount++] = cluster;
+                }
+            }
+        }
+    }
+}
+
+// Replaces the contents of buffer with the instances of every chunk of the grid at its level, chunk by chunk.
+// Uses the grid's exterior and solidSubtrees, its mesher, LODs and ambient occlusion do not apply.
+void BuildSvoInstances(SvoImport* svo, SvoChunkGrid* grid, SvoInstanceBuffer* buffer) {
+    ASSERT_ERROR(grid->lvl <= svo->topLevel, "Cannot build instances for level %d of a SVO with %d levels.", grid->lvl, svo->topLevel);
+    TempArenaMemory tempArena = TempArenaMemoryBegin(&tempAllocator);
+    
+    buffer->instanceCount = 0;
+    buffer->clusterCount = 0;
+    buffer->faceCount = 0;
+    
+    SvoMeshScratch* scratch = ALLOC_ARRAY(TempAllocator, SvoMeshScratch, 1);
+    u64 (*surface)[SVO_MESH_REGION_SIZE] = (u64 (*)[SVO_MESH_REGION_SIZE])ALLOC_ARRAY(TempAllocator, u64, SVO_MESH_REGION_SIZE * SVO_MESH_REGION_SIZE);
+    float unit = grid->rootScale / (1 << grid->lvl);
+    for (u32 i = 0; i < grid->chunkCount; i++) {
+        Vector3Int cc = SvoChunkCoord(grid, i);
+        if (FindSvoNode(svo, grid->chunkLevel, cc) == SVO_NO_NODE) {
+            continue;
+        }
+        FillSvoOccupancy(scratch, svo, grid->lvl, grid->chunkLevel, cc, grid->chunkSize, true, grid->exterior, grid->solidSubtrees);
+        AppendSvoChunkInstances(scratch, surface, cc, grid->chunkSize, unit, buffer);
+    }
+    
+    TempArenaMemoryEnd(tempArena);
+}
+
+// A range of instances to draw with DrawInstancedVertices().
+struct SvoInstanceRange {
+    u32 firstInstance;
+    u32 instanceCount;
+};
+
+struct SvoInstanceCullStats {
+    u32 instanceCount;      // of all clusters
+    u32 frustumInstances;   // culled as outside the frustum
+    u32 backfaceInstances;  // culled as having no face towards the camera
+    u32 drawnInstanceCount;
+    u32 drawnFaceCount;     // exposed faces of the drawn instances, the triangles that are not collapsed are twice that
+    u32 drawCount;          // ranges the drawn clusters were merged into
+};
+
+// Clusters of buffer that are in the frustum and have a face that can point to the camera, see SvoVisibleFaces().
+// Neighboring survivors are drawn as one range, so ranges needs room for one per cluster at most. Returns the number
+// of ranges.
+u32 CullSvoInstances(SvoInstanceBuffer* buffer, Vector3 camera, SvoFrustum* frustum, SvoInstanceRange* ranges,
+                     SvoInstanceCullStats* stats) {
+    ZeroStruct(stats);
+    u32 rangeCount = 0;
+    bool extending = false;
+    for (u32 i = 0; i < buffer->clusterCount; i++) {
+        SvoInstanceCluster* cluster = &buffer->clusters[i];
+        stats->instanceCount += cluster->instanceCount;
+        
+        bool culled = true;
+        if (!SvoBoxInFrustum(frustum, cluster->min, cluster->max)) {
+            stats->frustumInstances += cluster->instanceCount;
+        } else if (!(cluster->faces & SvoVisibleFaces(cluster->min, cluster->max, camera))) {
+            stats->backfaceInstances += cluster->instanceCount;
+        } else {
+            stats->drawnInstanceCount += cluster->instanceCount;
+            stats->drawnFaceCount += cluster->faceCount;
+            culled = false;
+        }
+        
+        if (culled) {
+            extending = false;
+        } else if (extending) {
+            ranges[rangeCount - 1].instanceCount += cluster->instanceCount;
+        } else {
+            ranges[rangeCount++] = { cluster->firstInstance, cluster->instanceCount };
+            extending = true;
+        }
+    }
+    stats->drawCount = rangeCount;
+    return rangeCount;
+}
@@ -0,0 +1,3237 @@
+// CPU side of the SVO mesher. Exposed faces are found per voxel, then coplanar faces are merged into
+// maximal rectangles slice by slice. The mesh is split into cubic regions of up to 64 voxels per side so
+// every row of a slice fits in a u64, and regions are subtrees of the SVO so their voxels are contiguous.
+// Regions are independent, which is what lets MeshSvoChunks() spread them over threads and remesh them one by one.
+// The same regions can also be meshed as a smooth surface, see MeshSvoRegionSurfaceNets().
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+#define SVO_MESH_REGION_SHIFT 6
+#define SVO_MESH_REGION_SIZE (1 << SVO_MESH_REGION_SHIFT)
+
+// Chunks are smaller than the largest region so an edit only remeshes 32^3 voxels, at the cost of more draws.
+#define SVO_MESH_CHUNK_SHIFT 5
+
+// Every chunk is meshed at up to this many levels: LOD n is the chunk at level lvl - n, see SvoChunk.
+#define SVO_MESH_MAX_LODS 4
+
+enum SvoFaceDirection {
+    SvoFace_PositiveX,
+    SvoFace_NegativeX,
+    SvoFace_PositiveY,
+    SvoFace_NegativeY,
+    SvoFace_PositiveZ,
+    SvoFace_NegativeZ,
+    SvoFace_Count,
+};
+
+// Cube vertices with baked ambient occlusion keep how occluded their corner is, 0 to 3, in the 2 bits above the 
+// SvoFaceDirection in Vertex_Voxel w, see SvoFaceOcclusion().
+#define SVO_MESH_OCCLUSION_SHIFT 3
+
+// Chunks with at most this many vertices get u16 indices.
+#define SVO_MESH_MAX_SHORT_VERTICES 65536
+
+// Chunk meshes are split into clusters of this many triangles for culling, see SvoMeshCluster.
+#define SVO_MESH_CLUSTER_TRIANGLES 128
+
+// A run of up to SVO_MESH_CLUSTER_TRIANGLES consecutive triangles of a chunk mesh, with what CullSvoClusters() 
+// needs to skip it: its bounds and the cone of its triangle normals, both in world space. The mesher writes the
+// faces of one direction and slice together, so consecutive triangles mostly face the same way. Clusters never 
+// cross the direction buckets of their chunk mesh, see SvoChunkMesh.
+struct SvoMeshCluster {
+    u32 firstIndex;    // relative to the chunk mesh's firstIndex
+    u32 indexCount;
+    int direction;     // SvoFaceDirection of every triangle, SvoFace_Count when they can face any way
+    Vector3 min;
+    Vector3 max;
+    Vector3 coneAxis;
+    float coneCutoff;  // sine of the widest angle between coneAxis and a normal, 2 when the cone is too wide to cull
+};
+
+// Vertices are Vertex_Voxel, integer corners in voxels of the meshed level plus the SvoFaceDirection, 8 bytes 
+// instead of the 24 of Vertex_XYZ_N. The voxel shader scales them and looks up the normal.
+// shortIndices is only used for the output of MeshSvoChunks(), the per-thread segments have u32 indices only.
+// clusters are never drawn, so they stay on the CPU even when the rest is mapped GPU memory.
+//
+// MeshSvoChunks() knows the exact size of its output before it writes any of it. reserve is called with that many
+// more vertices, indices and clusters, so the buffers can be mapped or grown right then; returning false leaves the
+// output untouched. Without reserve the output has to fit in the capacities as they are.
+//
+// The arrays start at the bases, which are 0 except for staging buffers that only hold what is appended to a mesh
+// elsewhere, see SvoRemesh. Counts, capacities and the ranges of the chunks count from the start of that mesh.
+struct SvoMeshBuffer {
+    Vertex_Voxel* vertices;
+    u32* indices;
+    u16* shortIndices;
+    u32 vertexCount;
+    u32 indexCount;
+    u32 shortIndexCount;
+    u32 vertexCapacity;
+    u32 indexCapacity;
+    u32 shortIndexCapacity;
+    SvoMeshCluster* clusters;
+    u32 clusterCount;
+    u32 clusterCapacity;
+    u32 vertexBase;
+    u32 indexBase;
+    u32 shortIndexBase;
+    u32 clusterBase;
+    bool (*reserve)(SvoMeshBuffer* mesh, u32 vertexCount, u32 indexCount, u32 shortIndexCount, u32 clusterCount);
+};
+
+struct SvoMeshStats {
+    u32 faceCount;        // exposed voxel faces of LOD 0, what the mesh would have without merging
+    u32 quadCount;        // quads written for LOD 0 after merging
+    u32 lodQuadCounts[SVO_MESH_MAX_LODS];
+    u32 vertexCount;      // written to the output
+    u32 indexCount;       // u32 indices written to the output
+    u32 shortIndexCount;  // u16 indices written to the output
+    u32 clusterCount;     // clusters written to the output
+    u32 sharedCount;      // chunk LODs that reuse the mesh of a repeat instead of being meshed, see SvoChunkGrid
+};
+
+// Grows the heap allocated arrays of a CPU side mesh buffer so they take the given number of elements more.
+// An empty buffer gets exactly that, later growth at least doubles the arrays. Capacities count from the start of
+// the mesh, like the counts. Also works as a SvoMeshBuffer reserve callback.
+bool GrowSvoMeshBuffer(SvoMeshBuffer* mesh, u32 vertexCount, u32 indexCount, u32 shortIndexCount, u32 clusterCount) {
+    vertexCount += mesh->vertexCount;
+    if (vertexCount > mesh->vertexCapacity) {
+        mesh->vertexCapacity = Max(vertexCount, mesh->vertexCapacity * 2 - mesh->vertexBase);
+        mesh->vertices = (Vertex_Voxel*)HeapAllocator.realloc(mesh->vertices, (mesh->vertexCapacity - mesh->vertexBase) * sizeof(Vertex_Voxel));
+    }
+    
+    indexCount += mesh->indexCount;
+    if (indexCount > mesh->indexCapacity) {
+        mesh->indexCapacity = Max(indexCount, mesh->indexCapacity * 2 - mesh->indexBase);
+        mesh->indices = (u32*)HeapAllocator.realloc(mesh->indices, (mesh->indexCapacity - mesh->indexBase) * sizeof(u32));
+    }
+    
+    shortIndexCount += mesh->shortIndexCount;
+    if (shortIndexCount > mesh->shortIndexCapacity) {
+        mesh->shortIndexCapacity = Max(shortIndexCount, mesh->shortIndexCapacity * 2 - mesh->shortIndexBase);
+        mesh->shortIndices = (u16*)HeapAllocator.realloc(mesh->shortIndices, (mesh->shortIndexCapacity - mesh->shortIndexBase) * sizeof(u16));
+    }
+    
+    clusterCount += mesh->clusterCount;
+    if (clusterCount > mesh->clusterCapacity) {
+        mesh->clusterCapacity = Max(clusterCount, mesh->clusterCapacity * 2 - mesh->clusterBase);
+        mesh->clusters = (SvoMeshCluster*)HeapAllocator.realloc(mesh->clusters, (mesh->clusterCapacity - mesh->clusterBase) * sizeof(SvoMeshCluster));
+    }
+    return true;
+}
+
+void FreeSvoMeshBuffer(SvoMeshBuffer* mesh) {
+    HeapAllocator.free(mesh->vertices);
+    HeapAllocator.free(mesh->indices);
+    HeapAllocator.free(mesh->shortIndices);
+    HeapAllocator.free(mesh->clusters);
+    ZeroStruct(mesh);
+}
+
+// Slice rows for every direction of one region. A row holds the faces along u for one v, see MeshSvoRegion().
+// Merging clears every bit it consumes, so the rows are all zero again once a region is done.
+// occupancy is only used by the surface nets and the cubes with ambient occlusion or exterior faces only, see 
+// FillSvoOccupancy(), the cells only by the surface nets.
+struct SvoMeshScratch {
+    u64 rows[SvoFace_Count][SVO_MESH_REGION_SIZE][SVO_MESH_REGION_SIZE];
+    u64 occupancy[SVO_MESH_REGION_SIZE][SVO_MESH_REGION_SIZE];
+    u64 cavities[SVO_MESH_REGION_SIZE][SVO_MESH_REGION_SIZE];  // the part of occupancy that is closed off empty space
+    
+    // The occluded faces of the slice being merged, taken out of its rows, and the SvoFaceOcclusion() of each.
+    u64 occludedRows[SVO_MESH_REGION_SIZE];
+    u8 occlusion[SVO_MESH_REGION_SIZE][SVO_MESH_REGION_SIZE];
+    
+    // The vertex of every cell of the region, 0xFFFFFFFF until it has one. Only the cells in usedCells are reset.
+    u32* cellVertices;
+    u32* usedCells;
+};
+
+int CountTrailingZeros64(u64 value) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return (int)index;
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+
+int Popcount64(u64 value) {
+#if defined(_MSC_VER)
+    return (int)__popcnt64(value);
+#else
+    return __builtin_popcountll(value);
+#endif
+}
+
+// The node next to a node in every SvoFaceDirection at the same level, or SVO_NO_NODE where that space is empty.
+struct SvoNodeNeighbors {
+    u32 nodes[SvoFace_Count];
+};
+
+u32 SvoChildNode(SvoImport* svo, int lvl, u32 node, int child) {
+    if (node == SVO_NO_NODE) {
+        return SVO_NO_NODE;
+    }
+    u8 mask = svo->masksAtLevel[lvl][node];
+    if ((mask & (1u << child)) == 0) {
+        return SVO_NO_NODE;
+    }
+    return svo->firstChild[lvl][node] + Popcount8(mask & ((1u << child) - 1u));
+}
+
+// Neighbors of a child from the neighbors of its parent. Along each axis one neighbor is a sibling in the parent's mask,
+// the other is the mirrored child of the parent's neighbor on that side.
+void SvoChildNeighbors(SvoImport* svo, int parentLvl, u32 parent, SvoNodeNeighbors* parentNeighbors, int child, 
+                       SvoNodeNeighbors* neighbors) {
+    for (int direction = 0; direction < SvoFace_Count; direction++) {
+        int axisBit = 1 << (direction >> 1);
+        bool positive = (direction & 1) == 0;
+        bool upper = (child & axisBit) != 0;
+        
+        if (positive != upper) {
+            neighbors->nodes[direction] = SvoChildNode(svo, parentLvl, parent, child ^ axisBit);
+        } else {
+            neighbors->nodes[direction] = SvoChildNode(svo, parentLvl, parentNeighbors->nodes[direction], child ^ axisBit);
+        }
+    }
+}
+
+// Finds the node covering c at lvl and its neighbors by carrying the neighbors down the path from the root.
+// Returns false if that node does not exist.
+bool FindSvoNodeNeighbors(SvoImport* svo, int lvl, Vector3Int c, u32* node, SvoNodeNeighbors* neighbors) {
+    *node = 0;
+    memset(neighbors, 0xFF, sizeof(SvoNodeNeighbors));
+    
+    for (int i = 0; i < lvl; i++) {
+        int shift = (lvl - 1) - i;
+        int child = ((c.x >> shift) & 1) | (((c.y >> shift) & 1) << 1) | (((c.z >> shift) & 1) << 2);
+        u32 childNode = SvoChildNode(svo, i, *node, child);
+        if (childNode == SVO_NO_NODE) {
+            return false;
+        }
+        
+        SvoNodeNeighbors parentNeighbors = *neighbors;
+        SvoChildNeighbors(svo, i, *node, &parentNeighbors, child, neighbors);
+        *node = childNode;
+    }
+    
+    return true;
+}
+
+// Depth-first walk over the voxels of a subtree in Morton order, which is also their node order. Every node on the
+// path keeps its neighbors, so a voxel's neighbors come from its parent's without looking anything up from the root.
+// The stack has a fixed size, so the walk needs no memory besides the iterator. Walks that only need the voxels 
+// can skip the neighbors, ClipSvoLeaves() skips every subtree outside a box and WalkSvoSolidLeaves() the inside
+// of solid subtrees.
+struct SvoLeafIteratorEntry {
+    u32 node;
+    u8 children;     // children still to visit
+    u8 solidSides;   // inside a solid subtree with SvoSolidWalk_Boundary: bit n when on its side in SvoFaceDirection n
+    Vector3Int coord;
+    SvoNodeNeighbors neighbors;
+};
+
+// How NextSvoLeaf() walks a subtree whose voxels are all filled, see SvoImport::solidLevels.
+enum SvoSolidWalk {
+    SvoSolidWalk_Voxels,    // every voxel, like any other subtree
+    SvoSolidWalk_Boundary,  // only the voxels on its sides, the ones inside have every neighbor filled and no faces
+    SvoSolidWalk_Blocks,    // the whole subtree at once, as a block of voxels, when it is inside the clip box
+};
+
+struct SvoLeafIterator {
+    SvoImport* svo;
+    int lvl;
+    int subtreeLvl;
+    int depth;  // entries on the stack, the one on top is at level subtreeLvl + depth - 1
+    SvoLeafIteratorEntry stack[SVO_MAX_LEVELS];
+    bool carryNeighbors;
+    bool clipped;
+    Vector3Int clipMin;  // voxels at lvl, inclusive
+    Vector3Int clipMax;  // exclusive
+    SvoSolidWalk solidWalk;
+    
+    // The current voxel, valid after NextSvoLeaf() returned true. With SvoSolidWalk_Blocks it can be a solid subtree
+    // of 1 << blockShift voxels per side instead, coord is then its min corner and neighbors is not set.
+    u32 node;
+    Vector3Int coord;
+    int blockShift;
+    SvoNodeNeighbors neighbors;
+};
+
+// Starts a walk over the voxels at lvl below node, the node at subtreeLvl with coordinates nodeCoord.
+// nodeNeighbors can be 0 when the neighbors of the voxels are not needed.
+void BeginSvoLeaves(SvoLeafIterator* it, SvoImport* svo, int lvl, int subtreeLvl, u32 node, Vector3Int nodeCoord, 
+                    SvoNodeNeighbors* nodeNeighbors) {
+    ASSERT_ERROR(subtreeLvl <= lvl && lvl - subtreeLvl < SVO_MAX_LEVELS, "Invalid leaf levels %d to %d.", subtreeLvl, lvl);
+    it->svo = svo;
+    it->lvl = lvl;
+    it->subtreeLvl = subtreeLvl;
+    it->depth = 1;
+    it->carryNeighbors = (nodeNeighbors != 0);
+    it->clipped = false;
+    it->solidWalk = SvoSolidWalk_Voxels;
+    it->blockShift = 0;
+    
+    SvoLeafIteratorEntry* root = &it->stack[0];
+    root->node = node;
+    root->children = (subtreeLvl < lvl) ? svo->masksAtLevel[subtreeLvl][node] : 0;
+    root->solidSides = 0;
+    root->coord = nodeCoord;
+    if (it->carryNeighbors) {
+        root->neighbors = *nodeNeighbors;
+    }
+}
+
+// Only walks the voxels in [clipMin, clipMax). Call right after BeginSvoLeaves().
+void ClipSvoLeaves(SvoLeafIterator* it, Vector3Int clipMin, Vector3Int clipMax) {
+    it->clipped = true;
+    it->clipMin = clipMin;
+    it->clipMax = clipMax;
+}
+
+// Walks solid subtrees as walk says. Call right after BeginSvoLeaves(). The subtree of the walk is never a block 
+// itself, a solid one is returned as its 8 children.
+void WalkSvoSolidLeaves(SvoLeafIterator* it, SvoSolidWalk walk) {
+    it->solidWalk = walk;
+    
+    SvoLeafIteratorEntry* root = &it->stack[0];
+    int levels = it->lvl - it->subtreeLvl;
+    if (walk == SvoSolidWalk_Boundary && levels > 0 && it->svo->solidLevels[it->subtreeLvl][root->node] >= levels) {
+        root->solidSides = (1 << SvoFace_Count) - 1;
+    }
+}
+
+// The sides of its parent that child touches, bit n for SvoFaceDirection n.
+u8 SvoChildSides(int child) {
+    u8 sides = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        int positive = (child >> axis) & 1;
+        sides |= 1 << (axis * 2 + (positive ? 0 : 1));
+    }
+    return sides;
+}
+
+bool NextSvoLeaf(SvoLeafIterator* it) {
+    SvoImport* svo = it->svo;
+    while (it->depth > 0) {
+        SvoLeafIteratorEntry* parent = &it->stack[it->depth - 1];
+        int parentLvl = it->subtreeLvl + it->depth - 1;
+        if (parentLvl == it->lvl) {
+            // The subtree is a single voxel.
+            it->node = parent->node;
+            it->coord = parent->coord;
+            it->neighbors = parent->neighbors;
+            it->depth = 0;
+            return true;
+        }
+        if (parent->children == 0) {
+            it->depth--;
+            continue;
+        }
+        
+        int child = CountTrailingZeros64(parent->children);
+        parent->children &= parent->children - 1;
+        
+        u8 solidSides = 0;
+        if (parent->solidSides) {
+            // A child touching none of the sides of the solid subtree only has filled voxels around it.
+            solidSides = parent->solidSides & SvoChildSides(child);
+            if (solidSides == 0) {
+                continue;
+            }
+        }
+        
+        u8 mask = svo->masksAtLevel[parentLvl][parent->node];
+        u32 node = svo->firstChild[parentLvl][parent->node] + Popcount8(mask & ((1u << child) - 1u));
+        Vector3Int pc = parent->coord;
+        Vector3Int coord = { pc.x * 2 + (child & 1), pc.y * 2 + ((child >> 1) & 1), pc.z * 2 + ((child >> 2) & 1) };
+        
+        int shift = it->lvl - (parentLvl + 1);
+        bool insideClip = true;
+        if (it->clipped) {
+            Vector3Int lo = { coord.x << shift, coord.y << shift, coord.z << shift };
+            int size = 1 << shift;
+            if (lo.x >= it->clipMax.x || lo.y >= it->clipMax.y || lo.z >= it->clipMax.z ||
+                lo.x + size <= it->clipMin.x || lo.y + size <= it->clipMin.y || lo.z + size <= it->clipMin.z) {
+                continue;
+            }
+            insideClip = lo.x >= it->clipMin.x && lo.y >= it->clipMin.y && lo.z >= it->clipMin.z &&
+                         lo.x + size <= it->clipMax.x && lo.y + size <= it->clipMax.y && lo.z + size <= it->clipMax.z;
+        }
+        
+        if (shift > 0 && solidSides == 0 && it->solidWalk != SvoSolidWalk_Voxels && 
+            svo->solidLevels[parentLvl + 1][node] >= shift) {
+            if (it->solidWalk == SvoSolidWalk_Boundary) {
+                solidSides = (1 << SvoFace_Count) - 1;
+            } else if (insideClip) {
+                it->node = node;
+                it->coord = Vector3Int{ coord.x << shift, coord.y << shift, coord.z << shift };
+                it->blockShift = shift;
+                return true;
+            }
+        }
+        
+        if (shift == 0) {
+            it->node = node;
+            it->coord = coord;
+            it->blockShift = 0;
+            if (it->carryNeighbors) {
+                SvoChildNeighbors(svo, parentLvl, parent->node, &parent->neighbors, child, &it->neighbors);
+            }
+            return true;
+        }
+        
+        SvoLeafIteratorEntry* entry = &it->stack[it->depth++];
+        entry->node = node;
+        entry->children = svo->masksAtLevel[parentLvl + 1][node];
+        entry->solidSides = solidSides;
+        entry->coord = coord;
+        if (it->carryNeighbors) {
+            SvoChildNeighbors(svo, parentLvl, parent->node, &parent->neighbors, child, &entry->neighbors);
+        }
+    }
+    return false;
+}
+
+// 6 bits, bit n set when the face in SvoFaceDirection n is not covered by a neighbor.
+u8 SvoFaceMask(SvoNodeNeighbors* neighbors) {
+    u8 faceMask = 0;
+    for (int direction = 0; direction < SvoFace_Count; direction++) {
+        if (neighbors->nodes[direction] == SVO_NO_NODE) {
+            faceMask |= 1 << direction;
+        }
+    }
+    return faceMask;
+}
+
+// Face masks of the voxels at lvl in the subtree of node at subtreeLvl, written to faceMasks and coords in node order.
+// Returns the number of voxels in the subtree.
+u32 ComputeSvoFaceMasks(SvoImport* svo, int lvl, int subtreeLvl, u32 node, Vector3Int nodeCoord, SvoNodeNeighbors* nodeNeighbors, 
+                        u8* faceMasks, Vector3Int* coords) {
+    SvoLeafIterator it;
+    BeginSvoLeaves(&it, svo, lvl, subtreeLvl, node, nodeCoord, nodeNeighbors);
+    
+    u32 w = 0;
+    while (NextSvoLeaf(&it)) {
+        faceMasks[w] = SvoFaceMask(&it.neighbors);
+        coords[w] = it.coord;
+        w++;
+    }
+    return w;
+}
+
+// Writes a quad of w x h voxel faces. For a face along axis a, u is axis (a + 1) % 3 and v is axis (a + 2) % 3.
+// Positive faces wind counter-clockwise in (u, v), negative faces clockwise, which matches the old per-voxel quads.
+// Positions are shifted left by scaleShift, so coarser levels are written in voxels of the finest level.
+// attribute goes to the w of every vertex, see Vertex_Voxel. occlusion holds 2 bits per corner from 
+// SvoFaceOcclusion(), they go above the direction and pick the diagonal that splits the quad.
+void AppendSvoQuad(SvoMeshBuffer* mesh, int direction, int plane, int u, int v, int w, int h, int scaleShift, u16 attribute,
+                   u8 occlusion) {
+    ASSERT_ERROR(mesh->vertexCount + 4 <= mesh->vertexCapacity && mesh->indexCount + 6 <= mesh->indexCapacity,
+                 "SVO mesh buffer is not large enough!");
+    
+    int axis = direction >> 1;
+    int uAxis = (axis + 1) % 3;
+    int vAxis = (axis + 2) % 3;
+    bool positive = (direction & 1) == 0;
+    
+    int corners[4][2] = { {u, v}, {u + w, v}, {u + w, v + h}, {u, v + h} };
+    Vertex_Voxel* verts = mesh->vertices + mesh->vertexCount;
+    for (int i = 0; i < 4; i++) {
+        int p[3];
+        p[axis]  = plane << scaleShift;
+        p[uAxis] = corners[i][0] << scaleShift;
+        p[vAxis] = corners[i][1] << scaleShift;
+        u16 cornerOcclusion = (u16)(((occlusion >> (i * 2)) & 3) << SVO_MESH_OCCLUSION_SHIFT);
+        verts[i] = { (u16)p[0], (u16)p[1], (u16)p[2], (u16)(attribute | cornerOcclusion) };
+    }
+    
+    // The diagonal goes between the lighter pair of corners. Across the darker pair the shading of one dark corner
+    // would spread over both triangles, and turning the quad would change how it looks.
+    static const u32 positiveIndices[2][6] = { { 0, 1, 2, 2, 3, 0 }, { 1, 2, 3, 3, 0, 1 } };
+    static const u32 negativeIndices[2][6] = { { 2, 1, 0, 0, 3, 2 }, { 3, 2, 1, 1, 0, 3 } };
+    int diagonal02 = (occlusion & 3) + ((occlusion >> 4) & 3);
+    int diagonal13 = ((occlusion >> 2) & 3) + (occlusion >> 6);
+    int flip = (diagonal02 > diagonal13) ? 1 : 0;
+    const u32* quadIndices = positive ? positiveIndices[flip] : negativeIndices[flip];
+    u32* indices = mesh->indices + mesh->indexCount;
+    for (int i = 0; i < 6; i++) {
+        indices[i] = mesh->vertexCount + quadIndices[i];
+    }
+    
+    mesh->vertexCount += 4;
+    mesh->indexCount += 6;
+}
+
+// Standard voxel ambient occlusion of the face of voxel, in the region's coordinates, in direction: 2 bits per corner 
+// in the corner order of AppendSvoQuad(), 0 when nothing occludes the face. A corner is darkened by the voxels in 
+// front of the face that touch it, the two along its edges and the one across, and both edges make it fully dark.
+// Reads the occupancy FillSvoOccupancy() left in scratch, so the shell around the region counts too.
+u8 SvoFaceOcclusion(SvoMeshScratch* scratch, int direction, int voxel[3]) {
+    int axis = direction >> 1;
+    int uAxis = (axis + 1) % 3;
+    int vAxis = (axis + 2) % 3;
+    int front[3] = { voxel[0] + 1, voxel[1] + 1, voxel[2] + 1 };
+    front[axis] += ((direction & 1) == 0) ? 1 : -1;
+    
+    // The voxels around the one in front of the face, bit (du + 1) + (dv + 1) * 3. The middle one is empty.
+    u32 around = 0;
+    for (int dv = -1; dv <= 1; dv++) {
+        for (int du = -1; du <= 1; du++) {
+            int c[3] = { front[0], front[1], front[2] };
+            c[uAxis] += du;
+            c[vAxis] += dv;
+            around |= (u32)((scratch->occupancy[c[2]][c[1]] >> c[0]) & 1) << ((du + 1) + (dv + 1) * 3);
+        }
+    }
+    if (around == 0) {
+        return 0;
+    }
+    
+    static const int corners[4][2] = { {-1, -1}, {1, -1}, {1, 1}, {-1, 1} };
+    u8 occlusion = 0;
+    for (int i = 0; i < 4; i++) {
+        int du = corners[i][0] + 1;
+        int dv = (corners[i][1] + 1) * 3;
+        u32 side1 = (around >> (du + 3)) & 1;
+        u32 side2 = (around >> (1 + dv)) & 1;
+        u32 corner = (around >> (du + dv)) & 1;
+        u32 value = (side1 && side2) ? 3 : side1 + side2 + corner;
+        occlusion |= (u8)(value << (i * 2));
+    }
+    return occlusion;
+}
+
+// Merges the faces in scratch into maximal rectangles and clears them. attributes holds the Vertex_Voxel w of the 
+// quads for every SvoFaceDirection. The quads are written one direction after the other, faceIndexCounts gets the 
+// number of indices of each.
+//
+// With withOcclusion the occluded faces of every slice are taken out of its rows first and merged on their own, a 
+// quad only takes faces with the same SvoFaceOcclusion(). Neighboring faces share the corners between them, so 
+// equal faces have equal corners along the way they are merged and the quad shades exactly like its faces.
+void MergeSvoRegionFaces(SvoMeshScratch* scratch, Vector3Int origin, int regionSize, int scaleShift, const u16* attributes,
+                         bool withOcclusion, SvoMeshBuffer* mesh, SvoMeshStats* stats, u32* faceIndexCounts) {
+    int originAxis[3] = { origin.x, origin.y, origin.z };
+    
+    for (int direction = 0; direction < SvoFace_Count; direction++) {
+        u32 firstIndex = mesh->indexCount;
+        int axis = direction >> 1;
+        int uAxis = (axis + 1) % 3;
+        int vAxis = (axis + 2) % 3;
+        int planeOffset = ((direction & 1) == 0) ? 1 : 0;
+        
+        for (int slice = 0; slice < regionSize; slice++) {
+            u64* rows = scratch->rows[direction][slice];
+            int plane = originAxis[axis] + slice + planeOffset;
+            
+            u64* occludedRows = scratch->occludedRows;
+            bool anyOccluded = false;
+            if (withOcclusion) {
+                for (int v = 0; v < regionSize; v++) {
+                    occludedRows[v] = 0;
+                    u64 faces = rows[v];
+                    while (faces) {
+                        int u = CountTrailingZeros64(faces);
+                        faces &= faces - 1;
+                        
+                        int voxel[3];
+                        voxel[axis] = slice;
+                        voxel[uAxis] = u;
+                        voxel[vAxis] = v;
+                        u8 occlusion = SvoFaceOcclusion(scratch, direction, voxel);
+                        if (occlusion) {
+                            scratch->occlusion[v][u] = occlusion;
+                            occludedRows[v] |= 1ull << u;
+                        }
+                    }
+                    rows[v] &= ~occludedRows[v];
+                    anyOccluded = anyOccluded || occludedRows[v];
+                }
+            }
+            
+            for (int v = 0; v < regionSize; v++) {
+                while (rows[v]) {
+                    // Widest run of faces starting at the lowest set bit, then grow it along v while the rows
+                    // below contain the whole run.
+                    int u = CountTrailingZeros64(rows[v]);
+                    u64 shifted = ~(rows[v] >> u);
+                    int w = shifted ? CountTrailingZeros64(shifted) : 64 - u;
+                    u64 run = ((w == 64) ? ~0ull : ((1ull << w) - 1)) << u;
+                    
+                    rows[v] &= ~run;
+                    int h = 1;
+                    while (v + h < regionSize && (rows[v + h] & run) == run) {
+                        rows[v + h] &= ~run;
+                        h++;
+                    }
+                    
+                    AppendSvoQuad(mesh, direction, plane, originAxis[uAxis] + u, originAxis[vAxis] + v, w, h, scaleShift, attributes[direction], 0);
+                    stats->quadCount++;
+                }
+            }
+            
+            for (int v = 0; anyOccluded && v < regionSize; v++) {
+                while (occludedRows[v]) {
+                    int u = CountTrailingZeros64(occludedRows[v]);
+                    u8 occlusion = scratch->occlusion[v][u];
+                    int w = 1;
+                    while (u + w < regionSize && ((occludedRows[v] >> (u + w)) & 1) && scratch->occlusion[v][u + w] == occlusion) {
+                        w++;
+                    }
+                    u64 run = ((w == 64) ? ~0ull : ((1ull << w) - 1)) << u;
+                    
+                    occludedRows[v] &= ~run;
+                    int h = 1;
+                    while (v + h < regionSize && (occludedRows[v + h] & run) == run) {
+                        int same = 0;
+                        while (same < w && scratch->occlusion[v + h][u + same] == occlusion) {
+                            same++;
+                        }
+                        if (same < w) {
+                            break;
+                        }
+                        occludedRows[v + h] &= ~run;
+                        h++;
+                    }
+                    
+                    AppendSvoQuad(mesh, direction, plane, originAxis[uAxis] + u, originAxis[vAxis] + v, w, h, scaleShift, attributes[direction], occlusion);
+                    stats->quadCount++;
+                }
+            }
+        }
+        faceIndexCounts[direction] = mesh->indexCount - firstIndex;
+    }
+}
+
+// Meshes the voxels of one region, the ones leaves walks over. origin is the voxel coordinate of the region's 
+// min corner. Faces are merged within a slice of the region only, never across regions. 
+// faceIndexCounts gets the indices of every direction, see MergeSvoRegionFaces().
+void MeshSvoRegion(SvoMeshScratch* scratch, Vector3Int origin, int regionSize, SvoLeafIterator* leaves, 
+                   int scaleShift, SvoMeshBuffer* mesh, SvoMeshStats* stats, u32* faceIndexCounts) {
+    u32 faceCount = 0;
+    while (NextSvoLeaf(leaves)) {
+        u8 faceMask = SvoFaceMask(&leaves->neighbors);
+        if (faceMask == 0) {
+            continue;
+        }
+        
+        Vector3Int c = leaves->coord;
+        int local[3] = { c.x - origin.x, c.y - origin.y, c.z - origin.z };
+        for (int direction = 0; direction < SvoFace_Count; direction++) {
+            if (faceMask & (1 << direction)) {
+                int axis = direction >> 1;
+                int u = local[(axis + 1) % 3];
+                int v = local[(axis + 2) % 3];
+                scratch->rows[direction][local[axis]][v] |= 1ull << u;
+                faceCount++;
+            }
+        }
+    }
+    stats->faceCount += faceCount;
+    
+    // Merging never produces more quads than there are faces.
+    GrowSvoMeshBuffer(mesh, faceCount * 4, faceCount * 6, 0, 0);
+    
+    static const u16 directions[SvoFace_Count] = { 0, 1, 2, 3, 4, 5 };
+    MergeSvoRegionFaces(scratch, origin, regionSize, scaleShift, directions, false, mesh, stats, faceIndexCounts);
+}
+
+// Empty space of the SVO that is connected to the outside of its bounds through the voxels of lvl. Empty space that 
+// is not is a closed cavity, and faces towards it can never be seen from outside. The empty space is the children 
+// that nodes are missing, so a whole empty subtree is one block, see FloodSvoExterior().
+struct SvoExterior {
+    int lvl;
+    u8** masks;           // for every level below lvl, per node: bit i when child i is missing and exterior
+    u32 blockCount;       // empty blocks the last flood reached
+    u32 chunkCount;
+    u32* cavityCounts;    // cavity voxels in every chunk of the grid, see UpdateSvoExterior()
+};
+
+// The blocks the flood has reached but not spread from yet.
+struct SvoExteriorFlood {
+    SvoImport* svo;
+    SvoExterior* exterior;
+    Vector3Int* coords;  // of the block, at its level
+    u32* parents;        // the node one level up that is missing the block
+    u8* levels;
+    u32 count;
+    u32 capacity;
+};
+
+// Marks the missing child of parent at coord, one level below parent, as exterior and queues it unless it already is.
+void ReachSvoEmptyBlock(SvoExteriorFlood* flood, int level, u32 parent, Vector3Int coord) {
+    int child = (coord.x & 1) | ((coord.y & 1) << 1) | ((coord.z & 1) << 2);
+    u8* mask = &flood->exterior->masks[level - 1][parent];
+    if (*mask & (1u << child)) {
+        return;
+    }
+    *mask |= (u8)(1u << child);
+    flood->exterior->blockCount++;
+    
+    if (flood->count == flood->capacity) {
+        flood->capacity = Max(1024u, flood->capacity * 2);
+        flood->coords = (Vector3Int*)HeapAllocator.realloc(flood->coords, flood->capacity * sizeof(Vector3Int));
+        flood->parents = (u32*)HeapAllocator.realloc(flood->parents, flood->capacity * sizeof(u32));
+        flood->levels = (u8*)HeapAllocator.realloc(flood->levels, flood->capacity * sizeof(u8));
+    }
+    flood->coords[flood->count] = coord;
+    flood->parents[flood->count] = parent;
+    flood->levels[flood->count] = (u8)level;
+    flood->count++;
+}
+
+// Reaches every empty block in the subtree of node that touches its side of axis, 0 for the low side, 1 for the high.
+// Only the children on that side are entered, so the cost follows the area of the side.
+void ReachSvoEmptyBlocksOnSide(SvoExteriorFlood* flood, int level, u32 node, Vector3Int coord, int axis, int side) {
+    SvoImport* svo = flood->svo;
+    u8 mask = svo->masksAtLevel[level][node];
+    for (int child = 0; child < 8; child++) {
+        if (((child >> axis) & 1) != side) {
+            continue;
+        }
+        
+        Vector3Int childCoord = { coord.x * 2 + (child & 1), coord.y * 2 + ((child >> 1) & 1), coord.z * 2 + (child >> 2) };
+        if ((mask & (1u << child)) == 0) {
+            ReachSvoEmptyBlock(flood, level + 1, node, childCoord);
+        } else if (level + 1 < flood->exterior->lvl) {
+            // Solid subtrees have no empty blocks.
+            u32 childNode = svo->firstChild[level][node] + Popcount8(mask & ((1u << child) - 1u));
+            if (svo->solidLevels[level + 1][childNode] < flood->exterior->lvl - level - 1) {
+                ReachSvoEmptyBlocksOnSide(flood, level + 1, childNode, childCoord, axis, side);
+            }
+        }
+    }
+}
+
+// Floods the empty space at lvl from the 6 sides of the root inward into exterior, replacing what it held. Every 
+// reached block spreads to what is across each of its faces: one block of the same size or larger, or the empty 
+// blocks on the near side of a subtree, found with one walk down from the root. Voxels of lvl stop the flood.
+// Runs again from scratch after every edit, the masks are indexed by node and edits move the nodes around.
+void FloodSvoExterior(SvoImport* svo, int lvl, SvoExterior* exterior) {
+    if (exterior->masks) {
+        for (int level = 0; level < exterior->lvl; level++) {
+            HeapAllocator.free(exterior->masks[level]);
+        }
+        HeapAllocator.free(exterior->masks);
+    }
+    exterior->lvl = lvl;
+    exterior->blockCount = 0;
+    exterior->masks = (u8**)HeapAllocator.alloc(lvl * sizeof(u8*));
+    for (int level = 0; level < lvl; level++) {
+        exterior->masks[level] = (u8*)HeapAllocator.alloc(Max(1u, svo->nodesAtLevel[level]));
+        memset(exterior->masks[level], 0, svo->nodesAtLevel[level]);
+    }
+    
+    SvoExteriorFlood flood = {};
+    flood.svo = svo;
+    flood.exterior = exterior;
+    if (svo->nodesAtLevel[0] == 0 || lvl == 0) {
+        return;
+    }
+    for (int axis = 0; axis < 3; axis++) {
+        ReachSvoEmptyBlocksOnSide(&flood, 0, 0, Vector3Int{ 0, 0, 0 }, axis, 0);
+        ReachSvoEmptyBlocksOnSide(&flood, 0, 0, Vector3Int{ 0, 0, 0 }, axis, 1);
+    }
+    
+    while (flood.count > 0) {
+        flood.count--;
+        Vector3Int coord = flood.coords[flood.count];
+        int level = flood.levels[flood.count];
+        int last = (1 << level) - 1;
+        
+        for (int direction = 0; direction < SvoFace_Count; direction++) {
+            int axis = direction >> 1;
+            bool positive = (direction & 1) == 0;
+            int c[3] = { coord.x, coord.y, coord.z };
+            c[axis] += positive ? 1 : -1;
+            if (c[axis] < 0 || c[axis] > last) {
+                continue; // outside the root, which is all exterior
+            }
+            
+            // Down from the root to the node across the face. A missing node on the way is an empty block of that 
+            // size or larger right there.
+            u32 node = 0;
+            bool found = true;
+            for (int k = 0; k < level; k++) {
+                int shift = level - 1 - k;
+                int child = ((c[0] >> shift) & 1) | (((c[1] >> shift) & 1) << 1) | (((c[2] >> shift) & 1) << 2);
+                u8 mask = svo->masksAtLevel[k][node];
+                if ((mask & (1u << child)) == 0) {
+                    ReachSvoEmptyBlock(&flood, k + 1, node, Vector3Int{ c[0] >> shift, c[1] >> shift, c[2] >> shift });
+                    found = false;
+                    break;
+                }
+                node = svo->firstChild[k][node] + Popcount8(mask & ((1u << child) - 1u));
+            }
+            if (found && level < lvl) {
+                ReachSvoEmptyBlocksOnSide(&flood, level, node, Vector3Int{ c[0], c[1], c[2] }, axis, positive ? 0 : 1);
+            }
+        }
+    }
+    
+    HeapAllocator.free(flood.coords);
+    HeapAllocator.free(flood.parents);
+    HeapAllocator.free(flood.levels);
+}
+
+// Sets the bits of the voxels in [lo, hi) in rows laid out like SvoMeshScratch::occupancy, at most 64 voxels along x.
+void SetSvoOccupancyBox(u64 (*rows)[SVO_MESH_REGION_SIZE], int lo[3], int hi[3]) {
+    u64 bits = ((hi[0] - lo[0] == 64) ? ~0ull : ((1ull << (hi[0] - lo[0])) - 1)) << lo[0];
+    for (int z = lo[2]; z < hi[2]; z++) {
+        for (int y = lo[1]; y < hi[1]; y++) {
+            rows[z][y] |= bits;
+        }
+    }
+}
+
+// Sets the cavities bits of the cavity voxels of meshLevel in the subtree of node that lie in [clipMin, clipMax). 
+// Bit x of cavities[z][y] is the voxel at base + (x, y, z). Walks the same nodes as the filled voxels themselves.
+void FillSvoCavityOccupancy(SvoMeshScratch* scratch, SvoImport* svo, SvoExterior* exterior, int meshLevel, int level, 
+                            u32 node, Vector3Int coord, Vector3Int clipMin, Vector3Int clipMax, Vector3Int base) {
+    u8 mask = svo->masksAtLevel[level][node];
+    u8 cavities = (u8)~(mask | exterior->masks[level][node]);
+    int size = 1 << (meshLevel - level - 1);
+    for (int child = 0; child < 8; child++) {
+        int lo[3] = { (coord.x * 2 + (child & 1)) * size, (coord.y * 2 + ((child >> 1) & 1)) * size, (coord.z * 2 + (child >> 2)) * size };
+        int hi[3] = { lo[0] + size, lo[1] + size, lo[2] + size };
+        int clipLo[3] = { clipMin.x, clipMin.y, clipMin.z };
+        int clipHi[3] = { clipMax.x, clipMax.y, clipMax.z };
+        int baseAxis[3] = { base.x, base.y, base.z };
+        bool overlaps = true;
+        for (int a = 0; a < 3; a++) {
+            lo[a] = Max(lo[a], clipLo[a]) - baseAxis[a];
+            hi[a] = Min(hi[a], clipHi[a]) - baseAxis[a];
+            overlaps = overlaps && lo[a] < hi[a];
+        }
+        if (!overlaps) {
+            continue;
+        }
+        
+        if (cavities & (1u << child)) {
+            SetSvoOccupancyBox(scratch->cavities, lo, hi);
+        } else if ((mask & (1u << child)) && level + 1 < meshLevel) {
+            u32 childNode = svo->firstChild[level][node] + Popcount8(mask & ((1u << child) - 1u));
+            if (svo->solidLevels[level + 1][childNode] >= meshLevel - level - 1) {
+                continue;
+            }
+            Vector3Int childCoord = { coord.x * 2 + (child & 1), coord.y * 2 + ((child >> 1) & 1), coord.z * 2 + (child >> 2) };
+            FillSvoCavityOccupancy(scratch, svo, exterior, meshLevel, level + 1, childNode, childCoord, clipMin, clipMax, base);
+        }
+    }
+}
+
+// Surface nets, the smooth mesher. A cell is the cube between the centers of 2x2x2 voxels, and every cell with both 
+// filled and empty corners gets a vertex at the average of the midpoints of its edges that cross the surface. Every 
+// exposed voxel face becomes a quad between the vertices of the 4 cells around its edge. That is a quad per face, 
+// more than greedy cubes, so every region's net is then simplified by collapsing vertices as long as the surface stays
+// close to them, which leaves few large triangles on flat and gently curved parts.
+//
+// Positions are fixed point with SVO_MESH_NET_PRECISION bits per root side, and w holds the normal from the cell's
+// occupancy gradient in octahedral encoding, 8 bits per component.
+#define SVO_MESH_NET_PRECISION 15
+
+// Occupancy of the voxels of a region of size voxels at origin plus the one voxel thick shell around it, where the 
+// neighboring chunks are read when withNeighbors is set and everything is empty otherwise. With exterior the 
+// cavities are filled too, so no face is exposed towards them, and also kept in cavities, so they have no faces of
+// their own, see SvoOccupancyFaceRows(). With solidBlocks solid subtrees are set a row at a time instead of per voxel.
+// Bit x + 1 of occupancy[z + 1][y + 1] is the voxel at origin + (x, y, z).
+void FillSvoOccupancy(SvoMeshScratch* scratch, SvoImport* svo, int lvl, int chunkLevel, Vector3Int chunk, int size, 
+                      bool withNeighbors, SvoExterior* exterior, bool solidBlocks) {
+    ASSERT_ERROR(size + 2 <= SVO_MESH_REGION_SIZE, "Occupancy needs chunks of at most %d voxels per side.", SVO_MESH_REGION_SIZE - 2);
+    for (int z = 0; z < size + 2; z++) {
+        memset(scratch->occupancy[z], 0, (size + 2) * sizeof(u64));
+        memset(scratch->cavities[z], 0, (size + 2) * sizeof(u64));
+    }
+    
+    Vector3Int origin = { chunk.x * size, chunk.y * size, chunk.z * size };
+    Vector3Int clipMin = { origin.x - 1, origin.y - 1, origin.z - 1 };
+    Vector3Int clipMax = { origin.x + size + 1, origin.y + size + 1, origin.z + size + 1 };
+    int range = withNeighbors ? 1 : 0;
+    for (int dz = -range; dz <= range; dz++) {
+        for (int dy = -range; dy <= range; dy++) {
+            for (int dx = -range; dx <= range; dx++) {
+                Vector3Int c = { chunk.x + dx, chunk.y + dy, chunk.z + dz };
+                u32 node = FindSvoNode(svo, chunkLevel, c);
+                if (node == SVO_NO_NODE) {
+                    continue;
+                }
+                
+                SvoLeafIterator leaves;
+                BeginSvoLeaves(&leaves, svo, lvl, chunkLevel, node, c, 0);
+                ClipSvoLeaves(&leaves, clipMin, clipMax);
+                if (solidBlocks) {
+                    WalkSvoSolidLeaves(&leaves, SvoSolidWalk_Blocks);
+                }
+                while (NextSvoLeaf(&leaves)) {
+                    Vector3Int local = { leaves.coord.x - clipMin.x, leaves.coord.y - clipMin.y, leaves.coord.z - clipMin.z };
+                    if (leaves.blockShift == 0) {
+                        scratch->occupancy[local.z][local.y] |= 1ull << local.x;
+                    } else {
+                        int blockSize = 1 << leaves.blockShift;
+                        int lo[3] = { local.x, local.y, local.z };
+                        int hi[3] = { local.x + blockSize, local.y + blockSize, local.z + blockSize };
+                        SetSvoOccupancyBox(scratch->occupancy, lo, hi);
+                    }
+                }
+            }
+        }
+    }
+    
+    if (exterior && lvl > 0 && svo->nodesAtLevel[0] > 0) {
+        Vector3Int cavityMin = withNeighbors ? clipMin : origin;
+        Vector3Int cavityMax = withNeighbors ? clipMax : Vector3Int{ origin.x + size, origin.y + size, origin.z + size };
+        FillSvoCavityOccupancy(scratch, svo, exterior, lvl, 0, 0, Vector3Int{ 0, 0, 0 }, cavityMin, cavityMax, clipMin);
+        for (int z = 0; z < size + 2; z++) {
+            for (int y = 0; y < size + 2; y++) {
+                scratch->occupancy[z][y] |= scratch->cavities[z][y];
+            }
+        }
+    }
+}
+
+// Bit i is set when corner i of the cell at c is filled. Corner i is the voxel c + (i & 1, (i >> 1) & 1, i >> 2),
+// the same order as the children of a node, so every pair of bits comes from one occupancy row.
+u8 SvoCellMask(SvoMeshScratch* scratch, int c[3]) {
+    u64 (*occupancy)[SVO_MESH_REGION_SIZE] = scratch->occupancy;
+    int shift = c[0] + 1;
+    int y = c[1] + 1;
+    int z = c[2] + 1;
+    return (u8)(((occupancy[z][y] >> shift) & 3) | (((occupancy[z][y + 1] >> shift) & 3) << 2) |
+                (((occupancy[z + 1][y] >> shift) & 3) << 4) | (((occupancy[z + 1][y + 1] >> shift) & 3) << 6));
+}
+
+// The exposed faces of the row of voxels at y, z for every SvoFaceDirection, in the bits of the occupancy rows.
+// inside masks the voxels of the region.
+void SvoOccupancyFaceRows(SvoMeshScratch* scratch, u64 inside, int y, int z, u64* faceRows) {
+    u64 (*occupancy)[SVO_MESH_REGION_SIZE] = scratch->occupancy;
+    u64 row = occupancy[z + 1][y + 1] & ~scratch->cavities[z + 1][y + 1] & inside;
+    faceRows[SvoFace_PositiveX] = row & ~(occupancy[z + 1][y + 1] >> 1);
+    faceRows[SvoFace_NegativeX] = row & ~(occupancy[z + 1][y + 1] << 1);
+    faceRows[SvoFace_PositiveY] = row & ~occupancy[z + 1][y + 2];
+    faceRows[SvoFace_NegativeY] = row & ~occupancy[z + 1][y];
+    faceRows[SvoFace_PositiveZ] = row & ~occupancy[z + 2][y + 1];
+    faceRows[SvoFace_NegativeZ] = row & ~occupancy[z][y + 1];
+}
+
+u16 EncodeSvoNormal(float x, float y, float z) {
+    float length = Abs(x) + Abs(y) + Abs(z);
+    float u = x / length;
+    float v = y / length;
+    if (z < 0) {
+        float fu = (1.0f - Abs(v)) * (u >= 0 ? 1.0f : -1.0f);
+        float fv = (1.0f - Abs(u)) * (v >= 0 ? 1.0f : -1.0f);
+        u = fu;
+        v = fv;
+    }
+    int eu = (int)((u * 0.5f + 0.5f) * 255.0f + 0.5f);
+    int ev = (int)((v * 0.5f + 0.5f) * 255.0f + 0.5f);
+    return (u16)(eu | (ev << 8));
+}
+
+// What the corners of a cell contribute to its vertex, for every cell mask: the sum of the midpoints of the edges
+// that cross the surface, relative to the cell in half voxels, their count and the normal from the occupancy gradient.
+struct SvoNetCell {
+    u8 sum[3];
+    u8 count;
+    u16 normal;
+};
+
+SvoNetCell svoNetCells[256];
+bool svoNetCellsReady;
+
+void InitSvoNetCells() {
+    for (int mask = 0; mask < 256; mask++) {
+        SvoNetCell* cell = &svoNetCells[mask];
+        int sum[3] = {};
+        int count = 0;
+        int gradient[3] = {};
+        for (int i = 0; i < 8; i++) {
+            int filled = (mask >> i) & 1;
+            for (int axis = 0; axis < 3; axis++) {
+                gradient[axis] += filled ? (((i >> axis) & 1) ? 1 : -1) : 0;
+                
+                // Corner centers are at 1 and 3 along every axis, the midpoint of an edge along axis is at 2.
+                int bit = 1 << axis;
+                if ((i & bit) || filled == ((mask >> (i | bit)) & 1)) {
+                    continue;
+                }
+                for (int a = 0; a < 3; a++) {
+                    sum[a] += (a == axis) ? 2 : 1 + 2 * ((i >> a) & 1);
+                }
+                count++;
+            }
+        }
+        
+        cell->sum[0] = (u8)sum[0];
+        cell->sum[1] = (u8)sum[1];
+        cell->sum[2] = (u8)sum[2];
+        cell->count = (u8)count;
+        // The gradient points into the filled voxels. It cancels out for some diagonal masks, which just face up.
+        if (gradient[0] == 0 && gradient[1] == 0 && gradient[2] == 0) {
+            gradient[1] = -1;
+        }
+        cell->normal = EncodeSvoNormal((float)-gradient[0], (float)-gradient[1], (float)-gradient[2]);
+    }
+    svoNetCellsReady = true;
+}
+
+// The vertex of the cell at c, local to the region at origin.
+Vertex_Voxel SvoNetVertex(SvoMeshScratch* scratch, int c[3], int origin[3], int positionShift) {
+    SvoNetCell* cell = &svoNetCells[SvoCellMask(scratch, c)];
+    ASSERT_DEBUG(cell->count > 0, "Cell has no surface.");
+    
+    u16 p[3];
+    for (int a = 0; a < 3; a++) {
+        s64 doubled = 2 * (s64)(origin[a] + c[a]) * cell->count + cell->sum[a];
+        p[a] = (u16)(((doubled << positionShift) + cell->count) / (2 * cell->count));
+    }
+    return Vertex_Voxel{ p[0], p[1], p[2], cell->normal };
+}
+
+// How far, in voxels of the meshed level, SimplifySvoNetRegion() may move the surface away from the vertices it
+// removes.
+#define SVO_MESH_NET_TOLERANCE 0.25f
+
+// Passes over the changed vertices per phase of SimplifySvoNetRegion(). The first pass does nearly all collapses,
+// the ones after it mostly retry vertices that still cannot go.
+#define SVO_MESH_NET_MAX_PASSES 2
+
+// Rings with more triangles than this are left alone.
+#define SVO_MESH_NET_MAX_RING 64
+
+// The triangles around a vertex v, each as v, a, b in winding order. A closed ring is a single fan whose edges a, b
+// chain around v, an open one ends at the mesh boundary, with edges first to v and v to last along it.
+struct SvoNetRing {
+    u32 triangles[SVO_MESH_NET_MAX_RING];
+    u32 a[SVO_MESH_NET_MAX_RING];
+    u32 b[SVO_MESH_NET_MAX_RING];
+    s64 normals[SVO_MESH_NET_MAX_RING][3]; // of v, a, b, only filled for the ring being collapsed
+    u32 count;
+    bool closed;
+    u32 first;
+    u32 last;
+};
+
+// The triangles of a ring once v collapses into u, without the ones that have u, as offsets from u. Each has a 
+// bounding sphere to skip it when a point cannot get closer to it than to another.
+struct SvoNetFan {
+    u32 slots[SVO_MESH_NET_MAX_RING]; // per triangle of the ring, SVO_MESH_NET_MAX_RING for the ones that have u
+    u32 triangles[SVO_MESH_NET_MAX_RING];
+    Vector3 a[SVO_MESH_NET_MAX_RING];
+    Vector3 b[SVO_MESH_NET_MAX_RING];
+    Vector3 centers[SVO_MESH_NET_MAX_RING];
+    float radii[SVO_MESH_NET_MAX_RING];
+    u32 count;
+};
+
+// Region mesh being simplified, local to its first vertex. Every triangle corner is on the list of its vertex, which
+// moves over to the vertex it collapses into, so the lists also hold dead triangles, those with indices of ~0u.
+//
+// A vertex removed by a collapse that moves the surface is a point on the list of a triangle it is within the 
+// tolerance of, and is checked again whenever that triangle changes. Exact collapses do not move the surface, what 
+// they remove is not tracked.
+struct SvoNetSimplifier {
+    Vertex_Voxel* vertices;
+    u32* indices;
+    u32* heads;
+    u32* tails;
+    u32* nexts;
+    bool* removed;
+    bool* pending;     // vertices to try again, their ring changed since
+    u32* pointHeads;   // per triangle
+    u32* pointNexts;   // per vertex
+    float tolerance;   // in fixed point
+};
+
+// Fills ring with the live triangles around v and returns whether they form a single fan, closed or open.
+bool GatherSvoNetRing(SvoNetSimplifier* simplifier, u32 v, SvoNetRing* ring) {
+    // Dead triangles are unlinked on the way.
+    ring->count = 0;
+    u32 previous = 0xFFFFFFFF;
+    for (u32 corner = simplifier->heads[v]; corner != 0xFFFFFFFF; corner = simplifier->nexts[corner]) {
+        u32* triangle = simplifier->indices + corner / 3 * 3;
+        if (triangle[0] == 0xFFFFFFFF) {
+            if (previous == 0xFFFFFFFF) {
+                simplifier->heads[v] = simplifier->nexts[corner];
+            } else {
+                simplifier->nexts[previous] = simplifier->nexts[corner];
+            }
+            if (simplifier->tails[v] == corner) {
+                simplifier->tails[v] = previous;
+            }
+            continue;
+        }
+        previous = corner;
+        if (ring->count == SVO_MESH_NET_MAX_RING) {
+            return false;
+        }
+        u32 i = corner % 3;
+        ring->triangles[ring->count] = corner / 3;
+        ring->a[ring->count] = triangle[(i + 1) % 3];
+        ring->b[ring->count] = triangle[(i + 2) % 3];
+        ring->count++;
+    }
+    if (ring->count == 0) {
+        return false;
+    }
+    
+    // Every edge from v is followed by at most one triangle in winding order and preceded by at most one. The fan 
+    // starts at an edge nothing precedes, or anywhere when it is closed.
+    u32 nexts[SVO_MESH_NET_MAX_RING];
+    u32 start = 0;
+    u32 starts = 0;
+    for (u32 i = 0; i < ring->count; i++) {
+        u32 followers = 0;
+        u32 predecessors = 0;
+        nexts[i] = ring->count;
+        for (u32 j = 0; j < ring->count; j++) {
+            followers += ring->a[j] == ring->a[i];
+            predecessors += ring->b[j] == ring->a[i];
+            if (ring->a[j] == ring->b[i]) {
+                nexts[i] = j;
+            }
+        }
+        if (followers > 1 || predecessors > 1) {
+            return false;
+        }
+        if (predecessors == 0) {
+            start = i;
+            starts++;
+        }
+    }
+    if (starts > 1) {
+        return false;
+    }
+    
+    u32 current = start;
+    u32 visited = 1;
+    while (nexts[current] != ring->count && nexts[current] != start) {
+        current = nexts[current];
+        visited++;
+    }
+    ring->closed = starts == 0;
+    ring->first = ring->a[start];
+    ring->last = ring->b[current];
+    return visited == ring->count;
+}
+
+// The neighbors of a ring's vertex are the a corners of its triangles, and last when it is open.
+bool SvoNetRingHasNeighbor(SvoNetRing* ring, u32 w) {
+    for (u32 i = 0; i < ring->count; i++) {
+        if (ring->a[i] == w) {
+            return true;
+        }
+    }
+    return !ring->closed && ring->last == w;
+}
+
+Vector3 SvoNetOffset(SvoNetSimplifier* simplifier, u32 from, u32 to) {
+    Vertex_Voxel* a = &simplifier->vertices[from];
+    Vertex_Voxel* b = &simplifier->vertices[to];
+    return Vector3{ (float)((int)b->x - a->x), (float)((int)b->y - a->y), (float)((int)b->z - a->z) };
+}
+
+// Distance from the origin to the triangle a, b, c, from the regions of its closest point.
+float SvoOriginTriangleDistance(Vector3 a, Vector3 b, Vector3 c) {
+    Vector3 ab = b - a;
+    Vector3 ac = c - a;
+    Vector3 ap = a * -1.0f;
+    float d1 = DotProduct(ab, ap);
+    float d2 = DotProduct(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f) {
+        return sqrtf(DotProduct(a, a));
+    }
+    Vector3 bp = b * -1.0f;
+    float d3 = DotProduct(ab, bp);
+    float d4 = DotProduct(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3) {
+        return sqrtf(DotProduct(b, b));
+    }
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+        Vector3 q = a + ab * (d1 / (d1 - d3));
+        return sqrtf(DotProduct(q, q));
+    }
+    Vector3 cp = c * -1.0f;
+    float d5 = DotProduct(ab, cp);
+    float d6 = DotProduct(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6) {
+        return sqrtf(DotProduct(c, c));
+    }
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+        Vector3 q = a + ac * (d2 / (d2 - d6));
+        return sqrtf(DotProduct(q, q));
+    }
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f) {
+        Vector3 q = b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+        return sqrtf(DotProduct(q, q));
+    }
+    float denominator = 1.0f / (va + vb + vc);
+    Vector3 q = a + ab * (vb * denominator) + ac * (vc * denominator);
+    return sqrtf(DotProduct(q, q));
+}
+
+void BuildSvoNetFan(SvoNetSimplifier* simplifier, SvoNetRing* ring, u32 u, SvoNetFan* fan) {
+    fan->count = 0;
+    for (u32 i = 0; i < ring->count; i++) {
+        fan->slots[i] = SVO_MESH_NET_MAX_RING;
+        if (ring->a[i] != u && ring->b[i] != u) {
+            fan->slots[i] = fan->count;
+            fan->triangles[fan->count] = ring->triangles[i];
+            Vector3 a = SvoNetOffset(simplifier, u, ring->a[i]);
+            Vector3 b = SvoNetOffset(simplifier, u, ring->b[i]);
+            Vector3 center = (a + b) * (1.0f / 3.0f);
+            Vector3 toA = a - center;
+            Vector3 toB = b - center;
+            float radius = Max(DotProduct(center, center), Max(DotProduct(toA, toA), DotProduct(toB, toB)));
+            fan->a[fan->count] = a;
+            fan->b[fan->count] = b;
+            fan->centers[fan->count] = center;
+            fan->radii[fan->count] = sqrtf(radius);
+            fan->count++;
+        }
+    }
+}
+
+// Distance from the vertex p to the triangles of fan, the closest one in closest, starting with the one in slot first
+// if there is one there, likely the closest. Stops at the first one closer than enough.
+float SvoNetFanDistance(SvoNetSimplifier* simplifier, SvoNetFan* fan, u32 u, u32 p, u32 first, float enough, 
+                        u32* closest) {
+    float distance = FLT_MAX;
+    Vector3 up = SvoNetOffset(simplifier, u, p);
+    Vector3 pu = up * -1.0f;
+    if (first < fan->count) {
+        distance = SvoOriginTriangleDistance(pu, fan->a[first] - up, fan->b[first] - up);
+        *closest = fan->triangles[first];
+    }
+    for (u32 i = 0; i < fan->count && distance > enough; i++) {
+        if (i == first) {
+            continue;
+        }
+        Vector3 toCenter = fan->centers[i] - up;
+        float reach = distance + fan->radii[i];
+        if (distance != FLT_MAX && DotProduct(toCenter, toCenter) >= reach * reach) {
+            continue;
+        }
+        float d = SvoOriginTriangleDistance(pu, fan->a[i] - up, fan->b[i] - up);
+        if (d < distance) {
+            distance = d;
+            *closest = fan->triangles[i];
+        }
+    }
+    return distance;
+}
+
+// How far v and the points of its triangles get from the surface when v collapses into u, stopping once past the 
+// tolerance.
+float SvoNetCollapseError(SvoNetSimplifier* simplifier, SvoNetRing* ring, SvoNetFan* fan, u32 u, u32 v) {
+    float tolerance = simplifier->tolerance;
+    u32 closest;
+    float error = SvoNetFanDistance(simplifier, fan, u, v, SVO_MESH_NET_MAX_RING, tolerance, &closest);
+    for (u32 i = 0; i < ring->count && error <= tolerance; i++) {
+        u32 t = ring->triangles[i];
+        for (u32 p = simplifier->pointHeads[t]; p != 0xFFFFFFFF && error <= tolerance; p = simplifier->pointNexts[p]) {
+            error = Max(error, SvoNetFanDistance(simplifier, fan, u, p, fan->slots[i], tolerance, &closest));
+        }
+    }
+    return error;
+}
+
+void SvoNetTriangleNormal(SvoNetSimplifier* simplifier, u32 i0, u32 i1, u32 i2, s64 normal[3]) {
+    Vertex_Voxel* p0 = &simplifier->vertices[i0];
+    Vertex_Voxel* p1 = &simplifier->vertices[i1];
+    Vertex_Voxel* p2 = &simplifier->vertices[i2];
+    s64 e1[3] = { (s64)p1->x - p0->x, (s64)p1->y - p0->y, (s64)p1->z - p0->z };
+    s64 e2[3] = { (s64)p2->x - p0->x, (s64)p2->y - p0->y, (s64)p2->z - p0->z };
+    normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+    normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+    normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+// Whether u lies in the plane of every triangle of ring that does not have it. With no triangle flipped, the ones 
+// with u in place of v then cover exactly what they did, e.g. inside a flat area or along a straight edge, so the 
+// collapse leaves the surface as it is.
+bool IsSvoNetCollapseExact(SvoNetSimplifier* simplifier, SvoNetRing* ring, u32 u, u32 v) {
+    Vertex_Voxel* pv = &simplifier->vertices[v];
+    Vertex_Voxel* pu = &simplifier->vertices[u];
+    s64 offset[3] = { (s64)pu->x - pv->x, (s64)pu->y - pv->y, (s64)pu->z - pv->z };
+    for (u32 i = 0; i < ring->count; i++) {
+        if (ring->a[i] == u || ring->b[i] == u) {
+            continue;
+        }
+        s64* normal = ring->normals[i];
+        if (normal[0] * offset[0] + normal[1] * offset[1] + normal[2] * offset[2] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Whether v can collapse into its neighbor u without changing the topology, flipping or flattening a triangle, or 
+// moving the mesh boundary. ring is v's.
+bool CanCollapseSvoNetVertex(SvoNetSimplifier* simplifier, SvoNetRing* ring, u32 u, u32 v, SvoNetRing* uRing) {
+    // Open rings only slide along the boundary, onto a neighbor on the same straight line as the other one, so the 
+    // boundary stays where the neighboring region's is.
+    if (!ring->closed) {
+        if (u != ring->first && u != ring->last) {
+            return false;
+        }
+        u32 w = (u == ring->first) ? ring->last : ring->first;
+        Vertex_Voxel* pu = &simplifier->vertices[u];
+        Vertex_Voxel* pv = &simplifier->vertices[v];
+        Vertex_Voxel* pw = &simplifier->vertices[w];
+        s64 d0[3] = { (s64)pv->x - pw->x, (s64)pv->y - pw->y, (s64)pv->z - pw->z };
+        s64 d1[3] = { (s64)pu->x - pv->x, (s64)pu->y - pv->y, (s64)pu->z - pv->z };
+        if (d0[1] * d1[2] != d0[2] * d1[1] || d0[2] * d1[0] != d0[0] * d1[2] || d0[0] * d1[1] != d0[1] * d1[0] ||
+            d0[0] * d1[0] + d0[1] * d1[1] + d0[2] * d1[2] <= 0) {
+            return false;
+        }
+    }
+    
+    // The only neighbors u and v share are the third corners of the triangles on their edge, and some triangle has 
+    // to be left.
+    if (!GatherSvoNetRing(simplifier, u, uRing)) {
+        return false;
+    }
+    u32 shared = 0;
+    u32 edgeTriangles = 0;
+    for (u32 i = 0; i <= ring->count; i++) {
+        if (i < ring->count) {
+            edgeTriangles += ring->a[i] == u || ring->b[i] == u;
+        }
+        u32 w = (i < ring->count) ? ring->a[i] : ring->last;
+        if ((i == ring->count && ring->closed) || w == u) {
+            continue;
+        }
+        shared += SvoNetRingHasNeighbor(uRing, w);
+    }
+    if (shared != edgeTriangles || edgeTriangles == ring->count) {
+        return false;
+    }
+    
+    for (u32 i = 0; i < ring->count; i++) {
+        if (ring->a[i] == u || ring->b[i] == u) {
+            continue;
+        }
+        s64* before = ring->normals[i];
+        s64 after[3];
+        SvoNetTriangleNormal(simplifier, u, ring->a[i], ring->b[i], after);
+        if ((after[0] == 0 && after[1] == 0 && after[2] == 0) || 
+            (double)before[0] * after[0] + (double)before[1] * after[1] + (double)before[2] * after[2] <= 0.0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Moves the triangles of ring from v to u, dropping the ones that have u, and the points on them to the closest of the
+// new ones, with v itself when the collapse moves the surface.
+void CollapseSvoNetEdge(SvoNetSimplifier* simplifier, SvoNetRing* ring, SvoNetFan* fan, u32 u, u32 v, bool exact) {
+    u32 points[SVO_MESH_NET_MAX_RING + 1];
+    for (u32 i = 0; i < ring->count; i++) {
+        points[i] = simplifier->pointHeads[ring->triangles[i]];
+        simplifier->pointHeads[ring->triangles[i]] = 0xFFFFFFFF;
+    }
+    points[ring->count] = 0xFFFFFFFF;
+    if (!exact) {
+        simplifier->pointNexts[v] = 0xFFFFFFFF;
+        points[ring->count] = v;
+    }
+    for (u32 i = 0; i <= ring->count; i++) {
+        u32 first = (i < ring->count) ? fan->slots[i] : SVO_MESH_NET_MAX_RING;
+        for (u32 p = points[i]; p != 0xFFFFFFFF;) {
+            u32 next = simplifier->pointNexts[p];
+            u32 closest;
+            SvoNetFanDistance(simplifier, fan, u, p, first, 0.0f, &closest);
+            simplifier->pointNexts[p] = simplifier->pointHeads[closest];
+            simplifier->pointHeads[closest] = p;
+            p = next;
+        }
+    }
+    
+    for (u32 i = 0; i < ring->count; i++) {
+        u32* triangle = simplifier->indices + ring->triangles[i] * 3;
+        simplifier->pending[ring->a[i]] = true;
+        simplifier->pending[ring->b[i]] = true;
+        if (ring->a[i] == u || ring->b[i] == u) {
+            triangle[0] = triangle[1] = triangle[2] = 0xFFFFFFFF;
+            continue;
+        }
+        for (int corner = 0; corner < 3; corner++) {
+            if (triangle[corner] == v) {
+                triangle[corner] = u;
+            }
+        }
+    }
+    simplifier->nexts[simplifier->tails[u]] = simplifier->heads[v];
+    simplifier->tails[u] = simplifier->tails[v];
+    simplifier->removed[v] = true;
+}
+
+// Collapses v into a neighbor it can go to, the exact collapses along the shortest edges first, then the ones that 
+// leave v closest to the surface unless exactOnly. Open rings have only their two boundary neighbors to try. Returns 
+// whether it did.
+bool CollapseSvoNetVertex(SvoNetSimplifier* simplifier, u32 v, bool exactOnly, SvoNetRing* ring, SvoNetRing* uRing) {
+    if (simplifier->removed[v] || !GatherSvoNetRing(simplifier, v, ring)) {
+        return false;
+    }
+    for (u32 i = 0; i < ring->count; i++) {
+        SvoNetTriangleNormal(simplifier, v, ring->a[i], ring->b[i], ring->normals[i]);
+    }
+    
+    u32 candidates[SVO_MESH_NET_MAX_RING + 1];
+    float keys[SVO_MESH_NET_MAX_RING + 1];
+    u32 candidateCount = 0;
+    for (u32 i = 0; i <= ring->count; i++) {
+        u32 u = (i < ring->count) ? ring->a[i] : ring->last;
+        if ((i == ring->count && ring->closed) || (!ring->closed && u != ring->first && u != ring->last)) {
+            continue;
+        }
+        Vector3 edge = SvoNetOffset(simplifier, v, u);
+        float key = DotProduct(edge, edge);
+        u32 slot = candidateCount++;
+        while (slot > 0 && keys[slot - 1] > key) {
+            candidates[slot] = candidates[slot - 1];
+            keys[slot] = keys[slot - 1];
+            slot--;
+        }
+        candidates[slot] = u;
+        keys[slot] = key;
+    }
+    
+    SvoNetFan fan;
+    u32 inexactCount = 0;
+    for (u32 c = 0; c < candidateCount; c++) {
+        u32 u = candidates[c];
+        if (!IsSvoNetCollapseExact(simplifier, ring, u, v)) {
+            candidates[inexactCount++] = u;
+            continue;
+        }
+        if (CanCollapseSvoNetVertex(simplifier, ring, u, v, uRing)) {
+            BuildSvoNetFan(simplifier, ring, u, &fan);
+            CollapseSvoNetEdge(simplifier, ring, &fan, u, v, true);
+            return true;
+        }
+    }
+    if (exactOnly) {
+        return false;
+    }
+    
+    // The rest along the shortest edges first too.
+    for (u32 c = 0; c < inexactCount; c++) {
+        u32 u = candidates[c];
+        BuildSvoNetFan(simplifier, ring, u, &fan);
+        if (SvoNetCollapseError(simplifier, ring, &fan, u, v) <= simplifier->tolerance && 
+            CanCollapseSvoNetVertex(simplifier, ring, u, v, uRing)) {
+            CollapseSvoNetEdge(simplifier, ring, &fan, u, v, false);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Simplifies the surface net of one region from firstVertex and firstIndex on by collapsing vertices into neighbors
+// as long as the surface stays within SVO_MESH_NET_TOLERANCE of every vertex it removes, so flat and nearly flat parts
+// end up with a few large triangles. Vertices only ever move onto other vertices, positions and normals stay exact.
+// Vertices on the region's boundary only slide along it where it is straight, so neighboring regions still meet 
+// without cracks. Exact collapses go first, which is cheap, then the rest. Each visits the vertices whose ring changed
+// in order, for up to SVO_MESH_NET_MAX_PASSES passes, so the output only depends on the region. Then the triangles
+// are written back with the ones facing straight along an axis in its direction bucket and the rest first, and the
+// unused vertices are dropped. Returns the number of triangles.
+u32 SimplifySvoNetRegion(SvoMeshBuffer* mesh, u32 firstVertex, u32 firstIndex, int positionShift, u32* faceIndexCounts) {
+    u32 vertexCount = mesh->vertexCount - firstVertex;
+    u32 indexCount = mesh->indexCount - firstIndex;
+    u32 triangleCount = indexCount / 3;
+    
+    TempArenaMemory tempArena = TempArenaMemoryBegin(&tempAllocator);
+    
+    SvoNetSimplifier simplifier;
+    simplifier.vertices = mesh->vertices + firstVertex;
+    simplifier.indices = ALLOC_ARRAY(TempAllocator, u32, indexCount);
+    simplifier.heads = ALLOC_ARRAY(TempAllocator, u32, vertexCount);
+    simplifier.tails = ALLOC_ARRAY(TempAllocator, u32, vertexCount);
+    simplifier.nexts = ALLOC_ARRAY(TempAllocator, u32, indexCount);
+    simplifier.removed = ALLOC_ARRAY(TempAllocator, bool, vertexCount);
+    simplifier.pending = ALLOC_ARRAY(TempAllocator, bool, vertexCount);
+    simplifier.pointHeads = ALLOC_ARRAY(TempAllocator, u32, triangleCount);
+    simplifier.pointNexts = ALLOC_ARRAY(TempAllocator, u32, vertexCount);
+    simplifier.tolerance = SVO_MESH_NET_TOLERANCE * (float)(1 << positionShift);
+    memset(simplifier.heads, 0xFF, vertexCount * sizeof(u32));
+    memset(simplifier.removed, 0, vertexCount * sizeof(bool));
+    memset(simplifier.pointHeads, 0xFF, triangleCount * sizeof(u32));
+    
+    for (u32 corner = 0; corner < indexCount; corner++) {
+        u32 v = mesh->indices[firstIndex + corner] - firstVertex;
+        simplifier.indices[corner] = v;
+        simplifier.nexts[corner] = 0xFFFFFFFF;
+        if (simplifier.heads[v] == 0xFFFFFFFF) {
+            simplifier.heads[v] = corner;
+        } else {
+            simplifier.nexts[simplifier.tails[v]] = corner;
+        }
+        simplifier.tails[v] = corner;
+    }
+    
+    SvoNetRing ring;
+    SvoNetRing uRing;
+    for (int exactOnly = 1; exactOnly >= 0; exactOnly--) {
+        memset(simplifier.pending, 1, vertexCount * sizeof(bool));
+        bool collapsed = true;
+        for (int pass = 0; pass < SVO_MESH_NET_MAX_PASSES && collapsed; pass++) {
+            collapsed = false;
+            for (u32 v = 0; v < vertexCount; v++) {
+                if (simplifier.pending[v]) {
+                    simplifier.pending[v] = false;
+                    collapsed = CollapseSvoNetVertex(&simplifier, v, exactOnly == 1, &ring, &uRing) || collapsed;
+                }
+            }
+        }
+    }
+    
+    // Write the triangles back by bucket, the ones that can face any way first.
+    u32 bucketCounts[SvoFace_Count + 1] = {};
+    u8* buckets = ALLOC_ARRAY(TempAllocator, u8, triangleCount);
+    for (u32 t = 0; t < triangleCount; t++) {
+        u32* triangle = simplifier.indices + t * 3;
+        if (triangle[0] == 0xFFFFFFFF) {
+            buckets[t] = 0xFF;
+            continue;
+        }
+        s64 normal[3];
+        SvoNetTriangleNormal(&simplifier, triangle[0], triangle[1], triangle[2], normal);
+        int bucket = 0;
+        for (int axis = 0; axis < 3; axis++) {
+            if (normal[axis] != 0 && normal[(axis + 1) % 3] == 0 && normal[(axis + 2) % 3] == 0) {
+                bucket = 1 + axis * 2 + (normal[axis] < 0);
+            }
+        }
+        buckets[t] = (u8)bucket;
+        bucketCounts[bucket]++;
+    }
+    
+    u32* remap = simplifier.heads;
+    memset(remap, 0xFF, vertexCount * sizeof(u32));
+    u32 bucketStarts[SvoFace_Count + 1];
+    u32 liveCount = 0;
+    for (int bucket = 0; bucket <= SvoFace_Count; bucket++) {
+        bucketStarts[bucket] = liveCount;
+        liveCount += bucketCounts[bucket];
+    }
+    for (u32 t = 0; t < triangleCount; t++) {
+        if (buckets[t] == 0xFF) {
+            continue;
+        }
+        u32* output = mesh->indices + firstIndex + bucketStarts[buckets[t]]++ * 3;
+        for (int c = 0; c < 3; c++) {
+            output[c] = simplifier.indices[t * 3 + c];
+            remap[output[c]] = 0;
+        }
+    }
+    
+    u32 used = 0;
+    for (u32 v = 0; v < vertexCount; v++) {
+        if (remap[v] == 0) {
+            remap[v] = used;
+            simplifier.vertices[used++] = simplifier.vertices[v];
+        }
+    }
+    for (u32 i = 0; i < liveCount * 3; i++) {
+        mesh->indices[firstIndex + i] = firstVertex + remap[mesh->indices[firstIndex + i]];
+    }
+    mesh->vertexCount = firstVertex + used;
+    mesh->indexCount = firstIndex + liveCount * 3;
+    for (int direction = 0; direction < SvoFace_Count; direction++) {
+        faceIndexCounts[direction] = bucketCounts[direction + 1] * 3;
+    }
+    
+    TempArenaMemoryEnd(tempArena);
+    return liveCount;
+}
+
+// Meshes the voxels of one region from the occupancy FillSvoOccupancy() left in scratch. Positions are shifted left
+// by positionShift, which turns voxels of the meshed level into SVO_MESH_NET_PRECISION fixed point. The quads share 
+// the vertices of their cells and are then simplified, see SimplifySvoNetRegion().
+void MeshSvoRegionSurfaceNets(SvoMeshScratch* scratch, Vector3Int origin, int regionSize, int positionShift, 
+                              SvoMeshBuffer* mesh, SvoMeshStats* stats, u32* faceIndexCounts) {
+    u64 inside = ((regionSize == 64) ? ~0ull : ((1ull << regionSize) - 1)) << 1;
+    
+    u32 faceCount = 0;
+    for (int z = 0; z < regionSize; z++) {
+        for (int y = 0; y < regionSize; y++) {
+            u64 faceRows[SvoFace_Count];
+            SvoOccupancyFaceRows(scratch, inside, y, z, faceRows);
+            for (int direction = 0; direction < SvoFace_Count; direction++) {
+                faceCount += Popcount64(faceRows[direction]);
+            }
+        }
+    }
+    stats->faceCount += faceCount;
+    GrowSvoMeshBuffer(mesh, faceCount * 4, faceCount * 6, 0, 0);
+    
+    static const u32 positiveIndices[6] = { 0, 1, 2, 2, 3, 0 };
+    static const u32 negativeIndices[6] = { 2, 1, 0, 0, 3, 2 };
+    static const int cellOffsets[4][2] = { {-1, -1}, {0, -1}, {0, 0}, {-1, 0} };
+    int originAxis[3] = { origin.x, origin.y, origin.z };
+    int cellsPerAxis = regionSize + 1;
+    u32 usedCount = 0;
+    u32 firstVertex = mesh->vertexCount;
+    u32 firstIndex = mesh->indexCount;
+    
+    for (int z = 0; z < regionSize; z++) {
+        for (int y = 0; y < regionSize; y++) {
+            u64 faceRows[SvoFace_Count];
+            SvoOccupancyFaceRows(scratch, inside, y, z, faceRows);
+            for (int direction = 0; direction < SvoFace_Count; direction++) {
+                int axis = direction >> 1;
+                int uAxis = (axis + 1) % 3;
+                int vAxis = (axis + 2) % 3;
+                bool positive = (direction & 1) == 0;
+                
+                u64 faces = faceRows[direction];
+                while (faces) {
+                    int x = CountTrailingZeros64(faces) - 1;
+                    faces &= faces - 1;
+                    
+                    // The cells around the face's edge, in the corner order of AppendSvoQuad().
+                    int voxel[3] = { x, y, z };
+                    int cells[4][3];
+                    for (int i = 0; i < 4; i++) {
+                        cells[i][axis] = positive ? voxel[axis] : voxel[axis] - 1;
+                        cells[i][uAxis] = voxel[uAxis] + cellOffsets[i][0];
+                        cells[i][vAxis] = voxel[vAxis] + cellOffsets[i][1];
+                    }
+                    
+                    u32 quadVertices[4];
+                    for (int i = 0; i < 4; i++) {
+                        u32 cell = ((cells[i][2] + 1) * cellsPerAxis + cells[i][1] + 1) * cellsPerAxis + cells[i][0] + 1;
+                        if (scratch->cellVertices[cell] == 0xFFFFFFFF) {
+                            scratch->cellVertices[cell] = mesh->vertexCount;
+                            scratch->usedCells[usedCount++] = cell;
+                            mesh->vertices[mesh->vertexCount++] = SvoNetVertex(scratch, cells[i], originAxis, positionShift);
+                        }
+                        quadVertices[i] = scratch->cellVertices[cell];
+                    }
+                    
+                    const u32* quadIndices = positive ? positiveIndices : negativeIndices;
+                    u32* indices = mesh->indices + mesh->indexCount;
+                    for (int i = 0; i < 6; i++) {
+                        indices[i] = quadVertices[quadIndices[i]];
+                    }
+                    mesh->indexCount += 6;
+                }
+            }
+        }
+    }
+    for (u32 i = 0; i < usedCount; i++) {
+        scratch->cellVertices[scratch->usedCells[i]] = 0xFFFFFFFF;
+    }
+    
+    // Simplified meshes count as quads of 2 triangles.
+    u32 triangleCount = SimplifySvoNetRegion(mesh, firstVertex, firstIndex, positionShift, faceIndexCounts);
+    stats->quadCount += (triangleCount + 1) / 2;
+}
+
+// MeshSvoRegion() from the occupancy FillSvoOccupancy() left in scratch instead of a leaf walk, for baked ambient 
+// occlusion with withOcclusion and for meshing only the faces towards exterior space. The faces, the voxels that 
+// occlude them and the cavities all come from that one lookup of the region and its shell.
+void MeshSvoRegionOccupancy(SvoMeshScratch* scratch, Vector3Int origin, int regionSize, int scaleShift, bool withOcclusion,
+                            SvoMeshBuffer* mesh, SvoMeshStats* stats, u32* faceIndexCounts) {
+    u64 inside = ((regionSize == 64) ? ~0ull : ((1ull << regionSize) - 1)) << 1;
+    
+    u32 faceCount = 0;
+    for (int z = 0; z < regionSize; z++) {
+        for (int y = 0; y < regionSize; y++) {
+            u64 faceRows[SvoFace_Count];
+            SvoOccupancyFaceRows(scratch, inside, y, z, faceRows);
+            
+            // Rows of z faces run along x like the occupancy, the others are scattered bit by bit.
+            scratch->rows[SvoFace_PositiveZ][z][y] = faceRows[SvoFace_PositiveZ] >> 1;
+            scratch->rows[SvoFace_NegativeZ][z][y] = faceRows[SvoFace_NegativeZ] >> 1;
+            for (int direction = 0; direction < SvoFace_PositiveZ; direction++) {
+                int axis = direction >> 1;
+                u64 faces = faceRows[direction];
+                while (faces) {
+                    int voxel[3] = { CountTrailingZeros64(faces) - 1, y, z };
+                    faces &= faces - 1;
+                    scratch->rows[direction][voxel[axis]][voxel[(axis + 2) % 3]] |= 1ull << voxel[(axis + 1) % 3];
+                }
+            }
+            for (int direction = 0; direction < SvoFace_Count; direction++) {
+                faceCount += Popcount64(faceRows[direction]);
+            }
+        }
+    }
+    stats->faceCount += faceCount;
+    GrowSvoMeshBuffer(mesh, faceCount * 4, faceCount * 6, 0, 0);
+    
+    static const u16 directions[SvoFace_Count] = { 0, 1, 2, 3, 4, 5 };
+    MergeSvoRegionFaces(scratch, origin, regionSize, scaleShift, directions, withOcclusion, mesh, stats, faceIndexCounts);
+}
+
+// Merges the vertices from firstVertex on that have the same position, face direction and occlusion, i.e. the corners that 
+// neighboring quads share, and rewrites the indices from firstIndex on to match. A Vertex_Voxel is its own u64 key,
+// so the hash table only stores indices into the compacted vertices. Vertices keep their first-seen order.
+void ShareSvoVertices(SvoMeshBuffer* mesh, u32 firstVertex, u32 firstIndex) {
+    u32 count = mesh->vertexCount - firstVertex;
+    if (count == 0) {
+        return;
+    }
+    
+    TempArenaMemory tempArena = TempArenaMemoryBegin(&tempAllocator);
+    
+    int tableShift = 1;
+    while ((1u << tableShift) < count * 2) {
+        tableShift++;
+    }
+    u32 tableMask = (1u << tableShift) - 1;
+    u32* table = ALLOC_ARRAY(TempAllocator, u32, tableMask + 1);
+    memset(table, 0xFF, (tableMask + 1) * sizeof(u32));
+    u32* remap = ALLOC_ARRAY(TempAllocator, u32, count);
+    
+    Vertex_Voxel* vertices = mesh->vertices + firstVertex;
+    u32 shared = 0;
+    for (u32 i = 0; i < count; i++) {
+        Vertex_Voxel vertex = vertices[i];
+        u64 key;
+        memcpy(&key, &vertex, sizeof(u64));
+        
+        // Fibonacci hashing, the top bits of the product are the best mixed.
+        u32 slot = (u32)((key * 0x9E3779B97F4A7C15ull) >> (64 - tableShift));
+        for (;;) {
+            u32 entry = table[slot];
+            if (entry == 0xFFFFFFFF) {
+                table[slot] = shared;
+                vertices[shared] = vertex; // shared <= i, so this never overwrites a vertex that is still to be read
+                remap[i] = shared++;
+                break;
+            }
+            if (memcmp(&vertices[entry], &vertex, sizeof(Vertex_Voxel)) == 0) {
+                remap[i] = entry;
+                break;
+            }
+            slot = (slot + 1) & tableMask;
+        }
+    }
+    
+    for (u32 i = firstIndex; i < mesh->indexCount; i++) {
+        mesh->indices[i] = firstVertex + remap[mesh->indices[i] - firstVertex];
+    }
+    mesh->vertexCount = firstVertex + shared;
+    
+    TempArenaMemoryEnd(tempArena);
+}
+
+// Post-transform vertex cache size that OptimizeSvoVertexCache() orders triangles for.
+#define SVO_MESH_VERTEX_CACHE_SIZE 16
+
+// Tipsify from "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw" (Sander, Nehab, Barczak 2007) on 
+// the triangleCount triangles of indices, vertex ids relative to the chunk's first vertex, written to output.
+// It fans out from one vertex at a time, and picks the next one among the vertices just emitted that will still be in 
+// the cache after emitting all their triangles. Linear in the triangles, only the vertices they use are touched. 
+// The arrays are scratch with an entry per vertex of the chunk, adjacency, deadEnds and emitted with one per index.
+void TipsifySvoTriangles(u32* indices, u32 triangleCount, u32* output, u32* liveCounts, u32* adjacencyStarts, 
+                         u32* adjacencyEnds, u32* adjacency, u32* cacheTimes, u32* deadEnds, bool* emitted) {
+    u32 indexCount = triangleCount * 3;
+    for (u32 i = 0; i < indexCount; i++) {
+        liveCounts[indices[i]] = 0;
+        adjacencyEnds[indices[i]] = 0xFFFFFFFF;
+        cacheTimes[indices[i]] = 0;
+    }
+    for (u32 i = 0; i < indexCount; i++) {
+        liveCounts[indices[i]]++;
+    }
+    
+    // Adjacency lists in the order the vertices are first used.
+    u32 start = 0;
+    for (u32 i = 0; i < indexCount; i++) {
+        u32 v = indices[i];
+        if (adjacencyEnds[v] == 0xFFFFFFFF) {
+            adjacencyStarts[v] = start;
+            adjacencyEnds[v] = start;
+            start += liveCounts[v];
+        }
+    }
+    for (u32 i = 0; i < indexCount; i++) {
+        adjacency[adjacencyEnds[indices[i]]++] = i / 3;
+    }
+    memset(emitted, 0, triangleCount * sizeof(bool));
+    
+    const u32 cacheSize = SVO_MESH_VERTEX_CACHE_SIZE;
+    u32 time = cacheSize + 1;
+    u32 deadEndCount = 0;
+    u32 cursor = 0;
+    u32 outputCount = 0;
+    s64 fan = indices[0];
+    while (fan >= 0) {
+        u32 candidatesStart = deadEndCount;
+        for (u32 a = adjacencyStarts[fan]; a < adjacencyEnds[fan]; a++) {
+            u32 triangle = adjacency[a];
+            if (emitted[triangle]) {
+                continue;
+            }
+            for (int j = 0; j < 3; j++) {
+                u32 v = indices[triangle * 3 + j];
+                output[outputCount++] = v;
+                deadEnds[deadEndCount++] = v;
+                liveCounts[v]--;
+                if (time - cacheTimes[v] > cacheSize) {
+                    cacheTimes[v] = time++;
+                }
+            }
+            emitted[triangle] = true;
+        }
+        
+        // The candidates are the vertices just emitted. Prefer the oldest one that stays in the cache while its
+        // remaining triangles are emitted, any with triangles left otherwise.
+        fan = -1;
+        s64 bestPriority = -1;
+        for (u32 c = candidatesStart; c < deadEndCount; c++) {
+            u32 v = deadEnds[c];
+            if (liveCounts[v] == 0) {
+                continue;
+            }
+            s64 priority = 0;
+            if (time - cacheTimes[v] + 2 * liveCounts[v] <= cacheSize) {
+                priority = time - cacheTimes[v];
+            }
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                fan = v;
+            }
+        }
+        
+        // Dead end, go back to the most recent vertex with triangles left, or on to the next one in the input.
+        while (fan < 0 && deadEndCount > 0) {
+            u32 v = deadEnds[--deadEndCount];
+            if (liveCounts[v] > 0) {
+                fan = v;
+            }
+        }
+        while (fan < 0 && cursor < indexCount) {
+            if (liveCounts[indices[cursor]] > 0) {
+                fan = indices[cursor];
+            }
+            cursor++;
+        }
+    }
+    ASSERT_DEBUG(outputCount == indexCount, "Tipsify emitted %u of %u indices.", outputCount, indexCount);
+}
+
+// Reorders the triangles of the chunk mesh from firstVertex and firstIndex on for the post-transform vertex cache, 
+// see TipsifySvoTriangles(), and then its vertices in the order the triangles first use them, so the vertex fetches
+// go forward through memory too. Triangles stay in their direction bucket, see SvoChunkMesh. Only worth it with 
+// shared vertices, quads with 4 vertices of their own miss the cache 2 times per triangle whatever the order.
+void OptimizeSvoVertexCache(SvoMeshBuffer* mesh, u32 firstVertex, u32 firstIndex, u32* faceIndexCounts) {
+    u32 vertexCount = mesh->vertexCount - firstVertex;
+    u32 indexCount = mesh->indexCount - firstIndex;
+    if (indexCount == 0) {
+        return;
+    }
+    
+    TempArenaMemory tempArena = TempArenaMemoryBegin(&tempAllocator);
+    
+    u32* local = ALLOC_ARRAY(TempAllocator, u32, indexCount);
+    u32* output = ALLOC_ARRAY(TempAllocator, u32, indexCount);
+    u32* liveCounts = ALLOC_ARRAY(TempAllocator, u32, vertexCount);
+    u32* adjacencyStarts = ALLOC_ARRAY(TempAllocator, u32, vertexCount);
+    u32* adjacencyEnds = ALLOC_ARRAY(TempAllocator, u32, vertexCount);
+    u32* adjacency = ALLOC_ARRAY(TempAllocator, u32, indexCount);
+    u32* cacheTimes = ALLOC_ARRAY(TempAllocator, u32, vertexCount);
+    u32* deadEnds = ALLOC_ARRAY(TempAllocator, u32, indexCount);
+    bool* emitted = ALLOC_ARRAY(TempAllocator, bool, indexCount / 3);
+    
+    u32* indices = mesh->indices + firstIndex;
+    for (u32 i = 0; i < indexCount; i++) {
+        local[i] = indices[i] - firstVertex;
+    }
+    
+    // The indices before the buckets are a bucket of their own.
+    u32 bucketStart = indexCount;
+    for (int direction = 0; direction < SvoFace_Count; direction++) {
+        bucketStart -= faceIndexCounts[direction];
+    }
+    u32 bucketEnd = bucketStart;
+    bucketStart = 0;
+    for (int bucket = -1; bucket < SvoFace_Count; bucket++) {
+        if (bucket >= 0) {
+            bucketStart = bucketEnd;
+            bucketEnd += faceIndexCounts[bucket];
+        }
+        if (bucketEnd > bucketStart) {
+            TipsifySvoTriangles(local + bucketStart, (bucketEnd - bucketStart) / 3, output + bucketStart, liveCounts, 
+                                adjacencyStarts, adjacencyEnds, adjacency, cacheTimes, deadEnds, emitted);
+        }
+    }
+    
+    u32* remap = liveCounts;
+    memset(remap, 0xFF, vertexCount * sizeof(u32));
+    Vertex_Voxel* vertices = ALLOC_ARRAY(TempAllocator, Vertex_Voxel, vertexCount);
+    u32 used = 0;
+    for (u32 i = 0; i < indexCount; i++) {
+        u32 v = output[i];
+        if (remap[v] == 0xFFFFFFFF) {
+            remap[v] = used;
+            vertices[used++] = mesh->vertices[firstVertex + v];
+        }
+        indices[i] = firstVertex + remap[v];
+    }
+    ASSERT_DEBUG(used == vertexCount, "%u of %u vertices are used by the chunk mesh.", used, vertexCount);
+    memcpy(mesh->vertices + firstVertex, vertices, used * sizeof(Vertex_Voxel));
+    
+    TempArenaMemoryEnd(tempArena);
+}
+
+// The range of one chunk mesh in the vertex and index buffers, indices are relative to its first vertex.
+// The indices end with a bucket per SvoFaceDirection, in order, holding the faces that all point that way. 
+// Whatever comes before the buckets (the curved surface nets) can face any way.
+struct SvoChunkMesh {
+    IndexBufferFormat indexFormat;  // U16 when the mesh has few enough vertices, firstIndex is into that buffer
+    u32 firstVertex;
+    u32 vertexCount;
+    u32 firstIndex;
+    u32 indexCount;
+    u32 faceIndexCounts[SvoFace_Count];
+    u32 firstCluster;
+    u32 clusterCount;
+    u64 hash;  // of the occupancy it was meshed from when the grid shares repeats, see HashSvoOccupancy(), 0 otherwise
+};
+
+// Fixed-size spatial chunks: the subtrees of the nodes at chunkLevel, indexed by their coordinates at that level.
+// Every chunk has a mesh per LOD and is remeshed on its own when an edit marks it dirty.
+//
+// LOD n meshes the same subtree at level lvl - n, where a voxel is filled if anything below it is, so coarser
+// meshes only ever cover more space. LOD 0 culls faces against the neighboring chunks, coarser LODs are meshed 
+// as if the chunk were alone and keep their faces on the chunk border. Those walls are the skirts: wherever a 
+// coarse chunk sticks out past a finer neighbor they close the gap, elsewhere they are hidden inside the neighbor.
+// Coarser surface nets see nothing outside the chunk either, so their surface closes off along the border the same way.
+//
+// With shareRepeats every chunk LOD is meshed at the origin instead of its place in the grid, and chunks whose 
+// occupancy and one voxel thick shell are the same share a single mesh: their SvoChunkMeshes are copies of the same 
+// ranges. Such meshes are drawn with the chunk's SvoChunkMeshOrigin() added to their positions.
+struct SvoChunk {
+    bool dirty;
+    int lod;  // drawn LOD, see SelectSvoChunkLods()
+    SvoChunkMesh lods[SVO_MESH_MAX_LODS];
+};
+
+enum SvoMesher {
+    SvoMesher_Cubes,        // the voxel faces, greedy merged
+    SvoMesher_SurfaceNets,  // a smooth surface through the voxels, see MeshSvoRegionSurfaceNets()
+};
+
+struct SvoChunkGrid {
+    int lvl;            // voxel level that is meshed
+    int chunkLevel;
+    int chunkSize;      // voxels per side
+    int chunksPerAxis;
+    int lodCount;
+    float rootScale;
+    bool shareVertices; // one vertex per corner and face direction within a chunk, see ShareSvoVertices()
+    bool optimizeVertexCache; // see OptimizeSvoVertexCache()
+    bool solidSubtrees; // skips the inside of subtrees whose voxels are all filled, see SvoSolidWalk
+    SvoMesher mesher;
+    bool ambientOcclusion; // baked into the cube vertices, see SvoFaceOcclusion(), surface nets have none
+    SvoExterior* exterior; // when set only faces towards exterior space are meshed, see UpdateSvoExterior()
+    bool shareRepeats;  // one mesh for all chunks with the same occupancy, see SvoChunk
+    u32 chunkCount;
+    SvoChunk* chunks;   // x fastest, then y, then z
+};
+
+void InitSvoChunkGrid(SvoChunkGrid* grid, int lvl, int chunkShift, int lodCount, float rootScale, Allocator allocator) {
+    ASSERT_ERROR(chunkShift > 0 && chunkShift <= SVO_MESH_REGION_SHIFT, "Chunks must have 2 to %d voxels per side.", SVO_MESH_REGION_SIZE);
+    ASSERT_ERROR(lvl <= 15, "Vertex_Voxel positions are u16, cannot mesh level %d.", lvl);
+    
+    grid->lvl = lvl;
+    grid->chunkLevel = Max(0, lvl - chunkShift);
+    grid->chunkSize = 1 << (lvl - grid->chunkLevel);
+    grid->chunksPerAxis = 1 << grid->chunkLevel;
+    
+    // The coarsest LOD still needs 2 voxels per side, so it stays below chunkLevel.
+    ASSERT_ERROR(lodCount > 0 && lodCount <= SVO_MESH_MAX_LODS, "Invalid LOD count %d.", lodCount);
+    grid->lodCount = Min(lodCount, lvl - grid->chunkLevel);
+    grid->rootScale = rootScale;
+    grid->shareVertices = false;
+    grid->optimizeVertexCache = false;
+    grid->solidSubtrees = false;
+    grid->mesher = SvoMesher_Cubes;
+    grid->ambientOcclusion = false;
+    grid->exterior = 0;
+    grid->shareRepeats = false;
+    grid->chunkCount = (u32)grid->chunksPerAxis * grid->chunksPerAxis * grid->chunksPerAxis;
+    grid->chunks = ALLOC_ARRAY(allocator, SvoChunk, grid->chunkCount);
+    memset(grid->chunks, 0, grid->chunkCount * sizeof(SvoChunk));
+}
+
+// The mesh settings the game starts with, which the export and the benchmarks use as well.
+void InitSvoGameSettings(SvoChunkGrid* grid) {
+    grid->shareVertices = true;
+    grid->ambientOcclusion = true;
+    grid->optimizeVertexCache = true;
+    grid->solidSubtrees = true;
+}
+
+// World size of one unit of the Vertex_Voxel positions: a voxel of lvl for cubes, SVO_MESH_NET_PRECISION fixed 
+// point for surface nets.
+float SvoMeshUnit(SvoChunkGrid* grid) {
+    int bits = (grid->mesher == SvoMesher_SurfaceNets) ? SVO_MESH_NET_PRECISION : grid->lvl;
+    return grid->rootScale / (1 << bits);
+}
+
+Vector3Int SvoChunkCoord(SvoChunkGrid* grid, u32 chunk) {
+    u32 n = grid->chunksPerAxis;
+    return Vector3Int{ (int)(chunk % n), (int)((chunk / n) % n), (int)(chunk / (n * n)) };
+}
+
+// What the positions of the chunk's meshes are relative to, in units of SvoMeshUnit(): the chunk's corner when the
+// grid shares repeats, the origin otherwise.
+Vector3Int SvoChunkMeshOrigin(SvoChunkGrid* grid, u32 chunk) {
+    if (!grid->shareRepeats) {
+        return Vector3Int{ 0, 0, 0 };
+    }
+    int bits = (grid->mesher == SvoMesher_SurfaceNets) ? SVO_MESH_NET_PRECISION : grid->lvl;
+    int size = grid->chunkSize << (bits - grid->lvl);
+    Vector3Int cc = SvoChunkCoord(grid, chunk);
+    return Vector3Int{ cc.x * size, cc.y * size, cc.z * size };
+}
+
+void MarkSvoChunkDirty(SvoChunkGrid* grid, Vector3Int chunk) {
+    int n = grid->chunksPerAxis;
+    if (chunk.x >= 0 && chunk.y >= 0 && chunk.z >= 0 && chunk.x < n && chunk.y < n && chunk.z < n) {
+        grid->chunks[chunk.x + (chunk.y + chunk.z * n) * n].dirty = true;
+    }
+}
+
+// Marks the chunk of voxel c and, when c is on the chunk's border, the chunks whose faces touch it. Surface nets and
+// ambient occlusion also read the voxels diagonally across the border, so there every chunk whose one voxel thick 
+// shell contains c is marked.
+void MarkSvoVoxelDirty(SvoChunkGrid* grid, Vector3Int c) {
+    int shift = grid->lvl - grid->chunkLevel;
+    int last = grid->chunkSize - 1;
+    int coord[3] = { c.x, c.y, c.z };
+    int low[3];
+    int high[3];
+    for (int a = 0; a < 3; a++) {
+        low[a] = ((coord[a] & last) == 0) ? -1 : 0;
+        high[a] = ((coord[a] & last) == last) ? 1 : 0;
+    }
+    
+    for (int dz = low[2]; dz <= high[2]; dz++) {
+        for (int dy = low[1]; dy <= high[1]; dy++) {
+            for (int dx = low[0]; dx <= high[0]; dx++) {
+                if (grid->mesher == SvoMesher_Cubes && !grid->ambientOcclusion && (dx != 0) + (dy != 0) + (dz != 0) > 1) {
+                    continue;
+                }
+                MarkSvoChunkDirty(grid, Vector3Int{ (c.x >> shift) + dx, (c.y >> shift) + dy, (c.z >> shift) + dz });
+            }
+        }
+    }
+}
+
+// Adds the cavity voxels in the subtree of node to the counts of the chunks they are in.
+void CountSvoCavityVoxels(SvoImport* svo, SvoExterior* exterior, SvoChunkGrid* grid, int level, u32 node, Vector3Int coord, 
+                          u32* counts) {
+    u8 mask = svo->masksAtLevel[level][node];
+    u8 cavities = (u8)~(mask | exterior->masks[level][node]);
+    int blockShift = grid->lvl - level - 1;
+    int chunkShift = grid->lvl - grid->chunkLevel;
+    int n = grid->chunksPerAxis;
+    for (int child = 0; child < 8; child++) {
+        Vector3Int childCoord = { coord.x * 2 + (child & 1), coord.y * 2 + ((child >> 1) & 1), coord.z * 2 + (child >> 2) };
+        if (cavities & (1u << child)) {
+            if (blockShift >= chunkShift) {
+                // The block covers whole chunks.
+                int side = 1 << (blockShift - chunkShift);
+                Vector3Int first = { childCoord.x * side, childCoord.y * side, childCoord.z * side };
+                for (int z = first.z; z < first.z + side; z++) {
+                    for (int y = first.y; y < first.y + side; y++) {
+                        for (int x = first.x; x < first.x + side; x++) {
+                            counts[x + (y + z * n) * n] += (u32)grid->chunkSize * grid->chunkSize * grid->chunkSize;
+                        }
+                    }
+                }
+            } else {
+                int x = (childCoord.x << blockShift) >> chunkShift;
+                int y = (childCoord.y << blockShift) >> chunkShift;
+                int z = (childCoord.z << blockShift) >> chunkShift;
+                counts[x + (y + z * n) * n] += 1u << (3 * blockShift);
+            }
+        } else if ((mask & (1u << child)) && level + 1 < grid->lvl) {
+            u32 childNode = svo->firstChild[level][node] + Popcount8(mask & ((1u << child) - 1u));
+            if (svo->solidLevels[level + 1][childNode] < grid->lvl - level - 1) {
+                CountSvoCavityVoxels(svo, exterior, grid, level + 1, childNode, childCoord, counts);
+            }
+        }
+    }
+}
+
+// Floods the exterior of the SVO at the grid's level into exterior and has the grid mesh only the faces towards it.
+// Afterwards the chunks whose cavities changed are marked dirty, with the chunks around them whose shell reaches 
+// into them. One edit only ever opens cavities or closes them, so the cavity voxels of every chunk it changes go 
+// the same way and their count tells, except in the edited chunk, which is dirty anyway.
+void UpdateSvoExterior(SvoImport* svo, SvoChunkGrid* grid, SvoExterior* exterior) {
+    TempArenaMemory tempArena = TempArenaMemoryBegin(&tempAllocator);
+    
+    FloodSvoExterior(svo, grid->lvl, exterior);
+    u32* counts = ALLOC_ARRAY(TempAllocator, u32, grid->chunkCount);
+    memset(counts, 0, grid->chunkCount * sizeof(u32));
+    if (svo->nodesAtLevel[0] > 0 && grid->lvl > 0) {
+        CountSvoCavityVoxels(svo, exterior, grid, 0, 0, Vector3Int{ 0, 0, 0 }, counts);
+    }
+    
+    if (exterior->cavityCounts && exterior->chunkCount == grid->chunkCount) {
+        for (u32 i = 0; i < grid->chunkCount; i++) {
+            if (counts[i] == exterior->cavityCounts[i]) {
+                continue;
+            }
+            Vector3Int chunk = SvoChunkCoord(grid, i);
+            for (int dz = -1; dz <= 1; dz++) {
+                for (int dy = -1; dy <= 1; dy++) {
+                    for (int dx = -1; dx <= 1; dx++) {
+                        MarkSvoChunkDirty(grid, Vector3Int{ chunk.x + dx, chunk.y + dy, chunk.z + dz });
+                    }
+                }
+            }
+        }
+    } else {
+        HeapAllocator.free(exterior->cavityCounts);
+        exterior->cavityCounts = (u32*)HeapAllocator.alloc(grid->chunkCount * sizeof(u32));
+        exterior->chunkCount = grid->chunkCount;
+    }
+    memcpy(exterior->cavityCounts, counts, grid->chunkCount * sizeof(u32));
+    grid->exterior = exterior;
+    
+    TempArenaMemoryEnd(tempArena);
+}
+
+void FreeSvoExterior(SvoExterior* exterior) {
+    if (exterior->masks) {
+        for (int level = 0; level < exterior->lvl; level++) {
+            HeapAllocator.free(exterior->masks[level]);
+        }
+        HeapAllocator.free(exterior->masks);
+    }
+    HeapAllocator.free(exterior->cavityCounts);
+    ZeroStruct(exterior);
+}
+
+// Appends the cluster of the triangles from start to end. firstIndex is the first index of their chunk mesh.
+void AppendSvoMeshCluster(SvoMeshBuffer* mesh, u32 firstIndex, u32 start, u32 end, int direction, float unit) {
+    ASSERT_DEBUG(end - start <= SVO_MESH_CLUSTER_TRIANGLES * 3, "Cluster has too many triangles.");
+    Vector3 normals[SVO_MESH_CLUSTER_TRIANGLES];
+    
+    u16 min[3] = { 0xFFFF, 0xFFFF, 0xFFFF };
+    u16 max[3] = { 0, 0, 0 };
+    Vector3 normalSum = {};
+    u32 normalCount = 0;
+    for (u32 i = start; i < end; i += 3) {
+        Vertex_Voxel* v[3];
+        for (int k = 0; k < 3; k++) {
+            v[k] = &mesh->vertices[mesh->indices[i + k]];
+            min[0] = (v[k]->x < min[0]) ? v[k]->x : min[0];
+            min[1] = (v[k]->y < min[1]) ? v[k]->y : min[1];
+            min[2] = (v[k]->z < min[2]) ? v[k]->z : min[2];
+            max[0] = (v[k]->x > max[0]) ? v[k]->x : max[0];
+            max[1] = (v[k]->y > max[1]) ? v[k]->y : max[1];
+            max[2] = (v[k]->z > max[2]) ? v[k]->z : max[2];
+        }
+        
+        // Outward for both meshers. Surface nets can round a triangle down to nothing, it has no direction then.
+        Vector3 e0 = { (float)v[1]->x - v[0]->x, (float)v[1]->y - v[0]->y, (float)v[1]->z - v[0]->z };
+        Vector3 e1 = { (float)v[2]->x - v[0]->x, (float)v[2]->y - v[0]->y, (float)v[2]->z - v[0]->z };
+        Vector3 normal = CrossProduct(e0, e1);
+        if (SqrMagnitude(normal) > 0) {
+            normals[normalCount++] = normal;
+            normalSum += normal;
+        }
+    }
+    
+    // The axis is the area weighted average normal, the cutoff comes from the normal furthest from it. Cones of 
+    // 90 degrees or more always have a triangle facing the camera. cos * |cos| is compared instead of the cosine 
+    // itself, it orders the same and needs no square root per triangle.
+    Vector3 axis = {};
+    float minDot = -1.0f;
+    if (SqrMagnitude(normalSum) > 0) {
+        axis = Normalize(normalSum);
+        float minSignedSquare = 1.0f;
+        for (u32 i = 0; i < normalCount; i++) {
+            float dot = DotProduct(axis, normals[i]);
+            minSignedSquare = Min(minSignedSquare, dot * Abs(dot) / SqrMagnitude(normals[i]));
+        }
+        minDot = (minSignedSquare > 0) ? sqrtf(minSignedSquare) : -1.0f;
+    }
+    
+    SvoMeshCluster* cluster = &mesh->clusters[mesh->clusterCount++];
+    cluster->firstIndex = start - firstIndex;
+    cluster->indexCount = end - start;
+    cluster->direction = direction;
+    cluster->min = Vector3{ (float)min[0], (float)min[1], (float)min[2] } * unit;
+    cluster->max = Vector3{ (float)max[0], (float)max[1], (float)max[2] } * unit;
+    cluster->coneAxis = axis;
+    cluster->coneCutoff = (minDot > 0) ? sqrtf(Max(0.0f, 1.0f - minDot * minDot)) : 2.0f;
+}
+
+// Splits the triangles from firstIndex to the end of mesh into clusters, appended to mesh->clusters. The direction
+// buckets at the end, faceIndexCounts indices each, are split on their own. unit is the world size of a position 
+// unit, see SvoMeshUnit().
+void BuildSvoMeshClusters(SvoMeshBuffer* mesh, u32 firstIndex, u32* faceIndexCounts, float unit) {
+    // Bucket 0 is what comes before the directions, bucket d + 1 holds direction d.
+    u32 clusterIndices = SVO_MESH_CLUSTER_TRIANGLES * 3;
+    u32 bucketEnds[SvoFace_Count + 1];
+    bucketEnds[SvoFace_Count] = mesh->indexCount;
+    for (int bucket = SvoFace_Count - 1; bucket >= 0; bucket--) {
+        bucketEnds[bucket] = bucketEnds[bucket + 1] - faceIndexCounts[bucket];
+    }
+    
+    u32 clusterCount = 0;
+    u32 bucketStart = firstIndex;
+    for (int bucket = 0; bucket <= SvoFace_Count; bucket++) {
+        clusterCount += (bucketEnds[bucket] - bucketStart + clusterIndices - 1) / clusterIndices;
+        bucketStart = bucketEnds[bucket];
+    }
+    GrowSvoMeshBuffer(mesh, 0, 0, 0, clusterCount);
+    
+    u32 start = firstIndex;
+    for (int bucket = 0; bucket <= SvoFace_Count; bucket++) {
+        while (start < bucketEnds[bucket]) {
+            u32 end = Min(start + clusterIndices, bucketEnds[bucket]);
+            AppendSvoMeshCluster(mesh, firstIndex, start, end, (bucket == 0) ? SvoFace_Count : bucket - 1, unit);
+            start = end;
+        }
+    }
+}
+
+// A mesh thread starts a new buffer once its current one holds this many vertices. The copy frees every one of them
+// as soon as it is copied, so the mesh is only held twice for the segments being copied, see CopySvoMeshSegments().
+#define SVO_MESH_SEGMENT_VERTICES (1 << 20)
+
+// The buffers one mesh thread wrote to, heap allocated. The last one is the one being written.
+struct SvoMeshSegments {
+    SvoMeshBuffer* buffers;
+    int count;
+    int capacity;
+};
+
+// Where the mesh of one chunk LOD ended up. Filled in by the thread that meshed it, the prefix sum over all chunks
+// then gives it its place in the output.
+struct SvoMeshRegionOutput {
+    int thread;
+    int segment;      // of the thread's segments
+    u32 firstVertex;  // in the segment
+    u32 firstIndex;   // in the segment
+    u32 firstCluster; // in the segment
+    u32 vertexCount;
+    u32 indexCount;
+    u32 clusterCount;
+    u32 faceIndexCounts[SvoFace_Count];
+    SvoChunkMesh* chunkMesh;  // the range in the output
+};
+
+// Meshes of the chunk LODs by the hash of their occupancy when the grid shares repeats. Open addressing with the hash
+// as the key, 0 marks a free slot. The threads claim keys while meshing, see ClaimSvoChunkMesh(), everything else 
+// is read and written by the calling thread before or after them.
+struct SvoRepeatTable {
+    volatile u64* keys;
+    u32* claimers;  // the output that meshed the hash, written by the thread that claimed it
+    u32* meshes;    // the output whose range every output with the hash takes, or outputCount + chunk * lodCount + lod
+                    // for a mesh a chunk outside the list has in the output buffer already
+    int shift;
+};
+
+#define SVO_REPEAT_NO_MESH 0xFFFFFFFF
+
+struct SvoMeshJob {
+    SvoImport* svo;
+    SvoChunkGrid* grid;
+    
+    u32* chunks;
+    u32 chunkCount;
+    SvoMeshRegionOutput* outputs;  // lodCount per chunk
+    u64* hashes;    // per output when the grid shares repeats, see HashSvoOccupancy()
+    SvoRepeatTable repeats;
+    volatile s32 nextChunk;
+    
+    SvoMeshBuffer* output;
+    SvoMeshSegments* threadSegments;
+    SvoMeshStats* threadStats;
+    
+    // The copy hands out whole segments, with the outputs to copy from each of them, see CopySvoMeshSegments().
+    SvoMeshBuffer** segments;
+    u32 segmentCount;
+    u32* segmentFirstOutput;  // segmentCount + 1 offsets into segmentOutputs
+    u32* segmentOutputs;
+    volatile s32 nextSegment;
+};
+
+struct SvoMeshThread {
+    SvoMeshJob* job;
+    int thread;
+};
+
+// Hash of the occupancy FillSvoOccupancy() left in scratch for a region of size voxels, shell and cavities included.
+// Everything the mesh of a chunk LOD depends on is in there, so chunks with the same hash get the same mesh when 
+// meshed at the origin. Never 0, which stands for no mesh to share.
+u64 HashSvoOccupancy(SvoMeshScratch* scratch, int size) {
+    u64 shell = (size + 2 == 64) ? ~0ull : ((1ull << (size + 2)) - 1);
+    u64 hash = (u64)size;
+    for (int z = 0; z < size + 2; z++) {
+        for (int y = 0; y < size + 2; y++) {
+            hash = (hash ^ (scratch->occupancy[z][y] & shell)) * 0x9E3779B97F4A7C15ull;
+            hash ^= hash >> 29;
+            hash = (hash ^ (scratch->cavities[z][y] & shell)) * 0x9E3779B97F4A7C15ull;
+            hash ^= hash >> 29;
+        }
+    }
+    return hash ? hash : 1;
+}
+
+// Fibonacci hashing like ShareSvoVertices().
+u32 SvoRepeatSlot(SvoRepeatTable* table, u64 hash) {
+    return (u32)((hash * 0x9E3779B97F4A7C15ull) >> (64 - table->shift));
+}
+
+// Slot of hash, or the free slot it goes to.
+u32 FindSvoRepeatSlot(SvoRepeatTable* table, u64 hash) {
+    u32 mask = (1u << table->shift) - 1;
+    u32 slot = SvoRepeatSlot(table, hash);
+    while (table->keys[slot] != 0 && table->keys[slot] != hash) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+// Sizes the table for every chunk LOD of the grid and adds the meshes the chunks outside the list have already. 
+// Those take precedence over meshing, they cost nothing.
+void InitSvoRepeatTable(SvoRepeatTable* table, SvoChunkGrid* grid, u32* chunks, u32 chunkCount) {
+    u32 meshCount = grid->chunkCount * grid->lodCount;
+    table->shift = 1;
+    while ((1u << table->shift) < meshCount * 2) {
+        table->shift++;
+    }
+    u32 slotCount = 1u << table->shift;
+    table->keys = ALLOC_ARRAY(TempAllocator, u64, slotCount);
+    table->claimers = ALLOC_ARRAY(TempAllocator, u32, slotCount);
+    table->meshes = ALLOC_ARRAY(TempAllocator, u32, slotCount);
+    memset((void*)table->keys, 0, slotCount * sizeof(u64));
+    memset(table->meshes, 0xFF, slotCount * sizeof(u32));
+    
+    bool* listed = ALLOC_ARRAY(TempAllocator, bool, grid->chunkCount);
+    memset(listed, 0, grid->chunkCount * sizeof(bool));
+    for (u32 i = 0; i < chunkCount; i++) {
+        listed[chunks[i]] = true;
+    }
+    u32 outputCount = chunkCount * grid->lodCount;
+    for (u32 i = 0; i < meshCount; i++) {
+        u64 hash = grid->chunks[i / grid->lodCount].lods[i % grid->lodCount].hash;
+        if (hash == 0 || listed[i / grid->lodCount]) {
+            continue;
+        }
+        u32 slot = FindSvoRepeatSlot(table, hash);
+        if (table->keys[slot] == 0) {
+            table->keys[slot] = hash;
+            table->meshes[slot] = outputCount + i;
+        }
+    }
+}
+
+// Called by the mesh threads for every chunk LOD with voxels once its occupancy is filled. Returns true for the first
+// output with the hash, which then meshes it, and false for every other one, which stays empty. Which output that
+// is depends on the thread timing, MeshSvoChunks() places the mesh the same way regardless.
+bool ClaimSvoChunkMesh(SvoRepeatTable* table, u64 hash, u32 output) {
+    u32 mask = (1u << table->shift) - 1;
+    u32 slot = SvoRepeatSlot(table, hash);
+    for (;;) {
+        u64 key = table->keys[slot];
+        if (key == 0) {
+            key = AtomicCompareExchange64(&table->keys[slot], hash, 0);
+            if (key == 0) {
+                table->claimers[slot] = output;
+                return true;
+            }
+        }
+        if (key == hash) {
+            return false;
+        }
+        slot = (slot + 1) & mask;
+    }
+}
+
+// Chunks are handed out one at a time, so threads that get cheap chunks simply take more of them.
+void MeshSvoRegions(SvoMeshThread* meshThread) {
+    SvoMeshJob* job = meshThread->job;
+    SvoChunkGrid* grid = job->grid;
+    SvoMeshSegments* segments = &job->threadSegments[meshThread->thread];
+    SvoMeshStats* stats = &job->threadStats[meshThread->thread];
+    float unit = SvoMeshUnit(grid);
+    
+    TempArenaMemory tempArena = TempArenaMemoryBegin(&tempAllocator);
+    
+    SvoMeshScratch* scratch = ALLOC_ARRAY(TempAllocator, SvoMeshScratch, 1);
+    ZeroStruct(scratch);
+    if (grid->mesher == SvoMesher_SurfaceNets) {
+        u32 cellCount = (u32)(grid->chunkSize + 1) * (grid->chunkSize + 1) * (grid->chunkSize + 1);
+        scratch->cellVertices = ALLOC_ARRAY(TempAllocator, u32, cellCount);
+        scratch->usedCells = ALLOC_ARRAY(TempAllocator, u32, cellCount);
+        memset(scratch->cellVertices, 0xFF, cellCount * sizeof(u32));
+    }
+    
+    for (;;) {
+        s32 item = AtomicAdd(&job->nextChunk, 1);
+        if (item >= (s32)job->chunkCount) {
+            break;
+        }
+        
+        if (segments->count == 0 || segments->buffers[segments->count - 1].vertexCount >= SVO_MESH_SEGMENT_VERTICES) {
+            if (segments->count == segments->capacity) {
+                segments->capacity = Max(4, segments->capacity * 2);
+                segments->buffers = (SvoMeshBuffer*)HeapAllocator.realloc(segments->buffers, segments->capacity * sizeof(SvoMeshBuffer));
+            }
+            ZeroStruct(&segments->buffers[segments->count++]);
+        }
+        SvoMeshBuffer* mesh = &segments->buffers[segments->count - 1];
+        
+        SvoMeshRegionOutput* outputs = &job->outputs[item * grid->lodCount];
+        for (int lod = 0; lod < grid->lodCount; lod++) {
+            ZeroStruct(&outputs[lod]);
+            outputs[lod].thread = meshThread->thread;
+            outputs[lod].segment = segments->count - 1;
+            outputs[lod].firstVertex = mesh->vertexCount;
+            outputs[lod].firstIndex = mesh->indexCount;
+            outputs[lod].firstCluster = mesh->clusterCount;
+        }
+        
+        Vector3Int cc = SvoChunkCoord(grid, job->chunks[item]);
+        u32 node;
+        SvoNodeNeighbors neighbors;
+        if (!FindSvoNodeNeighbors(job->svo, grid->chunkLevel, cc, &node, &neighbors)) {
+            continue;
+        }
+        
+        for (int lod = 0; lod < grid->lodCount; lod++) {
+            SvoMeshRegionOutput* output = &outputs[lod];
+            output->firstVertex = mesh->vertexCount;
+            output->firstIndex = mesh->indexCount;
+            output->firstCluster = mesh->clusterCount;
+            
+            SvoMeshStats lodStats = {};
+            int meshLevel = grid->lvl - lod;
+            int size = grid->chunkSize >> lod;
+            Vector3Int origin = { cc.x * size, cc.y * size, cc.z * size };
+            bool occupancy = grid->mesher == SvoMesher_SurfaceNets || grid->ambientOcclusion || grid->exterior || grid->shareRepeats;
+            if (occupancy) {
+                FillSvoOccupancy(scratch, job->svo, meshLevel, grid->chunkLevel, cc, size, lod == 0, grid->exterior, grid->solidSubtrees);
+            }
+            if (grid->shareRepeats) {
+                u32 index = item * grid->lodCount + lod;
+                job->hashes[index] = HashSvoOccupancy(scratch, size);
+                if (!ClaimSvoChunkMesh(&job->repeats, job->hashes[index], index)) {
+                    continue;
+                }
+                origin = Vector3Int{ 0, 0, 0 };
+            }
+            
+            if (grid->mesher == SvoMesher_SurfaceNets) {
+                MeshSvoRegionSurfaceNets(scratch, origin, size, SVO_MESH_NET_PRECISION - grid->lvl + lod, mesh, &lodStats, output->faceIndexCounts);
+            } else if (occupancy) {
+                MeshSvoRegionOccupancy(scratch, origin, size, lod, grid->ambientOcclusion, mesh, &lodStats, output->faceIndexCounts);
+            } else {
+                SvoNodeNeighbors alone;
+                memset(&alone, 0xFF, sizeof(alone));
+                SvoLeafIterator leaves;
+                BeginSvoLeaves(&leaves, job->svo, meshLevel, grid->chunkLevel, node, cc, (lod == 0) ? &neighbors : &alone);
+                if (grid->solidSubtrees) {
+                    WalkSvoSolidLeaves(&leaves, SvoSolidWalk_Boundary);
+                }
+                MeshSvoRegion(scratch, origin, size, &leaves, lod, mesh, &lodStats, output->faceIndexCounts);
+            }
+            if (grid->shareVertices) {
+                ShareSvoVertices(mesh, output->firstVertex, output->firstIndex);
+            }
+            if (grid->optimizeVertexCache) {
+                OptimizeSvoVertexCache(mesh, output->firstVertex, output->firstIndex, output->faceIndexCounts);
+            }
+            BuildSvoMeshClusters(mesh, output->firstIndex, output->faceIndexCounts, unit);
+            
+            if (lod == 0) {
+                stats->faceCount += lodStats.faceCount;
+                stats->quadCount += lodStats.quadCount;
+            }
+            stats->lodQuadCounts[lod] += lodStats.quadCount;
+            
+            output->vertexCount = mesh->vertexCount - output->firstVertex;
+            output->indexCount = mesh->indexCount - output->firstIndex;
+            output->clusterCount = mesh->clusterCount - output->firstCluster;
+        }
+    }
+    
+    TempArenaMemoryEnd(tempArena);
+}
+
+void SvoMeshThreadProc(void* data) {
+    InitTempAllocator(MEGABYTES(16));
+    MeshSvoRegions((SvoMeshThread*)data);
+    FreeTempAllocator();
+}
+
+// Copies chunk meshes from the thread segments to the ranges the prefix sum gave them, rebasing the indices to the
+// chunk's first vertex, and frees every segment once its chunks are copied. Clusters are relative to their chunk mesh
+// already. The ranges do not overlap, so any thread can copy any segment.
+void CopySvoMeshSegments(SvoMeshThread* meshThread) {
+    SvoMeshJob* job = meshThread->job;
+    SvoMeshBuffer* mesh = job->output;
+    
+    for (;;) {
+        s32 item = AtomicAdd(&job->nextSegment, 1);
+        if (item >= (s32)job->segmentCount) {
+            break;
+        }
+        
+        SvoMeshBuffer* segment = job->segments[item];
+        for (u32 i = job->segmentFirstOutput[item]; i < job->segmentFirstOutput[item + 1]; i++) {
+            SvoMeshRegionOutput* output = &job->outputs[job->segmentOutputs[i]];
+            SvoChunkMesh* chunkMesh = output->chunkMesh;
+            memcpy(mesh->vertices + (chunkMesh->firstVertex - mesh->vertexBase), segment->vertices + output->firstVertex, 
+                   output->vertexCount * sizeof(Vertex_Voxel));
+            memcpy(mesh->clusters + (chunkMesh->firstCluster - mesh->clusterBase), segment->clusters + output->firstCluster, 
+                   output->clusterCount * sizeof(SvoMeshCluster));
+        
+            u32* src = segment->indices + output->firstIndex;
+            if (chunkMesh->indexFormat == IndexFormat_U16) {
+                u16* dest = mesh->shortIndices + (chunkMesh->firstIndex - mesh->shortIndexBase);
+                for (u32 j = 0; j < output->indexCount; j++) {
+                    dest[j] = (u16)(src[j] - output->firstVertex);
+                }
+            } else {
+                u32* dest = mesh->indices + (chunkMesh->firstIndex - mesh->indexBase);
+                for (u32 j = 0; j < output->indexCount; j++) {
+                    dest[j] = src[j] - output->firstVertex;
+                }
+            }
+        }
+        FreeSvoMeshBuffer(segment);
+    }
+}
+
+void SvoCopyThreadProc(void* data) {
+    CopySvoMeshSegments((SvoMeshThread*)data);
+}
+
+// Runs work on threadCount threads, the calling thread being the first.
+void RunSvoMeshThreads(SvoMeshJob* job, int threadCount, ThreadFunc threadProc, void (*work)(SvoMeshThread*)) {
+    TempArenaMemory tempArena = TempArenaMemoryBegin(&tempAllocator);
+    
+    SvoMeshThread* meshThreads = ALLOC_ARRAY(TempAllocator, SvoMeshThread, threadCount);
+    ThreadHandle* threads = ALLOC_ARRAY(TempAllocator, ThreadHandle, threadCount);
+    for (int i = 0; i < threadCount; i++) {
+        meshThreads[i] = { job, i };
+    }
+    for (int i = 1; i < threadCount; i++) {
+        threads[i] = StartThread(threadProc, &meshThreads[i]);
+    }
+    work(&meshThreads[0]);
+    for (int i = 1; i < threadCount; i++) {
+        JoinThread(threads[i]);
+    }
+    
+    TempArenaMemoryEnd(tempArena);
+}
+
+// Meshes every LOD of the given chunks and appends them to mesh in list order, setting the ranges of every chunk. 
+// Indices are relative to the chunk mesh's first vertex, so meshes with up to SVO_MESH_MAX_SHORT_VERTICES vertices 
+// get u16 indices in mesh->shortIndices and only bigger ones need u32 indices.
+// This is done in two passes over threadCount threads (the calling thread included). The first meshes the chunks
+// into per-thread segments, after which the exact size of the output and the place of every chunk in it are known,
+// see SvoMeshBuffer::reserve. The second copies the chunks to those places, so the output is the same for any 
+// thread count, and frees every segment as soon as it is copied. Returns false, leaving mesh and the chunks 
+// untouched, if the result does not fit.
+// When the grid shares repeats the first pass hashes the occupancy of every chunk LOD before meshing it, and only
+// the first thread to claim a hash meshes it, see ClaimSvoChunkMesh(). The chunks outside the list must have their 
+// meshes in mesh then, meshed with the same settings, as the ones that are not remeshed after an edit do.
+bool MeshSvoChunks(SvoImport* svo, SvoChunkGrid* grid, u32* chunks, u32 chunkCount, int threadCount, 
+                   SvoMeshBuffer* mesh, SvoMeshStats* stats) {
+    ASSERT_ERROR(threadCount > 0, "Invalid thread count %d.", threadCount);
+    ASSERT_ERROR(grid->lvl <= svo->topLevel, "Cannot mesh level %d of a SVO with %d levels.", grid->lvl, svo->topLevel);
+    TempArenaMemory tempArena = TempArenaMemoryBegin(&tempAllocator);
+    
+    SvoMeshJob job = {};
+    job.svo = svo;
+    job.grid = grid;
+    job.chunks = chunks;
+    job.chunkCount = chunkCount;
+    u32 outputCount = chunkCount * grid->lodCount;
+    job.outputs = ALLOC_ARRAY(TempAllocator, SvoMeshRegionOutput, outputCount);
+    job.output = mesh;
+    job.threadSegments = ALLOC_ARRAY(TempAllocator, SvoMeshSegments, threadCount);
+    job.threadStats = ALLOC_ARRAY(TempAllocator, SvoMeshStats, threadCount);
+    memset(job.threadSegments, 0, threadCount * sizeof(SvoMeshSegments));
+    memset(job.threadStats, 0, threadCount * sizeof(SvoMeshStats));
+    if (grid->mesher == SvoMesher_SurfaceNets && !svoNetCellsReady) {
+        InitSvoNetCells();
+    }
+    
+    if (grid->shareRepeats) {
+        job.hashes = ALLOC_ARRAY(TempAllocator, u64, outputCount);
+        memset(job.hashes, 0, outputCount * sizeof(u64));
+        InitSvoRepeatTable(&job.repeats, grid, chunks, chunkCount);
+    }
+    
+    RunSvoMeshThreads(&job, threadCount, SvoMeshThreadProc, MeshSvoRegions);
+    
+    u32 vertexCount = 0;
+    u32 indexCount = 0;
+    u32 shortIndexCount = 0;
+    u32 clusterCount = 0;
+    for (u32 i = 0; i < outputCount; i++) {
+        vertexCount += job.outputs[i].vertexCount;
+        clusterCount += job.outputs[i].clusterCount;
+        if (job.outputs[i].vertexCount <= SVO_MESH_MAX_SHORT_VERTICES) {
+            shortIndexCount += job.outputs[i].indexCount;
+        } else {
+            indexCount += job.outputs[i].indexCount;
+        }
+    }
+    
+    ZeroStruct(stats);
+    stats->vertexCount = vertexCount;
+    stats->indexCount = indexCount;
+    stats->shortIndexCount = shortIndexCount;
+    stats->clusterCount = clusterCount;
+    
+    bool fits = mesh->reserve ? mesh->reserve(mesh, vertexCount, indexCount, shortIndexCount, clusterCount) : true;
+    fits = fits && mesh->vertexCount + vertexCount <= mesh->vertexCapacity && 
+                   mesh->indexCount + indexCount <= mesh->indexCapacity &&
+                   mesh->shortIndexCount + shortIndexCount <= mesh->shortIndexCapacity &&
+                   mesh->clusterCount + clusterCount <= mesh->clusterCapacity;
+    if (fits) {
+        // Prefix sum over the chunks gives every chunk its place in the output, independent of which thread meshed it.
+        SvoChunkMesh** chunkMeshes = ALLOC_ARRAY(TempAllocator, SvoChunkMesh*, outputCount);
+        for (u32 i = 0; i < outputCount; i++) {
+            SvoMeshRegionOutput* output = &job.outputs[i];
+            SvoChunk* chunk = &grid->chunks[chunks[i / grid->lodCount]];
+            SvoChunkMesh* chunkMesh = &chunk->lods[i % grid->lodCount];
+            chunk->dirty = false;
+            
+            // With shared repeats the first output in list order with a hash takes the mesh of the one that claimed
+            // it, and every later one takes the same ranges, as does every output with the hash of a chunk that is
+            // not remeshed. Outputs that carry no mesh keep chunkMesh 0 and are not copied.
+            u64 hash = job.hashes ? job.hashes[i] : 0;
+            if (hash != 0) {
+                u32 slot = FindSvoRepeatSlot(&job.repeats, hash);
+                u32 source = job.repeats.meshes[slot];
+                if (source != SVO_REPEAT_NO_MESH) {
+                    u32 existing = source - outputCount;
+                    *chunkMesh = (source < outputCount) ? *chunkMeshes[source] : 
+                                                          grid->chunks[existing / grid->lodCount].lods[existing % grid->lodCount];
+                    chunkMeshes[i] = chunkMesh;
+                    stats->sharedCount++;
+                    continue;
+                }
+                job.repeats.meshes[slot] = i;
+                output = &job.outputs[job.repeats.claimers[slot]];
+            }
+            output->chunkMesh = chunkMesh;
+            chunkMeshes[i] = chunkMesh;
+            
+            if (output->vertexCount <= SVO_MESH_MAX_SHORT_VERTICES) {
+                chunkMesh->indexFormat = IndexFormat_U16;
+                chunkMesh->firstIndex = mesh->shortIndexCount;
+                mesh->shortIndexCount += output->indexCount;
+            } else {
+                chunkMesh->indexFormat = IndexFormat_U32;
+                chunkMesh->firstIndex = mesh->indexCount;
+                mesh->indexCount += output->indexCount;
+            }
+            
+            chunkMesh->firstVertex = mesh->vertexCount;
+            chunkMesh->vertexCount = output->vertexCount;
+            chunkMesh->indexCount = output->indexCount;
+            memcpy(chunkMesh->faceIndexCounts, output->faceIndexCounts, sizeof(chunkMesh->faceIndexCounts));
+            chunkMesh->firstCluster = mesh->clusterCount;
+            chunkMesh->clusterCount = output->clusterCount;
+            chunkMesh->hash = hash;
+            mesh->vertexCount += output->vertexCount;
+            mesh->clusterCount += output->clusterCount;
+        }
+        
+        // Counting sort of the outputs to copy by the segment that holds them.
+        u32* threadFirstSegment = ALLOC_ARRAY(TempAllocator, u32, threadCount);
+        for (int i = 0; i < threadCount; i++) {
+            threadFirstSegment[i] = job.segmentCount;
+            job.segmentCount += job.threadSegments[i].count;
+        }
+        job.segments = ALLOC_ARRAY(TempAllocator, SvoMeshBuffer*, job.segmentCount);
+        job.segmentFirstOutput = ALLOC_ARRAY(TempAllocator, u32, job.segmentCount + 1);
+        job.segmentOutputs = ALLOC_ARRAY(TempAllocator, u32, outputCount);
+        memset(job.segmentFirstOutput, 0, (job.segmentCount + 1) * sizeof(u32));
+        for (int i = 0; i < threadCount; i++) {
+            for (int j = 0; j < job.threadSegments[i].count; j++) {
+                job.segments[threadFirstSegment[i] + j] = &job.threadSegments[i].buffers[j];
+            }
+        }
+        for (u32 i = 0; i < outputCount; i++) {
+            if (job.outputs[i].chunkMesh) {
+                job.segmentFirstOutput[threadFirstSegment[job.outputs[i].thread] + job.outputs[i].segment + 1]++;
+            }
+        }
+        for (u32 i = 0; i < job.segmentCount; i++) {
+            job.segmentFirstOutput[i + 1] += job.segmentFirstOutput[i];
+        }
+        u32* segmentEnds = ALLOC_ARRAY(TempAllocator, u32, job.segmentCount);
+        memcpy(segmentEnds, job.segmentFirstOutput, job.segmentCount * sizeof(u32));
+        for (u32 i = 0; i < outputCount; i++) {
+            if (job.outputs[i].chunkMesh) {
+                job.segmentOutputs[segmentEnds[threadFirstSegment[job.outputs[i].thread] + job.outputs[i].segment]++] = i;
+            }
+        }
+        
+        // A thread per 64K vertices, copying a handful of remeshed chunks is not worth starting threads for.
+        int copyThreadCount = Min(threadCount, (int)(vertexCount / 65536) + 1);
+        RunSvoMeshThreads(&job, copyThreadCount, SvoCopyThreadProc, CopySvoMeshSegments);
+    }
+    
+    for (int i = 0; i < threadCount; i++) {
+        stats->faceCount += job.threadStats[i].faceCount;
+        stats->quadCount += job.threadStats[i].quadCount;
+        for (int lod = 0; lod < grid->lodCount; lod++) {
+            stats->lodQuadCounts[lod] += job.threadStats[i].lodQuadCounts[lod];
+        }
+        for (int j = 0; j < job.threadSegments[i].count; j++) {
+            FreeSvoMeshBuffer(&job.threadSegments[i].buffers[j]);
+        }
+        HeapAllocator.free(job.threadSegments[i].buffers);
+    }
+    
+    TempArenaMemoryEnd(tempArena);
+    return fits;
+}
+
+// Meshes every chunk of the grid into mesh.
+bool MeshSvo(SvoImport* svo, SvoChunkGrid* grid, int threadCount, SvoMeshBuffer* mesh, SvoMeshStats* stats) {
+    TempArenaMemory tempArena = TempArenaMemoryBegin(&tempAllocator);
+    
+    u32* chunks = ALLOC_ARRAY(TempAllocator, u32, grid->chunkCount);
+    for (u32 i = 0; i < grid->chunkCount; i++) {
+        chunks[i] = i;
+    }
+    bool fits = MeshSvoChunks(svo, grid, chunks, grid->chunkCount, threadCount, mesh, stats);
+    
+    TempArenaMemoryEnd(tempArena);
+    return fits;
+}
+
+// Meshes the dirty chunks of the grid into mesh. Returns the number of chunks that were remeshed, 
+// or -1 if they do not fit, in which case nothing was written.
+int RemeshDirtySvoChunks(SvoImport* svo, SvoChunkGrid* grid, int threadCount, SvoMeshBuffer* mesh, SvoMeshStats* stats) {
+    TempArenaMemory tempArena = TempArenaMemoryBegin(&tempAllocator);
+    
+    u32* chunks = ALLOC_ARRAY(TempAllocator, u32, grid->chunkCount);
+    u32 dirtyCount = 0;
+    for (u32 i = 0; i < grid->chunkCount; i++) {
+        if (grid->chunks[i].dirty) {
+            chunks[dirtyCount++] = i;
+        }
+    }
+    
+    int result = 0;
+    if (dirtyCount > 0) {
+        result = MeshSvoChunks(svo, grid, chunks, dirtyCount, threadCount, mesh, stats) ? (int)dirtyCount : -1;
+    }
+    
+    TempArenaMemoryEnd(tempArena);
+    return result;
+}
+
+// Staging bytes uploaded per frame, a repack of a big model takes a few frames instead of one long one.
+#define SVO_MESH_UPLOAD_SLICE_BYTES MEGABYTES(4)
+
+// Empties a staging buffer so that it holds what is appended after the counts of target, or the whole mesh without
+// target. The arrays are kept for the next remesh.
+void ResetSvoMeshStaging(SvoMeshBuffer* staging, SvoMeshBuffer* target) {
+    SvoMeshBuffer base = {};
+    if (target) {
+        base = *target;
+    }
+    staging->vertexCapacity += base.vertexCount - staging->vertexBase;
+    staging->indexCapacity += base.indexCount - staging->indexBase;
+    staging->shortIndexCapacity += base.shortIndexCount - staging->shortIndexBase;
+    staging->clusterCapacity += base.clusterCount - staging->clusterBase;
+    staging->vertexBase = staging->vertexCount = base.vertexCount;
+    staging->indexBase = staging->indexCount = base.indexCount;
+    staging->shortIndexBase = staging->shortIndexCount = base.shortIndexCount;
+    staging->clusterBase = staging->clusterCount = base.clusterCount;
+}
+
+// Copies the next part of what a staging buffer holds into mesh at the same place, at most maxBytes of it. The counts
+// of mesh say how far earlier calls got, they start at the bases of the staging buffer. Vertices go first, then u16
+// indices, u32 indices and clusters. Returns true once mesh has everything and the counts of the staging buffer.
+bool CopySvoMeshStagingSlice(SvoMeshBuffer* staging, SvoMeshBuffer* mesh, u32 maxBytes) {
+    ASSERT_ERROR(mesh->vertexCount >= staging->vertexBase && mesh->indexCount >= staging->indexBase && 
+                 mesh->shortIndexCount >= staging->shortIndexBase && mesh->clusterCount >= staging->clusterBase, 
+                 "The staging buffer was not meshed for the end of this mesh.");
+    ASSERT_ERROR(staging->vertexCount <= mesh->vertexCapacity && staging->indexCount <= mesh->indexCapacity && 
+                 staging->shortIndexCount <= mesh->shortIndexCapacity && staging->clusterCount <= mesh->clusterCapacity, 
+                 "The staging buffer does not fit in the mesh.");
+    
+    u32 vertexCount = Min(staging->vertexCount - mesh->vertexCount, maxBytes / (u32)sizeof(Vertex_Voxel));
+    memcpy(mesh->vertices + mesh->vertexCount, staging->vertices + (mesh->vertexCount - staging->vertexBase), vertexCount * sizeof(Vertex_Voxel));
+    mesh->vertexCount += vertexCount;
+    maxBytes -= vertexCount * (u32)sizeof(Vertex_Voxel);
+    
+    u32 shortIndexCount = Min(staging->shortIndexCount - mesh->shortIndexCount, maxBytes / (u32)sizeof(u16));
+    memcpy(mesh->shortIndices + mesh->shortIndexCount, staging->shortIndices + (mesh->shortIndexCount - staging->shortIndexBase), 
+           shortIndexCount * sizeof(u16));
+    mesh->shortIndexCount += shortIndexCount;
+    maxBytes -= shortIndexCount * (u32)sizeof(u16);
+    
+    u32 indexCount = Min(staging->indexCount - mesh->indexCount, maxBytes / (u32)sizeof(u32));
+    memcpy(mesh->indices + mesh->indexCount, staging->indices + (mesh->indexCount - staging->indexBase), indexCount * sizeof(u32));
+    mesh->indexCount += indexCount;
+    maxBytes -= indexCount * (u32)sizeof(u32);
+    
+    u32 clusterCount = Min(staging->clusterCount - mesh->clusterCount, maxBytes / (u32)sizeof(SvoMeshCluster));
+    memcpy(mesh->clusters + mesh->clusterCount, staging->clusters + (mesh->clusterCount - staging->clusterBase), 
+           clusterCount * sizeof(SvoMeshCluster));
+    mesh->clusterCount += clusterCount;
+    
+    return mesh->vertexCount == staging->vertexCount && mesh->shortIndexCount == staging->shortIndexCount && 
+           mesh->indexCount == staging->indexCount && mesh->clusterCount == staging->clusterCount;
+}
+
+// Defined in svo_instances.cpp, which needs the mesher.
+struct SvoInstanceBuffer;
+void BuildSvoInstances(SvoImport* svo, SvoChunkGrid* grid, SvoInstanceBuffer* buffer);
+
+// Remeshing on a worker thread, so that neither edits nor new mesh settings stall the frame. BeginSvoRemesh() copies
+// the grid, chunks included, and StartSvoRemesh() meshes the copy into CPU staging buffers while the caller keeps
+// drawing the old meshes with the old ranges. Once SvoRemeshDone() the caller uploads the staging buffers, in slices
+// of SVO_MESH_UPLOAD_SLICE_BYTES over several frames if need be, see CopySvoMeshStagingSlice(), and takes the chunks
+// and settings of the copy over with FinishSvoRemesh() before the next frame with the new meshes. The meshes that are
+// drawn so always match the ranges and settings they were meshed with.
+// The SVO must not change while a remesh runs and the exterior of the copy belongs to it, reading the SVO is fine.
+// The worker thread and its temp allocator are started with the first remesh and kept until FreeSvoRemesh(), every 
+// later one only wakes it up.
+struct SvoRemesh {
+    SvoImport* svo;
+    SvoChunkGrid grid;      // the copy, the caller can change its settings before StartSvoRemesh()
+    u32 chunkCapacity;
+    bool repack;            // every chunk into an empty mesh, otherwise the dirty ones are appended to the target
+    bool flood;             // floods the exterior of the copy first, which also marks the chunks whose cavities changed
+    SvoMeshBuffer target;   // counts and capacities of the mesh the result goes to, its arrays are not used
+    SvoMeshBuffer staging;
+    SvoInstanceBuffer* instances;  // rebuilt from the copy after meshing when set, see BuildSvoInstances()
+    SvoMeshStats stats;
+    int remeshed;           // chunks, all of them for a repack
+    double floodTime;
+    double meshTime;
+    double instanceTime;
+    bool running;
+    volatile s32 done;
+    volatile s32 quit;
+    bool threadStarted;
+    ThreadHandle thread;
+    Semaphore start;        // signalled for every remesh, and once more to quit
+    Semaphore finished;     // signalled after every remesh, FinishSvoRemesh() waits for it
+};
+
+void RunSvoRemesh(SvoRemesh* remesh, int threadCount) {
+    double start = CurrentTimeInSeconds();
+    if (remesh->flood) {
+        UpdateSvoExterior(remesh->svo, &remesh->grid, remesh->grid.exterior);
+    }
+    remesh->floodTime = CurrentTimeInSeconds() - start;
+    
+    start = CurrentTimeInSeconds();
+    if (!remesh->repack) {
+        remesh->remeshed = RemeshDirtySvoChunks(remesh->svo, &remesh->grid, threadCount, &remesh->staging, &remesh->stats);
+        
+        // Appended chunks that do not fit after the target turn into a repack, like a full GPU buffer does.
+        SvoMeshBuffer* staging = &remesh->staging;
+        SvoMeshBuffer* target = &remesh->target;
+        if (staging->vertexCount > target->vertexCapacity || staging->indexCount > target->indexCapacity ||
+            staging->shortIndexCount > target->shortIndexCapacity || staging->clusterCount > target->clusterCapacity) {
+            remesh->repack = true;
+        }
+    }
+    if (remesh->repack) {
+        ResetSvoMeshStaging(&remesh->staging, 0);
+        MeshSvo(remesh->svo, &remesh->grid, threadCount, &remesh->staging, &remesh->stats);
+        remesh->remeshed = (int)remesh->grid.chunkCount;
+    }
+    remesh->meshTime = CurrentTimeInSeconds() - start;
+    
+    // After the flood, the instances leave out the cavities the same way the meshes do.
+    start = CurrentTimeInSeconds();
+    if (remesh->instances) {
+        BuildSvoInstances(remesh->svo, &remesh->grid, remesh->instances);
+    }
+    remesh->instanceTime = CurrentTimeInSeconds() - start;
+}
+
+void SvoRemeshThreadProc(void* data) {
+    // The flood and the job arrays of every chunk need as much as on the main thread.
+    InitTempAllocator();
+    SvoRemesh* remesh = (SvoRemesh*)data;
+    int threadCount = Max(1, GetProcessorCount() - 1);
+    
+    for (;;) {
+        WaitSemaphore(remesh->start);
+        if (remesh->quit) {
+            break;
+        }
+        RunSvoRemesh(remesh, threadCount);
+        AtomicAdd(&remesh->done, 1);
+        SignalSemaphore(remesh->finished);
+    }
+    
+    FreeTempAllocator();
+}
+
+// Copies grid for a remesh of its dirty chunks, appended after the counts of target, or with repack of all of them.
+// Nothing runs until StartSvoRemesh().
+void BeginSvoRemesh(SvoRemesh* remesh, SvoImport* svo, SvoChunkGrid* grid, SvoMeshBuffer* target, bool repack) {
+    ASSERT_ERROR(!remesh->running, "A remesh is running already.");
+    if (remesh->chunkCapacity < grid->chunkCount) {
+        HeapAllocator.free(remesh->grid.chunks);
+        remesh->chunkCapacity = grid->chunkCount;
+        remesh->grid.chunks = ALLOC_ARRAY(HeapAllocator, SvoChunk, remesh->chunkCapacity);
+    }
+    SvoChunk* chunks = remesh->grid.chunks;
+    remesh->grid = *grid;
+    remesh->grid.chunks = chunks;
+    memcpy(chunks, grid->chunks, grid->chunkCount * sizeof(SvoChunk));
+    
+    remesh->svo = svo;
+    remesh->repack = repack;
+    remesh->flood = false;
+    remesh->instances = 0;
+    remesh->target = *target;
+    remesh->staging.reserve = GrowSvoMeshBuffer;
+    ResetSvoMeshStaging(&remesh->staging, repack ? 0 : target);
+}
+
+void StartSvoRemesh(SvoRemesh* remesh) {
+    if (!remesh->threadStarted) {
+        remesh->start = InitSemaphore();
+        remesh->finished = InitSemaphore();
+        remesh->thread = StartThread(SvoRemeshThreadProc, remesh);
+        remesh->threadStarted = true;
+    }
+    remesh->done = 0;
+    remesh->running = true;
+    SignalSemaphore(remesh->start);
+}
+
+bool SvoRemeshDone(SvoRemesh* remesh) {
+    return remesh->running && remesh->done != 0;
+}
+
+// Waits for the remesh and replaces the chunks and settings of grid with those of the copy, keeping the LODs 
+// SelectSvoChunkLods() picked. The staging buffers have to be uploaded before grid is drawn again.
+void FinishSvoRemesh(SvoRemesh* remesh, SvoChunkGrid* grid) {
+    ASSERT_ERROR(remesh->running, "No remesh is running.");
+    WaitSemaphore(remesh->finished);
+    remesh->running = false;
+    
+    SvoChunk* chunks = grid->chunks;
+    for (u32 i = 0; i < grid->chunkCount; i++) {
+        int lod = chunks[i].lod;
+        chunks[i] = remesh->grid.chunks[i];
+        chunks[i].lod = lod;
+    }
+    *grid = remesh->grid;
+    grid->chunks = chunks;
+}
+
+// Lets a running remesh finish, then stops the worker thread. The instances belong to the caller.
+void FreeSvoRemesh(SvoRemesh* remesh) {
+    if (remesh->threadStarted) {
+        remesh->quit = 1;
+        SignalSemaphore(remesh->start);
+        JoinThread(remesh->thread);
+        FreeSemaphore(remesh->start);
+        FreeSemaphore(remesh->finished);
+    }
+    HeapAllocator.free(remesh->grid.chunks);
+    FreeSvoMeshBuffer(&remesh->staging);
+    ZeroStruct(remesh);
+}
+
+struct SvoChunkDistance {
+    u32 chunk;
+    float distance;
+};
+
+int CompareSvoChunkDistanceFarFirst(const void* a, const void* b) {
+    float x = ((const SvoChunkDistance*)a)->distance;
+    float y = ((const SvoChunkDistance*)b)->distance;
+    return (x < y) - (x > y);
+}
+
+// Quads of every LOD, what a CPU side output buffer needs room for.
+u32 SvoMeshTotalQuads(SvoMeshStats* stats) {
+    u32 quadCount = 0;
+    for (int lod = 0; lod < SVO_MESH_MAX_LODS; lod++) {
+        quadCount += stats->lodQuadCounts[lod];
+    }
+    return quadCount;
+}
+
+u32 SvoChunkTriangles(SvoChunk* chunk) {
+    return chunk->lods[chunk->lod].indexCount / 3;
+}
+
+// Picks the LOD of every chunk from the distance between its center and the camera: LOD 0 up to lodDistance, 
+// then one LOD coarser every time the distance doubles. If that is more than triangleBudget triangles, chunks are 
+// made coarser one LOD at a time, farthest first, until it fits or no chunk gets smaller by going coarser.
+// Returns the number of triangles drawn with the selected LODs.
+u32 SelectSvoChunkLods(SvoChunkGrid* grid, Vector3 camera, float lodDistance, u32 triangleBudget) {
+    TempArenaMemory tempArena = TempArenaMemoryBegin(&tempAllocator);
+    
+    float chunkScale = grid->rootScale / grid->chunksPerAxis;
+    SvoChunkDistance* order = ALLOC_ARRAY(TempAllocator, SvoChunkDistance, grid->chunkCount);
+    u32 triangles = 0;
+    for (u32 i = 0; i < grid->chunkCount; i++) {
+        Vector3Int cc = SvoChunkCoord(grid, i);
+        Vector3 center = { (cc.x + 0.5f) * chunkScale, (cc.y + 0.5f) * chunkScale, (cc.z + 0.5f) * chunkScale };
+        float distance = Magnitude(center - camera);
+        
+        int lod = 0;
+        for (float d = lodDistance; distance > d && lod < grid->lodCount - 1; d *= 2) {
+            lod++;
+        }
+        
+        SvoChunk* chunk = &grid->chunks[i];
+        chunk->lod = lod;
+        triangles += SvoChunkTriangles(chunk);
+        order[i] = { i, distance };
+    }
+    
+    if (triangles > triangleBudget) {
+        qsort(order, grid->chunkCount, sizeof(SvoChunkDistance), CompareSvoChunkDistanceFarFirst);
+        
+        bool coarsened = true;
+        while (triangles > triangleBudget && coarsened) {
+            coarsened = false;
+            for (u32 i = 0; i < grid->chunkCount && triangles > triangleBudget; i++) {
+                // Skirts can make a coarser LOD of a flat chunk bigger, those are left alone.
+                SvoChunk* chunk = &grid->chunks[order[i].chunk];
+                if (chunk->lod < grid->lodCount - 1 && chunk->lods[chunk->lod + 1].indexCount < chunk->lods[chunk->lod].indexCount) {
+                    triangles -= SvoChunkTriangles(chunk);
+                    chunk->lod++;
+                    triangles += SvoChunkTriangles(chunk);
+                    coarsened = true;
+                }
+            }
+        }
+    }
+    
+    TempArenaMemoryEnd(tempArena);
+    return triangles;
+}
+
+// The 6 planes of a view frustum, a point p is inside a plane when dot(plane.xyz, p) + plane.w >= 0.
+struct SvoFrustum {
+    Vector4 planes[6];
+};
+
+// Planes of viewProjection, a row vector matrix with D3D clip space where 0 <= z <= w.
+SvoFrustum SvoFrustumFromMatrix(Matrix4 viewProjection) {
+    Matrix4& m = viewProjection;
+    Vector4 column[4];
+    for (int j = 0; j < 4; j++) {
+        column[j] = Vector4{ m.m[0][j], m.m[1][j], m.m[2][j], m.m[3][j] };
+    }
+    
+    SvoFrustum frustum;
+    frustum.planes[0] = column[3] + column[0];  // left
+    frustum.planes[1] = column[3] - column[0];  // right
+    frustum.planes[2] = column[3] + column[1];  // bottom
+    frustum.planes[3] = column[3] - column[1];  // top
+    frustum.planes[4] = column[2];              // near
+    frustum.planes[5] = column[3] - column[2];  // far
+    return frustum;
+}
+
+// False when the box is completely outside one of the planes. Conservative: boxes near a frustum corner can pass.
+bool SvoBoxInFrustum(SvoFrustum* frustum, Vector3 min, Vector3 max) {
+    for (int i = 0; i < 6; i++) {
+        Vector4 plane = frustum->planes[i];
+        Vector3 p = { (plane.x >= 0) ? max.x : min.x, (plane.y >= 0) ? max.y : min.y, (plane.z >= 0) ? max.z : min.z };
+        if (plane.x * p.x + plane.y * p.y + plane.z * p.z + plane.w < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// True when every triangle of the cluster faces away from the camera. For a direction q from the camera to a point 
+// of the cluster, every normal within the cone points away if the angle between q and the axis is less than 
+// 90 degrees minus the cone's angle, which is dot(q, axis) >= coneCutoff * |q|. The left side is bounded from below
+// over the whole box and |q| from above with the box's bounding sphere.
+bool SvoClusterFacesAway(SvoMeshCluster* cluster, Vector3 camera) {
+    Vector3 center = (cluster->min + cluster->max) * 0.5f;
+    Vector3 extent = (cluster->max - cluster->min) * 0.5f;
+    Vector3 axis = cluster->coneAxis;
+    Vector3 toCenter = center - camera;
+    float nearest = DotProduct(toCenter, axis) - (Abs(axis.x) * extent.x + Abs(axis.y) * extent.y + Abs(axis.z) * extent.z);
+    return nearest >= cluster->coneCutoff * (Magnitude(toCenter) + Magnitude(extent));
+}
+
+// A range of the index buffer of indexFormat to draw with DrawIndexedVertices(). chunk is the one it was culled for,
+// which only matters for where it is drawn when the grid shares repeats, see BatchSvoDrawRanges().
+struct SvoDrawRange {
+    IndexBufferFormat indexFormat;
+    u32 firstIndex;
+    u32 indexCount;
+    u32 firstVertex;
+    u32 chunk;
+};
+
+// How much CullSvoClusters() culls, every level also does what the ones before it do.
+enum SvoCullMode {
+    SvoCull_None,        // every chunk mesh of the drawn LODs
+    SvoCull_Directions,  // the direction buckets of a chunk that face away from the camera, see SvoVisibleFaces()
+    SvoCull_Clusters,    // clusters outside the frustum or facing away
+    SvoCull_Count,
+};
+
+struct SvoCullStats {
+    u32 clusterCount;       // clusters of the drawn LODs
+    u32 triangleCount;      // triangles of the drawn LODs
+    u32 directionTriangles; // culled as in a direction bucket facing away from the camera
+    u32 frustumTriangles;   // culled as outside the frustum
+    u32 backfaceTriangles;  // culled as facing away from the camera
+    u32 drawnClusterCount;
+    u32 drawCount;          // ranges the drawn clusters were merged into
+};
+
+// A bit per SvoFaceDirection that can face the camera somewhere in the box. Faces pointing to +x lie on planes 
+// past min.x, so when the camera is not past it they all face away, and so on. Outside the box this rejects up to 
+// 3 directions, inside it none.
+u32 SvoVisibleFaces(Vector3 min, Vector3 max, Vector3 camera) {
+    u32 faces = (1 << SvoFace_Count) - 1;
+    float minAxis[3] = { min.x, min.y, min.z };
+    float maxAxis[3] = { max.x, max.y, max.z };
+    float cameraAxis[3] = { camera.x, camera.y, camera.z };
+    for (int axis = 0; axis < 3; axis++) {
+        if (cameraAxis[axis] <= minAxis[axis]) {
+            faces &= ~(1 << (axis * 2));
+        }
+        if (cameraAxis[axis] >= maxAxis[axis]) {
+            faces &= ~(1 << (axis * 2 + 1));
+        }
+    }
+    return faces;
+}
+
+// Clusters of the meshes of every chunk for the current LODs that survive mode. Direction buckets are rejected 
+// per chunk from the chunk's box, without looking at their clusters' bounds. Neighboring survivors of the same 
+// chunk mesh are drawn as one range, so ranges needs room for one per cluster of the drawn LODs at most. 
+// Returns the number of ranges.
+u32 CullSvoClusters(SvoChunkGrid* grid, SvoMeshCluster* clusters, bool useLods, SvoCullMode mode, Vector3 camera, 
+                    SvoFrustum* frustum, SvoDrawRange* ranges, SvoCullStats* stats) {
+    ZeroStruct(stats);
+    float chunkScale = grid->rootScale / grid->chunksPerAxis;
+    float unit = SvoMeshUnit(grid);
+    u32 rangeCount = 0;
+    for (u32 i = 0; i < grid->chunkCount; i++) {
+        SvoChunk* chunk = &grid->chunks[i];
+        SvoChunkMesh* chunkMesh = &chunk->lods[useLods ? chunk->lod : 0];
+        stats->clusterCount += chunkMesh->clusterCount;
+        stats->triangleCount += chunkMesh->indexCount / 3;
+        
+        // The curved clusters of surface nets have no direction and are always kept.
+        u32 visibleFaces = (1 << (SvoFace_Count + 1)) - 1;
+        if (mode >= SvoCull_Directions) {
+            Vector3Int cc = SvoChunkCoord(grid, i);
+            Vector3 chunkMin = { cc.x * chunkScale, cc.y * chunkScale, cc.z * chunkScale };
+            Vector3 chunkMax = chunkMin + Vector3{ chunkScale, chunkScale, chunkScale };
+            visibleFaces = SvoVisibleFaces(chunkMin, chunkMax, camera) | (1 << SvoFace_Count);
+        }
+        
+        // Clusters of shared meshes are relative to the chunk.
+        Vector3Int meshOrigin = SvoChunkMeshOrigin(grid, i);
+        Vector3 offset = Vector3{ (float)meshOrigin.x, (float)meshOrigin.y, (float)meshOrigin.z } * unit;
+        
+        bool extending = false;
+        for (u32 c = 0; c < chunkMesh->clusterCount; c++) {
+            SvoMeshCluster moved = clusters[chunkMesh->firstCluster + c];
+            SvoMeshCluster* cluster = &moved;
+            cluster->min += offset;
+            cluster->max += offset;
+            bool culled = true;
+            if (!(visibleFaces & (1 << cluster->direction))) {
+                stats->directionTriangles += cluster->indexCount / 3;
+            } else if (mode >= SvoCull_Clusters && !SvoBoxInFrustum(frustum, cluster->min, cluster->max)) {
+                stats->frustumTriangles += cluster->indexCount / 3;
+            } else if (mode >= SvoCull_Clusters && SvoClusterFacesAway(cluster, camera)) {
+                stats->backfaceTriangles += cluster->indexCount / 3;
+            } else {
+                stats->drawnClusterCount++;
+                culled = false;
+            }
+            
+            if (culled) {
+                extending = false;
+            } else if (extending) {
+                ranges[rangeCount - 1].indexCount += cluster->indexCount;
+            } else {
+                ranges[rangeCount++] = { chunkMesh->indexFormat, chunkMesh->firstIndex + cluster->firstIndex, cluster->indexCount, chunkMesh->firstVertex, i };
+                extending = true;
+            }
+        }
+    }
+    stats->drawCount = rangeCount;
+    return rangeCount;
+}
+
+// The ranges of a shared mesh that CullSvoClusters() kept for several chunks, drawn as instances with the origins 
+// from firstInstance on.
+struct SvoDrawBatch {
+    SvoDrawRange range;
+    u32 firstInstance;
+    u32 instanceCount;
+};
+
+int CompareSvoDrawRanges(const void* a, const void* b) {
+    const SvoDrawRange* x = (const SvoDrawRange*)a;
+    const SvoDrawRange* y = (const SvoDrawRange*)b;
+    if (x->indexFormat != y->indexFormat) {
+        return (x->indexFormat < y->indexFormat) ? -1 : 1;
+    }
+    if (x->firstIndex != y->firstIndex) {
+        return (x->firstIndex < y->firstIndex) ? -1 : 1;
+    }
+    if (x->indexCount != y->indexCount) {
+        return (x->indexCount < y->indexCount) ? -1 : 1;
+    }
+    return (x->chunk > y->chunk) - (x->chunk < y->chunk);
+}
+
+// Sorts the ranges so the ones that draw the same indices are next to each other and makes a batch of each run.
+// origins gets the SvoChunkMeshOrigin() of every range's chunk in sorted order, one per instance. Without shared 
+// repeats every range is a batch of its own. Returns the number of batches, rangeCount at most.
+u32 BatchSvoDrawRanges(SvoChunkGrid* grid, SvoDrawRange* ranges, u32 rangeCount, SvoDrawBatch* batches, Instance_Offset* origins) {
+    qsort(ranges, rangeCount, sizeof(SvoDrawRange), CompareSvoDrawRanges);
+    
+    u32 batchCount = 0;
+    for (u32 i = 0; i < rangeCount; i++) {
+        SvoDrawRange* range = &ranges[i];
+        Vector3Int origin = SvoChunkMeshOrigin(grid, range->chunk);
+        origins[i] = { (u16)origin.x, (u16)origin.y, (u16)origin.z, 0 };
+        
+        SvoDrawBatch* last = (batchCount > 0) ? &batches[batchCount - 1] : 0;
+        if (last && last->range.indexFormat == range->indexFormat && last->range.firstIndex == range->firstIndex &&
+            last->range.indexCount == range->indexCount) {
+            last->instanceCount++;
+        } else {
+            batches[batchCount++] = { *range, i, 1 };
+        }
+    }
+    return batchCount;
+}
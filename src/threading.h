@@ -0,0 +1,39 @@
+#ifndef THREADING_H
+#define THREADING_H
+
+#include "utility.h"
+
+/* PLATFORM SPECIFIC */
+#if defined(_WIN32)
+    typedef void* ThreadHandle;
+#elif defined(__linux__)
+    typedef unsigned long ThreadHandle;
+#else
+    #error "Unsupported platform"
+#endif
+
+typedef void (*ThreadFunc)(void* data);
+
+// A counting semaphore that starts at 0, a sem_t on Linux.
+typedef void* Semaphore;
+
+// NOTE(roger): Threads do not get a temp allocator. Call InitTempAllocator() at the start of the thread 
+// function if it needs one and FreeTempAllocator() before returning.
+ThreadHandle StartThread(ThreadFunc func, void* data);
+void JoinThread(ThreadHandle thread);
+int GetProcessorCount();
+
+Semaphore InitSemaphore();
+void FreeSemaphore(Semaphore semaphore);
+// Adds one to the count, waking a thread that waits for it.
+void SignalSemaphore(Semaphore semaphore);
+// Waits until the count is above 0, then takes one off it.
+void WaitSemaphore(Semaphore semaphore);
+
+// Returns the value before the add.
+s32 AtomicAdd(volatile s32* value, s32 amount);
+
+// Sets value to exchange if it is comparand, returns the value it had before either way.
+u64 AtomicCompareExchange64(volatile u64* value, u64 exchange, u64 comparand);
+
+#endif //THREADING_H